@@ -0,0 +1,284 @@
+/****************************************************************
+* Author: Leo Carroll
+* Description:
+*	Filters that answer "definitely not present" for author names
+*	and titles without a probe of the catalog itself.
+*
+*	BlockedBloomFilter keeps every key inside one 64 byte block,
+*	one cache line, setting one bit in each of its eight words,
+*	so a lookup costs a single cache miss. It can be added to at
+*	any time. XorFilter is for catalogs that no longer change:
+*	it stores an 8 bit fingerprint per key in about 1.23 bytes
+*	and a lookup reads three bytes, with fewer false positives
+*	than the Bloom filter at the same size, but it must be built
+*	from every key at once.
+*
+*	CatalogFilters and FrozenCatalogFilters hold one filter of
+*	author names and one of titles, built from a list of Persons.
+* Date Created: 2026-10-18
+* Date Modified: 2026-10-18
+****************************************************************/
+
+#pragma once
+
+#include <algorithm>		// Included for std::sort and std::unique.
+#include <cstddef>			// Included for std::size_t.
+#include <cstdint>			// Included for std::uint8_t, std::uint32_t and std::uint64_t.
+#include <functional>		// Included for std::hash.
+#include <string_view>		// Included for std::string_view.
+#include <utility>			// Included for std::pair and std::move.
+#include <vector>			// Included for std::vector.
+
+#include "Catalog.h"		// Included for Person and Book.
+
+// Bloom filter bits per key. With eight bits set per key in one block, this gives about 0.4% false positives.
+constexpr std::size_t BLOOM_BITS_PER_KEY = 12;
+
+// Mixes the bits of a 64 bit value, so that every input bit affects every output bit.
+inline std::uint64_t BloomMix(std::uint64_t value) {
+	value ^= value >> 33;
+	value *= 0xFF51AFD7ED558CCDull;
+	value ^= value >> 33;
+	value *= 0xC4CEB9FE1A85EC53ull;
+	value ^= value >> 33;
+	return value;
+}
+
+// Hashes a string for the filters. std::hash may be weak on some platforms, so it is mixed again.
+inline std::uint64_t BloomHash(std::string_view str) {
+	return BloomMix(std::hash<std::string_view>()(str));
+}
+
+// Combines two hashes, as for a key of two strings. The order matters.
+inline std::uint64_t BloomCombine(std::uint64_t first, std::uint64_t second) {
+	return BloomMix(first ^ (second + 0x9E3779B97F4A7C15ull + (first << 6) + (first >> 2)));
+}
+
+// A Bloom filter whose keys each set eight bits in one 64 byte block.
+struct BlockedBloomFilter {
+	// One cache line of bits.
+	struct alignas(64) Block {
+		std::uint64_t words[8];		// One bit of every key in the block is set in each word.
+	};
+
+	std::vector<Block> blocks;		// The bits. Empty until Reserve is called.
+
+	void Reserve(std::size_t, std::size_t = BLOOM_BITS_PER_KEY);
+	void Add(std::uint64_t);
+	bool MayContain(std::uint64_t) const;
+	void Clear();
+};
+
+// Odd constants that pick a bit of each word from the low half of the hash.
+constexpr std::uint32_t BLOOM_SALT[8] = { 0x47B6137Bu, 0x44974D91u, 0x8824AD5Bu, 0xA2B7289Du, 0x705495C7u, 0x2DF1424Bu, 0x9EFC4947u, 0x5C6BFB31u };
+
+// Sizes the filter for the expected number of keys, and clears it. More keys can be added, with more false positives.
+inline void BlockedBloomFilter::Reserve(std::size_t expectedKeys, std::size_t bitsPerKey) {
+	std::size_t numBlocks = (expectedKeys * bitsPerKey + 511) / 512;
+	this->blocks.assign(numBlocks == 0 ? 1 : numBlocks, Block());
+}
+
+inline void BlockedBloomFilter::Add(std::uint64_t hash) {
+	if (this->blocks.empty()) {
+		this->Reserve(64);
+	}
+	// The high half of the hash picks the block without a division, the low half the bits in it.
+	Block& block = this->blocks[static_cast<std::size_t>(((hash >> 32) * this->blocks.size()) >> 32)];
+	std::uint32_t low = static_cast<std::uint32_t>(hash);
+	for (int i = 0; i < 8; ++i) {
+		block.words[i] |= 1ull << ((low * BLOOM_SALT[i]) >> 26);
+	}
+}
+
+// Returns false if the hash was never added.
+inline bool BlockedBloomFilter::MayContain(std::uint64_t hash) const {
+	if (this->blocks.empty()) {
+		return false;
+	}
+	const Block& block = this->blocks[static_cast<std::size_t>(((hash >> 32) * this->blocks.size()) >> 32)];
+	std::uint32_t low = static_cast<std::uint32_t>(hash);
+	std::uint64_t missing = 0;		// Checks every word without branches, which the compiler can vectorize.
+	for (int i = 0; i < 8; ++i) {
+		missing |= ~block.words[i] & (1ull << ((low * BLOOM_SALT[i]) >> 26));
+	}
+	return missing == 0;
+}
+
+inline void BlockedBloomFilter::Clear() {
+	this->blocks.clear();
+}
+
+// A static filter of 8 bit fingerprints. Each key maps to one slot in each third of the table, and the fingerprints
+// in its three slots XOR to the key's own fingerprint. About 0.4% false positives.
+struct XorFilter {
+	std::vector<std::uint8_t> fingerprints;		// The table, in three segments of segmentLength.
+	std::size_t segmentLength = 0;				// Number of slots in each segment.
+	std::uint64_t seed = 0;						// Mixed into every hash. Changed when construction fails.
+
+	bool Build(std::vector<std::uint64_t>);
+	bool MayContain(std::uint64_t) const;
+	void Slots(std::uint64_t, std::size_t[3]) const;
+};
+
+// The three slots of a seeded hash, one in each segment.
+inline void XorFilter::Slots(std::uint64_t hash, std::size_t slots[3]) const {
+	for (int i = 0; i < 3; ++i) {
+		std::uint64_t rotated = i == 0 ? hash : (hash >> (i * 21)) | (hash << (64 - i * 21));
+		std::uint32_t part = static_cast<std::uint32_t>(rotated);		// Three overlapping 32 bit windows of the hash.
+		slots[i] = static_cast<std::size_t>((static_cast<std::uint64_t>(part) * this->segmentLength) >> 32) + i * this->segmentLength;
+	}
+}
+
+// Builds the filter from the hashes of every key. Duplicates are allowed. Returns false only if construction keeps failing,
+// which does not happen for distinct hashes in practice.
+inline bool XorFilter::Build(std::vector<std::uint64_t> hashes) {
+	std::sort(hashes.begin(), hashes.end());
+	hashes.erase(std::unique(hashes.begin(), hashes.end()), hashes.end());		// A duplicate could never be peeled.
+	this->segmentLength = (hashes.size() * 123 / 100 + 32) / 3;
+	std::size_t size = 3 * this->segmentLength;
+	std::vector<std::uint64_t> xorOfKeys(size);		// Per slot, the XOR of the keys mapped to it. One key left means it is the key.
+	std::vector<std::uint32_t> counts(size);
+	std::vector<std::pair<std::uint64_t, std::size_t>> peeled;		// Keys in the order they were peeled, with the slot they own.
+	std::vector<std::size_t> queue;
+	for (int attempt = 0; attempt < 64; ++attempt, this->seed = BloomMix(this->seed + 1)) {
+		std::fill(xorOfKeys.begin(), xorOfKeys.end(), 0);
+		std::fill(counts.begin(), counts.end(), 0);
+		peeled.clear();
+		queue.clear();
+		std::size_t slots[3];
+		for (std::uint64_t hash : hashes) {
+			std::uint64_t key = BloomMix(hash + this->seed);
+			this->Slots(key, slots);
+			for (std::size_t slot : slots) {
+				xorOfKeys[slot] ^= key;
+				++counts[slot];
+			}
+		}
+		// Repeatedly take a key that is alone in one of its slots. That slot is then free to fix its fingerprint.
+		for (std::size_t slot = 0; slot < size; ++slot) {
+			if (counts[slot] == 1) {
+				queue.push_back(slot);
+			}
+		}
+		while (!queue.empty()) {
+			std::size_t slot = queue.back();
+			queue.pop_back();
+			if (counts[slot] != 1) {
+				continue;
+			}
+			std::uint64_t key = xorOfKeys[slot];
+			peeled.push_back({ key, slot });
+			this->Slots(key, slots);
+			for (std::size_t other : slots) {
+				xorOfKeys[other] ^= key;
+				if (--counts[other] == 1) {
+					queue.push_back(other);
+				}
+			}
+		}
+		if (peeled.size() != hashes.size()) {
+			continue;		// A cycle of keys could not be peeled. Try another seed.
+		}
+		// Assign in reverse peeling order, so every other slot of a key is already final when its own is set.
+		this->fingerprints.assign(size, 0);
+		for (std::size_t i = peeled.size(); i-- > 0;) {
+			std::uint64_t key = peeled[i].first;
+			this->Slots(key, slots);
+			std::uint8_t fingerprint = static_cast<std::uint8_t>(key ^ (key >> 32));
+			this->fingerprints[peeled[i].second] = 0;
+			this->fingerprints[peeled[i].second] = fingerprint ^ this->fingerprints[slots[0]] ^ this->fingerprints[slots[1]] ^ this->fingerprints[slots[2]];
+		}
+		return true;
+	}
+	this->fingerprints.clear();
+	this->segmentLength = 0;
+	return false;
+}
+
+// Returns false if the hash was not one of the keys built from.
+inline bool XorFilter::MayContain(std::uint64_t hash) const {
+	if (this->segmentLength == 0) {
+		return false;
+	}
+	std::uint64_t key = BloomMix(hash + this->seed);
+	std::size_t slots[3];
+	this->Slots(key, slots);
+	std::uint8_t fingerprint = static_cast<std::uint8_t>(key ^ (key >> 32));
+	return fingerprint == (this->fingerprints[slots[0]] ^ this->fingerprints[slots[1]] ^ this->fingerprints[slots[2]]);
+}
+
+// Bloom filters of the author names and titles of a changing catalog. Call AddPerson and AddBook as they are inserted.
+struct CatalogFilters {
+	BlockedBloomFilter authors;		// Hashes of Person::name.
+	BlockedBloomFilter titles;		// Hashes of Book::title.
+
+	void Build(const Person* const*, std::size_t);
+	void AddPerson(const Person&);
+	void AddBook(const Book&);
+	bool MayHaveAuthor(std::string_view) const;
+	bool MayHaveTitle(std::string_view) const;
+};
+
+// Sizes the filters for the persons and their books and adds them all.
+inline void CatalogFilters::Build(const Person* const* persons, std::size_t count) {
+	std::size_t numBooks = 0;
+	for (std::size_t i = 0; i < count; ++i) {
+		numBooks += persons[i]->stats.count;
+	}
+	this->authors.Reserve(count);
+	this->titles.Reserve(numBooks);
+	for (std::size_t i = 0; i < count; ++i) {
+		this->AddPerson(*persons[i]);
+	}
+}
+
+// Adds the person and every book in booksWritten.
+inline void CatalogFilters::AddPerson(const Person& person) {
+	this->authors.Add(BloomHash(person.name));
+	for (std::size_t idx = 0; idx < MAX_BOOKS_WRITTEN && person.booksWritten[idx]; ++idx) {
+		this->AddBook(*person.booksWritten[idx]);
+	}
+}
+
+inline void CatalogFilters::AddBook(const Book& book) {
+	this->titles.Add(BloomHash(book.title));
+}
+
+inline bool CatalogFilters::MayHaveAuthor(std::string_view name) const {
+	return this->authors.MayContain(BloomHash(name));
+}
+
+inline bool CatalogFilters::MayHaveTitle(std::string_view title) const {
+	return this->titles.MayContain(BloomHash(title));
+}
+
+// Xor filters of the author names and titles of a catalog that no longer changes.
+struct FrozenCatalogFilters {
+	XorFilter authors;		// Hashes of Person::name.
+	XorFilter titles;		// Hashes of Book::title.
+
+	bool Build(const Person* const*, std::size_t);
+	bool MayHaveAuthor(std::string_view) const;
+	bool MayHaveTitle(std::string_view) const;
+};
+
+inline bool FrozenCatalogFilters::Build(const Person* const* persons, std::size_t count) {
+	std::vector<std::uint64_t> names;
+	std::vector<std::uint64_t> titles;
+	names.reserve(count);
+	for (std::size_t i = 0; i < count; ++i) {
+		names.push_back(BloomHash(persons[i]->name));
+		for (std::size_t idx = 0; idx < MAX_BOOKS_WRITTEN && persons[i]->booksWritten[idx]; ++idx) {
+			titles.push_back(BloomHash(persons[i]->booksWritten[idx]->title));
+		}
+	}
+	return this->authors.Build(std::move(names)) && this->titles.Build(std::move(titles));
+}
+
+inline bool FrozenCatalogFilters::MayHaveAuthor(std::string_view name) const {
+	return this->authors.MayContain(BloomHash(name));
+}
+
+inline bool FrozenCatalogFilters::MayHaveTitle(std::string_view title) const {
+	return this->titles.MayContain(BloomHash(title));
+}
@@ -0,0 +1,358 @@
+/****************************************************************
+* Author: Leo Carroll
+* Description:
+*	The Person and Book structures that make up the catalog.
+*	Books hold a pointer to their author, and authors hold an
+*	array of pointers to the books that they have written.
+*	Everything is defined 'inline' so that the header can be
+*	included from more than one translation unit.
+* Date Created: 2026-02-08
+* Date Modified: 2026-10-18
+****************************************************************/
+
+#pragma once
+
+#include <iostream>			// Included for std::ostream.
+#include <cstdint>			// Included for std::uint32_t.
+#include <cstddef>			// Included for std::size_t.
+#include <string>			// Included for std::string.
+#include <map>				// Included for std::map.
+
+// Maximum number of books written per author.
+// It is marked as 'constexpr' as constexpr is better than defining.
+constexpr std::size_t MAX_BOOKS_WRITTEN = 100;
+
+// Number of books that the batch-at-a-time query code works on at once.
+constexpr std::size_t BOOK_BATCH_SIZE = 1024;
+
+struct Book;		// Forward declare the Book structure for use in the Person class.
+struct Person;		// Forward declare the Person structure for use in CatalogListener.
+
+// Running count, sum, minimum and maximum of the page counts of a set of books.
+// The minimum and maximum are 0 while the set is empty.
+struct BookStats {
+	std::size_t count;				// Number of books.
+	std::uint64_t totalPages;		// Sum of numberOfPages over the books.
+	std::uint32_t minPages;			// Smallest numberOfPages.
+	std::uint32_t maxPages;			// Largest numberOfPages.
+
+	// Default constructor
+	BookStats();
+
+	void Add(std::uint32_t);
+	double AveragePages() const;
+};
+
+// Catalog-wide rollup of every book held by the Persons attached to it.
+// Keeps a count per page number as well, so that the minimum and maximum stay exact when books are removed.
+struct CatalogStats {
+	BookStats books;										// Totals over every book.
+	std::size_t numAuthors;									// Number of Persons attached.
+	std::map<std::uint32_t, std::size_t> pageCounts;		// Number of books with each page count.
+
+	// Default constructor
+	CatalogStats();
+
+	void Add(std::uint32_t);
+	void Remove(std::uint32_t);
+};
+
+// Receives every change made to a Person's books through AddBook, RemoveBook, Book::SetPages and Book::SetTitle.
+// An edit is reported as the old book being removed and the edited book being added.
+struct CatalogListener {
+	virtual ~CatalogListener() = default;
+	virtual void OnBookAdded(const Person&, const Book&) = 0;
+	virtual void OnBookRemoved(const Person&, const Book&) = 0;
+};
+
+// Create the person class which represents that author.
+struct Person {
+	Book* booksWritten[MAX_BOOKS_WRITTEN];		// A stack-allocated array of Book pointers using the MAX_BOOKS_WRITTEN variable.
+	std::string name;		// The name of the author.
+	BookStats stats;		// Totals over booksWritten, kept up to date by AddBook, RemoveBook and Book::SetPages.
+	CatalogStats* rollup;	// Catalog-wide totals that this person's books are also counted in, or nullptr.
+	CatalogListener* listener;		// Told about every change to booksWritten, or nullptr.
+
+	// Default constructor
+	Person();
+	// Custom constructor
+	Person(Book*, std::size_t, const std::string&);
+
+	void AddBook(Book*);
+	bool RemoveBook(const Book*);
+	bool HasBook(const Book*) const;
+	void SetRollup(CatalogStats*);
+	void RecomputeStats();
+};
+
+struct Book {
+	Person* author;					// Person pointer to the author of the book.
+	std::string title;				// Title of the book.
+	std::uint32_t numberOfPages;	// Number of pages in the book.
+
+	// Custom constructor with default values. This allows you to basically default construct your book.
+	Book(Person* = nullptr, const std::string& = "", std::uint32_t = 0);
+
+	void SetPages(std::uint32_t);
+	void SetTitle(const std::string&);
+};
+
+// BookStats default constructor
+inline BookStats::BookStats() {
+	this->count = 0;
+	this->totalPages = 0;
+	this->minPages = 0;
+	this->maxPages = 0;
+}
+
+// Counts one more book with the given number of pages.
+inline void BookStats::Add(std::uint32_t pages) {
+	if (this->count == 0 || pages < this->minPages) {
+		this->minPages = pages;
+	}
+	if (this->count == 0 || pages > this->maxPages) {
+		this->maxPages = pages;
+	}
+	++this->count;
+	this->totalPages += pages;
+}
+
+// Returns the average number of pages, or 0 if there are no books.
+inline double BookStats::AveragePages() const {
+	return this->count ? static_cast<double>(this->totalPages) / static_cast<double>(this->count) : 0.0;
+}
+
+// CatalogStats default constructor
+inline CatalogStats::CatalogStats() {
+	this->numAuthors = 0;
+}
+
+// Counts one more book with the given number of pages.
+inline void CatalogStats::Add(std::uint32_t pages) {
+	this->books.Add(pages);
+	++this->pageCounts[pages];
+}
+
+// Stops counting one book with the given number of pages.
+inline void CatalogStats::Remove(std::uint32_t pages) {
+	std::map<std::uint32_t, std::size_t>::iterator it = this->pageCounts.find(pages);
+	if (it == this->pageCounts.end()) {
+		return;		// No such book was ever counted.
+	}
+	if (--it->second == 0) {
+		this->pageCounts.erase(it);
+	}
+	--this->books.count;
+	this->books.totalPages -= pages;
+	// The smallest and largest keys of the map are the new minimum and maximum.
+	this->books.minPages = this->pageCounts.empty() ? 0 : this->pageCounts.begin()->first;
+	this->books.maxPages = this->pageCounts.empty() ? 0 : this->pageCounts.rbegin()->first;
+}
+
+// Default constructor
+// Assigns default values to the members of the object.
+inline Person::Person() {
+	// Iterate over the booksWritten.
+	for (std::size_t i = 0; i < MAX_BOOKS_WRITTEN; ++i) {
+		this->booksWritten[i] = nullptr;		// Set every value in the array to nullptr.
+	}
+	this->name = "";		// Set the name of the person to an empty string.
+	this->rollup = nullptr;		// Not counted in any catalog-wide totals.
+	this->listener = nullptr;	// Nobody is listening for changes yet.
+}
+
+// Custom constructor
+// Takes a pointer to the first book in the array, the number of books in the array, and the name of the author.
+// The pointers are taken into the array itself, so it must not reallocate afterwards. Use BookStorage for a catalog that grows.
+inline Person::Person(Book* first, std::size_t numBooks, const std::string& name) {
+	std::size_t idx = 0;		// Create the index variable outside of the for loop so that it can be saved for the next for loop.
+	if (first != nullptr) {
+		// Iterate over the array from the first pointer.
+		for (idx = 0; idx < numBooks; ++idx) {
+			// Set booksWritten at the index variable to the address of the element idx elements after the first pointer.
+			this->booksWritten[idx] = &first[idx];
+		}
+	}
+	// Iterate over the array from the idx to the maximum number of books.
+	for (std::size_t i = idx; i < MAX_BOOKS_WRITTEN; ++i) {
+		this->booksWritten[i] = {};		// Default construct the booksWritten array at index i
+	}
+
+	this->name = name;		// Copy the value in the name arg to this->name member.
+	this->rollup = nullptr;		// Not counted in any catalog-wide totals.
+	this->listener = nullptr;	// Nobody is listening for changes yet.
+	this->RecomputeStats();		// Count the books taken from the array.
+}
+
+// Book custom constructor
+inline Book::Book(Person* author, const std::string& title, std::uint32_t pages) {
+	this->author = author;			// Set this->author member to the author arg.
+	this->title = title;			// Set this->title member to the title arg.
+	this->numberOfPages = pages;	// Set this->numberOfPages to the pages arg.
+}
+
+inline void Person::AddBook(Book* book) {
+	if (book) {
+		// Loop while the index is less than the maximum books, and while the author's booksWritten[idx] is not nullptr.
+		std::size_t idx = 0;		// Create an index variable to store the index of the first empty book.
+		while (idx < MAX_BOOKS_WRITTEN && this->booksWritten[idx]) {
+			++idx;		// Increment.
+		}
+		// Ensure that idx is less than the maximum books to prevent buffer overrun.
+		if (idx < MAX_BOOKS_WRITTEN) {
+			this->booksWritten[idx] = book;		// Add this book object to the author's booksWritten at the first available element.
+			this->stats.Add(book->numberOfPages);		// Count the book in this person's totals.
+			if (this->rollup) {
+				this->rollup->Add(book->numberOfPages);		// And in the catalog-wide totals.
+			}
+			if (this->listener) {
+				this->listener->OnBookAdded(*this, *book);
+			}
+		}
+	}
+	return;
+}
+
+// Removes the book from booksWritten and returns true if it was there.
+// The books after it are shifted down, so booksWritten still ends at the first nullptr.
+inline bool Person::RemoveBook(const Book* book) {
+	if (book) {
+		// Loop over the books in use, looking for the book.
+		for (std::size_t idx = 0; idx < MAX_BOOKS_WRITTEN && this->booksWritten[idx]; ++idx) {
+			if (this->booksWritten[idx] == book) {
+				// Shift every book after idx down one element.
+				while (idx + 1 < MAX_BOOKS_WRITTEN && this->booksWritten[idx + 1]) {
+					this->booksWritten[idx] = this->booksWritten[idx + 1];
+					++idx;
+				}
+				this->booksWritten[idx] = nullptr;		// Clear the element that was the last book.
+				if (this->rollup) {
+					this->rollup->Remove(book->numberOfPages);
+				}
+				if (this->listener) {
+					this->listener->OnBookRemoved(*this, *book);
+				}
+				// The count and total can be updated in place, but a removed minimum or maximum needs a walk over the remaining books.
+				if (book->numberOfPages == this->stats.minPages || book->numberOfPages == this->stats.maxPages) {
+					this->RecomputeStats();
+				}
+				else {
+					--this->stats.count;
+					this->stats.totalPages -= book->numberOfPages;
+				}
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+// Returns true if the book is in booksWritten.
+// A book can point at an author without being listed, after RemoveBook or when AddBook found no free element.
+inline bool Person::HasBook(const Book* book) const {
+	for (std::size_t idx = 0; idx < MAX_BOOKS_WRITTEN && this->booksWritten[idx]; ++idx) {
+		if (this->booksWritten[idx] == book) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// Recounts stats from booksWritten. This is bounded by MAX_BOOKS_WRITTEN, and only needed when a minimum or maximum is removed.
+inline void Person::RecomputeStats() {
+	this->stats = BookStats();
+	for (std::size_t idx = 0; idx < MAX_BOOKS_WRITTEN && this->booksWritten[idx]; ++idx) {
+		this->stats.Add(this->booksWritten[idx]->numberOfPages);
+	}
+}
+
+// Moves this person's books from the current catalog-wide totals to rollup. Pass nullptr to detach.
+// A Person that is attached must be detached before it is destroyed.
+inline void Person::SetRollup(CatalogStats* rollup) {
+	if (this->rollup == rollup) {
+		return;
+	}
+	// Take every book back out of the old totals, and put it in the new ones.
+	for (std::size_t idx = 0; idx < MAX_BOOKS_WRITTEN && this->booksWritten[idx]; ++idx) {
+		if (this->rollup) {
+			this->rollup->Remove(this->booksWritten[idx]->numberOfPages);
+		}
+		if (rollup) {
+			rollup->Add(this->booksWritten[idx]->numberOfPages);
+		}
+	}
+	if (this->rollup) {
+		--this->rollup->numAuthors;
+	}
+	if (rollup) {
+		++rollup->numAuthors;
+	}
+	this->rollup = rollup;
+}
+
+// Changes the number of pages and updates the totals of the author, if the author's booksWritten holds this book.
+// A book that is not listed is not counted in any totals, so only its page count changes.
+// Writing numberOfPages directly leaves the totals out of date.
+inline void Book::SetPages(std::uint32_t pages) {
+	if (this->author == nullptr || !this->author->HasBook(this)) {
+		this->numberOfPages = pages;
+		return;
+	}
+	if (this->author->listener) {
+		this->author->listener->OnBookRemoved(*this->author, *this);
+	}
+	BookStats& stats = this->author->stats;		// The author's totals.
+	stats.totalPages = stats.totalPages - this->numberOfPages + pages;
+	if (this->author->rollup) {
+		this->author->rollup->Remove(this->numberOfPages);
+		this->author->rollup->Add(pages);
+	}
+	std::uint32_t oldPages = this->numberOfPages;
+	this->numberOfPages = pages;
+	// Growing past the maximum or shrinking below the minimum can be applied in place, anything else touching them needs a recount.
+	if (oldPages == stats.minPages || oldPages == stats.maxPages) {
+		this->author->RecomputeStats();
+	}
+	else {
+		if (pages < stats.minPages) {
+			stats.minPages = pages;
+		}
+		if (pages > stats.maxPages) {
+			stats.maxPages = pages;
+		}
+	}
+	if (this->author->listener) {
+		this->author->listener->OnBookAdded(*this->author, *this);
+	}
+}
+
+// Changes the title, and tells the author's listener about the edit if the author's booksWritten holds this book.
+inline void Book::SetTitle(const std::string& title) {
+	bool listed = this->author && this->author->listener && this->author->HasBook(this);		// Whether the listener counts this book.
+	if (listed) {
+		this->author->listener->OnBookRemoved(*this->author, *this);
+	}
+	this->title = title;
+	if (listed) {
+		this->author->listener->OnBookAdded(*this->author, *this);
+	}
+}
+
+// Book output operator overload
+inline std::ostream& operator<<(std::ostream& os, const Book& book) {
+	// Output the book's contents, check if the author is nullptr before outputting the author's name, and output the number of pages.
+	// Note that this is a good candidate for std::print, but I have decided to use the standard way for the sake of portability.
+	os << book.title << ", " << (book.author ? book.author->name : "Unknown") << ", " << book.numberOfPages << " pages";
+	return os;		// Return the output stream.
+}
+
+// Person output operator overload
+inline std::ostream& operator<<(std::ostream& os, const Person& person) {
+	os << person.name;		// Output the person's name
+	std::size_t idx = 0;		// Create an idx variable to hold the index.
+	// Loop while the idx is less than the maximum books, and while the person's booksWritten is not nullptr, indicating that there are no more books.
+	while (idx < MAX_BOOKS_WRITTEN && person.booksWritten[idx] != nullptr) {
+		os << "\n - " << *person.booksWritten[idx++];		// Call the Book output operator overload on the dereferenced Book pointer at index idx.
+	}
+	return os;		// Return the output stream.
+}
@@ -0,0 +1,136 @@
+/****************************************************************
+* Author: Leo Carroll
+* Description:
+*	Regression checks for bugs found in the catalog. Each check
+*	replays the steps that exposed a bug and prints whether the
+*	result is still right. The program returns 1 if any check
+*	fails.
+*
+*	Build on its own, apart from Main.cpp:
+*	g++ -std=c++17 -g -O1 -fsanitize=address,undefined
+*		CatalogChecks.cpp
+* Date Created: 2026-10-18
+* Date Modified: 2026-10-18
+****************************************************************/
+
+#include <iostream>			// Included for std::cout.
+
+#include "Catalog.h"				// Included for Person, Book and CatalogStats.
+#include "MaterializedView.h"		// Included for ViewRegistry.
+
+int numFailures = 0;		// Number of checks that have failed so far.
+
+// Prints the outcome of one check, and counts it if it failed.
+void Check(bool passed, const char* description) {
+	std::cout << (passed ? "pass: " : "FAIL: ") << description << "\n";
+	if (!passed) {
+		++numFailures;
+	}
+}
+
+// SetPages on a book that was removed from its author, and so still points at it, must not touch the author's totals.
+void CheckSetPagesAfterRemove() {
+	CatalogStats rollup;
+	Person author;
+	author.SetRollup(&rollup);
+	Book first(&author, "First", 100);
+	Book second(&author, "Second", 200);
+	author.AddBook(&first);
+	author.AddBook(&second);
+	author.RemoveBook(&first);
+	first.SetPages(5);
+	Check(author.stats.count == 1 && author.stats.totalPages == 200 && author.stats.minPages == 200 && author.stats.maxPages == 200,
+		"SetPages on a removed book leaves the author's stats alone");
+	Check(rollup.books.count == 1 && rollup.books.totalPages == 200, "SetPages on a removed book leaves the rollup alone");
+	Check(first.numberOfPages == 5, "SetPages on a removed book still changes its pages");
+	author.SetRollup(nullptr);
+}
+
+// SetPages on a book that AddBook could not fit must not touch the author's totals either.
+void CheckSetPagesOnDroppedBook() {
+	Person author;
+	Book books[MAX_BOOKS_WRITTEN + 1];
+	std::uint64_t totalPages = 0;		// Sum of the pages of the books that fit.
+	for (std::size_t i = 0; i <= MAX_BOOKS_WRITTEN; ++i) {
+		books[i] = Book(&author, "", static_cast<std::uint32_t>(10 + i));
+		author.AddBook(&books[i]);
+		totalPages += i < MAX_BOOKS_WRITTEN ? 10 + i : 0;
+	}
+	// Neither the old nor the new page count is the minimum or maximum, so the totals would be adjusted in place.
+	books[MAX_BOOKS_WRITTEN].SetPages(50);
+	Check(author.stats.count == MAX_BOOKS_WRITTEN && author.stats.totalPages == totalPages,
+		"SetPages on a book that did not fit leaves the author's stats alone");
+}
+
+// Edits to a removed book must not reach the views, which never counted it.
+void CheckViewAfterRemove() {
+	ViewRegistry registry;
+	MaterializedView& view = registry.Register("pages", ViewFilter(), [](const Person&, const Book& book) {
+		return ViewKey{ nullptr, book.numberOfPages / 100 };
+	});
+	Person author;
+	Book first(&author, "First", 120);
+	Book second(&author, "Second", 340);
+	author.AddBook(&first);
+	author.AddBook(&second);
+	registry.Attach(author);
+	author.RemoveBook(&first);
+	first.SetPages(950);
+	first.SetTitle("Renamed");
+	Check(view.Find(ViewKey{ nullptr, 9 }) == nullptr && !view.IsRow(ViewKey{ nullptr, 9 }), "SetPages on a removed book adds no row to a view");
+	Check(registry.Verify(), "Views match a recompute after edits to a removed book");
+	// A remove that the view never saw an add for changes nothing, and Verify reports it.
+	view.Apply(author, first, false);
+	Check(view.Find(ViewKey{ nullptr, 9 }) == nullptr && view.Find(ViewKey{ nullptr, 1 }) == nullptr && view.Find(ViewKey{ nullptr, 3 })->count == 1,
+		"A view does not apply the removal of a book it never counted");
+	Check(view.unmatched == 1 && !registry.Verify(), "Verify reports the removal of a book a view never counted");
+	registry.Detach(author);
+}
+
+// A remove takes out what the add put in, even if the book changed in between without telling the view.
+void CheckViewRemoveAfterSilentEdit() {
+	ViewRegistry registry;
+	MaterializedView& view = registry.Register("pages", ViewFilter(), [](const Person&, const Book& book) {
+		return ViewKey{ nullptr, book.numberOfPages / 100 };
+	});
+	Person author;
+	Book book(&author, "Book", 120);
+	author.AddBook(&book);
+	registry.Attach(author);
+	book.numberOfPages = 480;
+	author.RemoveBook(&book);
+	Check(view.groups.empty() && view.rows.empty() && view.unmatched == 0 && registry.Verify(), "A view takes a book out of the group it was counted in");
+	registry.Detach(author);
+}
+
+// A registry that goes away must not leave its Persons pointing at it.
+void CheckRegistryDestructorDetaches() {
+	Person author;
+	{
+		ViewRegistry registry;
+		registry.Attach(author);
+	}
+	Check(author.listener == nullptr, "A destroyed registry detaches its Persons");
+	Book book(&author, "Book", 10);
+	author.AddBook(&book);		// Would call into the destroyed registry if it had not detached.
+}
+
+// A Person has one listener, so attaching a second registry must be refused.
+void CheckAttachIsExclusive() {
+	ViewRegistry first;
+	ViewRegistry second;
+	Person author;
+	Check(first.Attach(author) && !second.Attach(author) && author.listener == &first && second.attached.empty(),
+		"Attach refuses a Person that already has another listener");
+	first.Detach(author);
+}
+
+int main() {
+	CheckSetPagesAfterRemove();
+	CheckSetPagesOnDroppedBook();
+	CheckViewAfterRemove();
+	CheckAttachIsExclusive();
+	CheckViewRemoveAfterSilentEdit();
+	CheckRegistryDestructorDetaches();
+	return numFailures == 0 ? 0 : 1;
+}
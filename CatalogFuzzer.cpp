@@ -0,0 +1,72 @@
+/****************************************************************
+* Author: Leo Carroll
+* Description:
+*	The fuzzing entry point of the differential check in
+*	Differential.h. Every input is run as a program of catalog
+*	operations against the reference Person and Book and the
+*	intrusive LinkedPerson and LinkedBook, and any difference
+*	between them aborts with a description of it.
+*
+*	With libFuzzer, which provides main:
+*	clang++ -std=c++17 -g -O1 -fsanitize=fuzzer,address,undefined
+*		-DCATALOG_LIBFUZZER CatalogFuzzer.cpp
+*
+*	Without it, main replays the files named on the command line,
+*	or, with none, runs random inputs from a fixed seed:
+*	g++ -std=c++17 -g -O1 -fsanitize=address,undefined
+*		CatalogFuzzer.cpp
+* Date Created: 2026-10-18
+* Date Modified: 2026-10-18
+****************************************************************/
+
+#include <cstddef>				// Included for std::size_t.
+#include <cstdint>				// Included for std::uint8_t.
+#include <cstdlib>				// Included for std::abort.
+#include <iostream>				// Included for std::cerr.
+
+#ifndef CATALOG_LIBFUZZER
+#include <fstream>				// Included for std::ifstream.
+#include <iterator>				// Included for std::istreambuf_iterator.
+#include <random>				// Included for std::mt19937_64.
+#include <vector>				// Included for std::vector.
+#endif
+
+#include "Differential.h"		// Included for DifferentialCatalog.
+
+// Number of random inputs, and their longest length, when main runs without files.
+constexpr std::size_t FUZZ_RANDOM_RUNS = 20000;
+constexpr std::size_t FUZZ_RANDOM_BYTES = 2048;
+
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t* data, std::size_t size) {
+	DifferentialCatalog catalog;
+	if (!catalog.Run(data, size)) {
+		std::cerr << "Differential check failed: " << catalog.failure << "\n";
+		std::abort();
+	}
+	return 0;
+}
+
+#ifndef CATALOG_LIBFUZZER
+int main(int argc, char** argv) {
+	if (argc > 1) {
+		for (int i = 1; i < argc; ++i) {
+			std::ifstream file(argv[i], std::ios::binary);
+			std::vector<char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+			LLVMFuzzerTestOneInput(reinterpret_cast<const std::uint8_t*>(bytes.data()), bytes.size());
+		}
+		std::cout << "Replayed " << argc - 1 << " inputs.\n";
+		return 0;
+	}
+	std::mt19937_64 rng(0);
+	std::vector<std::uint8_t> bytes;
+	for (std::size_t run = 0; run < FUZZ_RANDOM_RUNS; ++run) {
+		bytes.resize(rng() % FUZZ_RANDOM_BYTES);
+		for (std::uint8_t& byte : bytes) {
+			byte = static_cast<std::uint8_t>(rng());
+		}
+		LLVMFuzzerTestOneInput(bytes.data(), bytes.size());
+	}
+	std::cout << "Ran " << FUZZ_RANDOM_RUNS << " random inputs.\n";
+	return 0;
+}
+#endif
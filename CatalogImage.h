@@ -0,0 +1,415 @@
+/****************************************************************
+* Author: Leo Carroll
+* Description:
+*	A prepared catalog in one relocatable block of bytes, so a
+*	process can start without building Persons, Books and their
+*	strings. CatalogImageBuilder serializes Persons and their
+*	books ahead of time. CatalogImage adopts the bytes as they
+*	are, mapped from a file with mmap or linked into the binary
+*	as an object file, and reads Persons and Books straight out
+*	of them.
+*
+*	Every reference inside the image is an offset or an index,
+*	never a pointer, so adopting it needs no fixups at all: Open
+*	maps the file and checks the header, and pages are only read
+*	in when a query touches them. The image holds, in order, a
+*	header, a record per Person, a record per Book with the books
+*	of each author next to each other, the Persons sorted by name
+*	for lookups, and the text of every name and title.
+*
+*	Numbers are stored little-endian on every host and read a
+*	byte at a time, so an image built on one machine can be used
+*	on another and the bytes need no alignment. An image is
+*	limited to 4 GB. CatalogImageTool.cpp builds an image as a
+*	build step and times the first query against it.
+*
+*	To link an image into the program, wrap it in an object file,
+*	for example with 'ld -r -b binary -o catalog.o catalog.img',
+*	and pass _binary_catalog_img_start and the image's size to
+*	Adopt.
+* Date Created: 2026-10-18
+* Date Modified: 2026-10-18
+****************************************************************/
+
+#pragma once
+
+#include <algorithm>		// Included for std::sort.
+#include <cstddef>			// Included for std::size_t.
+#include <cstdint>			// Included for std::uint32_t.
+#include <fstream>			// Included for std::ifstream and std::ofstream.
+#include <iterator>			// Included for std::istreambuf_iterator.
+#include <ostream>			// Included for std::ostream.
+#include <string>			// Included for std::string.
+#include <string_view>		// Included for std::string_view.
+#include <unordered_map>	// Included for std::unordered_map.
+#include <vector>			// Included for std::vector.
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>			// Included for open.
+#include <sys/mman.h>		// Included for mmap and munmap.
+#include <sys/stat.h>		// Included for fstat.
+#include <unistd.h>			// Included for close.
+#define CATALOG_IMAGE_MMAP 1
+#endif
+
+#include "Catalog.h"		// Included for Person and Book.
+
+// Marks the start of an image.
+constexpr std::uint32_t IMAGE_MAGIC = 0x474D4943;		// "CIMG"
+// Changes whenever the layout does.
+constexpr std::uint32_t IMAGE_VERSION = 1;
+// An index that refers to no Person.
+constexpr std::uint32_t IMAGE_NONE = UINT32_MAX;
+
+// Sizes of the header and the records, and the offsets of the fields inside them.
+constexpr std::size_t IMAGE_HEADER_BYTES = 32;
+constexpr std::size_t IMAGE_RECORD_BYTES = 16;
+constexpr std::size_t IMAGE_HEADER_NUM_PERSONS = 8;
+constexpr std::size_t IMAGE_HEADER_NUM_BOOKS = 12;
+constexpr std::size_t IMAGE_HEADER_PERSONS = 16;
+constexpr std::size_t IMAGE_HEADER_BOOKS = 20;
+constexpr std::size_t IMAGE_HEADER_INDEX = 24;
+constexpr std::size_t IMAGE_HEADER_STRINGS = 28;
+constexpr std::size_t IMAGE_PERSON_NAME = 0;			// Offset of the name in the strings, then its length.
+constexpr std::size_t IMAGE_PERSON_FIRST_BOOK = 8;
+constexpr std::size_t IMAGE_PERSON_NUM_BOOKS = 12;
+constexpr std::size_t IMAGE_BOOK_TITLE = 0;				// Offset of the title in the strings, then its length.
+constexpr std::size_t IMAGE_BOOK_PAGES = 8;
+constexpr std::size_t IMAGE_BOOK_AUTHOR = 12;
+
+// Reads a little-endian number, whatever the byte order of the host. Compilers turn this into a single load where the
+// host is little-endian.
+inline std::uint32_t ImageLoad(const char* at) {
+	const unsigned char* bytes = reinterpret_cast<const unsigned char*>(at);
+	return static_cast<std::uint32_t>(bytes[0]) | static_cast<std::uint32_t>(bytes[1]) << 8 |
+		static_cast<std::uint32_t>(bytes[2]) << 16 | static_cast<std::uint32_t>(bytes[3]) << 24;
+}
+
+// Writes a number in little-endian order.
+inline void ImageStore(char* at, std::uint32_t value) {
+	for (int i = 0; i < 4; ++i) {
+		at[i] = static_cast<char>(value >> (8 * i) & 0xFF);
+	}
+}
+
+// Appends a number in little-endian order.
+inline void ImageAppend(std::vector<char>& bytes, std::uint32_t value) {
+	char word[4];
+	ImageStore(word, value);
+	bytes.insert(bytes.end(), word, word + 4);
+}
+
+// Collects Persons and their books, and writes them out as an image.
+struct CatalogImageBuilder {
+	std::vector<char> persons;										// The Person records.
+	std::vector<char> books;										// The Book records.
+	std::string strings;											// The text of every name and title.
+	std::unordered_map<const Person*, std::uint32_t> personIndex;	// The index of the record of each Person added or named as an author.
+	std::uint32_t numPersons = 0;									// Number of Person records.
+	std::uint32_t numBooks = 0;										// Number of Book records.
+
+	void Add(const Person&);
+	std::uint32_t Record(const Person&);
+	std::vector<char> Build() const;
+	bool Write(const std::string&) const;
+};
+
+// A catalog image in memory. Persons and Books are referred to by index.
+struct CatalogImage {
+	const char* data = nullptr;			// The image.
+	std::size_t size = 0;				// Bytes in the image.
+	void* mapping = nullptr;			// The mapping that Open made, or nullptr.
+	std::vector<char> owned;			// The bytes that Open read, where mmap is not available.
+	std::uint32_t numPersons = 0;		// Number of Persons.
+	std::uint32_t numBooks = 0;			// Number of Books.
+	const char* persons = nullptr;		// The Person records.
+	const char* books = nullptr;		// The Book records.
+	const char* index = nullptr;		// Person indices sorted by name.
+	const char* strings = nullptr;		// The text of every name and title.
+	std::size_t stringsSize = 0;		// Bytes of text.
+
+	// Default constructor
+	CatalogImage() = default;
+	// Destructor, unmaps the image if Open mapped it.
+	~CatalogImage();
+	CatalogImage(const CatalogImage&) = delete;
+	CatalogImage& operator=(const CatalogImage&) = delete;
+
+	bool Open(const std::string&);
+	bool Adopt(const void*, std::size_t);
+	void Close();
+
+	std::string_view PersonName(std::uint32_t) const;
+	std::uint32_t FirstBook(std::uint32_t) const;
+	std::uint32_t NumBooks(std::uint32_t) const;
+	std::string_view BookTitle(std::uint32_t) const;
+	std::uint32_t BookPages(std::uint32_t) const;
+	std::uint32_t BookAuthor(std::uint32_t) const;
+	std::uint32_t Find(std::string_view) const;
+	bool Print(std::ostream&, std::uint32_t) const;
+
+	std::string_view String(const char*) const;
+};
+
+// Returns the index of the Person's record, adding one with no books if there is none yet.
+inline std::uint32_t CatalogImageBuilder::Record(const Person& person) {
+	std::unordered_map<const Person*, std::uint32_t>::iterator it = this->personIndex.find(&person);
+	if (it != this->personIndex.end()) {
+		return it->second;
+	}
+	ImageAppend(this->persons, static_cast<std::uint32_t>(this->strings.size()));
+	ImageAppend(this->persons, static_cast<std::uint32_t>(person.name.size()));
+	ImageAppend(this->persons, 0);
+	ImageAppend(this->persons, 0);
+	this->strings += person.name;
+	this->personIndex.emplace(&person, this->numPersons);
+	return this->numPersons++;
+}
+
+// Adds a Person and its books. Add each Person once. A book's author is stored as the Person it names, which need not be
+// the Person that lists it, and gets a record of its own if it is not added itself, so that Print shows the same author
+// as the Book output operator.
+inline void CatalogImageBuilder::Add(const Person& person) {
+	std::size_t numBooks = 0;
+	while (numBooks < MAX_BOOKS_WRITTEN && person.booksWritten[numBooks]) {
+		++numBooks;
+	}
+	// A Person already named as an author has a record with no books, which now gets its books.
+	std::uint32_t index = this->Record(person);		// Before taking the address, as Record may grow persons.
+	char* record = this->persons.data() + static_cast<std::size_t>(index) * IMAGE_RECORD_BYTES;
+	ImageStore(record + IMAGE_PERSON_FIRST_BOOK, this->numBooks);
+	ImageStore(record + IMAGE_PERSON_NUM_BOOKS, static_cast<std::uint32_t>(numBooks));
+	for (std::size_t idx = 0; idx < numBooks; ++idx) {
+		const Book& book = *person.booksWritten[idx];
+		std::uint32_t author = book.author ? this->Record(*book.author) : IMAGE_NONE;		// First, as Record may add to strings.
+		ImageAppend(this->books, static_cast<std::uint32_t>(this->strings.size()));
+		ImageAppend(this->books, static_cast<std::uint32_t>(book.title.size()));
+		ImageAppend(this->books, book.numberOfPages);
+		ImageAppend(this->books, author);
+		this->strings += book.title;
+	}
+	this->numBooks += static_cast<std::uint32_t>(numBooks);
+}
+
+// Returns the bytes of the image.
+inline std::vector<char> CatalogImageBuilder::Build() const {
+	// Sort the Persons by name, so that Find is a binary search.
+	std::vector<std::uint32_t> order(this->numPersons);
+	for (std::uint32_t i = 0; i < this->numPersons; ++i) {
+		order[i] = i;
+	}
+	auto name = [this](std::uint32_t person) {
+		const char* record = this->persons.data() + static_cast<std::size_t>(person) * IMAGE_RECORD_BYTES;
+		return std::string_view(this->strings).substr(ImageLoad(record + IMAGE_PERSON_NAME), ImageLoad(record + IMAGE_PERSON_NAME + 4));
+	};
+	std::sort(order.begin(), order.end(), [&](std::uint32_t a, std::uint32_t b) { return name(a) < name(b); });
+
+	std::uint32_t personsAt = static_cast<std::uint32_t>(IMAGE_HEADER_BYTES);
+	std::uint32_t booksAt = personsAt + static_cast<std::uint32_t>(this->persons.size());
+	std::uint32_t indexAt = booksAt + static_cast<std::uint32_t>(this->books.size());
+	std::uint32_t stringsAt = indexAt + 4 * this->numPersons;
+	std::vector<char> image;
+	image.reserve(stringsAt + this->strings.size());
+	ImageAppend(image, IMAGE_MAGIC);
+	ImageAppend(image, IMAGE_VERSION);
+	ImageAppend(image, this->numPersons);
+	ImageAppend(image, this->numBooks);
+	ImageAppend(image, personsAt);
+	ImageAppend(image, booksAt);
+	ImageAppend(image, indexAt);
+	ImageAppend(image, stringsAt);
+	image.insert(image.end(), this->persons.begin(), this->persons.end());
+	image.insert(image.end(), this->books.begin(), this->books.end());
+	for (std::uint32_t person : order) {
+		ImageAppend(image, person);
+	}
+	image.insert(image.end(), this->strings.begin(), this->strings.end());
+	return image;
+}
+
+// Writes the image to a file. Returns false if the file cannot be written or the image passes 4 GB.
+inline bool CatalogImageBuilder::Write(const std::string& path) const {
+	std::size_t total = IMAGE_HEADER_BYTES + this->persons.size() + this->books.size() + 4 * static_cast<std::size_t>(this->numPersons) + this->strings.size();
+	if (total > UINT32_MAX) {
+		return false;
+	}
+	std::vector<char> image = this->Build();
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	file.write(image.data(), static_cast<std::streamsize>(image.size()));
+	return static_cast<bool>(file);
+}
+
+inline CatalogImage::~CatalogImage() {
+	this->Close();
+}
+
+// Maps the image in a file, or reads it where mmap is not available. Returns false if it is not a valid image.
+inline bool CatalogImage::Open(const std::string& path) {
+	this->Close();
+#ifdef CATALOG_IMAGE_MMAP
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+	struct stat status;
+	if (fstat(fd, &status) != 0 || status.st_size <= 0) {
+		close(fd);
+		return false;
+	}
+	void* mapping = mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);		// The mapping keeps the file open.
+	if (mapping == MAP_FAILED) {
+		return false;
+	}
+	if (!this->Adopt(mapping, static_cast<std::size_t>(status.st_size))) {
+		munmap(mapping, static_cast<std::size_t>(status.st_size));
+		return false;
+	}
+	this->mapping = mapping;
+	return true;
+#else
+	std::ifstream file(path, std::ios::binary);
+	std::vector<char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	if (!this->Adopt(bytes.data(), bytes.size())) {
+		return false;
+	}
+	this->owned.swap(bytes);		// Swapping keeps the buffer, and so the pointers into it, where they are.
+	return true;
+#endif
+}
+
+// Uses an image already in memory, for example one linked into the program, which must outlive this object.
+// Only the header and the bounds of the sections are checked, so no page past them is touched. Returns false if they
+// are not valid.
+inline bool CatalogImage::Adopt(const void* bytes, std::size_t size) {
+	this->Close();
+	const char* data = static_cast<const char*>(bytes);
+	if (data == nullptr || size < IMAGE_HEADER_BYTES || size > UINT32_MAX || ImageLoad(data) != IMAGE_MAGIC || ImageLoad(data + 4) != IMAGE_VERSION) {
+		return false;
+	}
+	std::uint64_t numPersons = ImageLoad(data + IMAGE_HEADER_NUM_PERSONS);
+	std::uint64_t numBooks = ImageLoad(data + IMAGE_HEADER_NUM_BOOKS);
+	std::uint64_t personsAt = ImageLoad(data + IMAGE_HEADER_PERSONS);
+	std::uint64_t booksAt = ImageLoad(data + IMAGE_HEADER_BOOKS);
+	std::uint64_t indexAt = ImageLoad(data + IMAGE_HEADER_INDEX);
+	std::uint64_t stringsAt = ImageLoad(data + IMAGE_HEADER_STRINGS);
+	// 64-bit arithmetic, so that no bound can wrap around.
+	if (personsAt < IMAGE_HEADER_BYTES || personsAt + numPersons * IMAGE_RECORD_BYTES > booksAt ||
+		booksAt + numBooks * IMAGE_RECORD_BYTES > indexAt || indexAt + numPersons * 4 > stringsAt || stringsAt > size) {
+		return false;
+	}
+	this->data = data;
+	this->size = size;
+	this->numPersons = static_cast<std::uint32_t>(numPersons);
+	this->numBooks = static_cast<std::uint32_t>(numBooks);
+	this->persons = data + personsAt;
+	this->books = data + booksAt;
+	this->index = data + indexAt;
+	this->strings = data + stringsAt;
+	this->stringsSize = size - stringsAt;
+	return true;
+}
+
+inline void CatalogImage::Close() {
+#ifdef CATALOG_IMAGE_MMAP
+	if (this->mapping) {
+		munmap(this->mapping, this->size);
+	}
+#endif
+	this->mapping = nullptr;
+	this->owned.clear();
+	this->data = nullptr;
+	this->size = 0;
+	this->numPersons = 0;
+	this->numBooks = 0;
+	this->persons = nullptr;
+	this->books = nullptr;
+	this->index = nullptr;
+	this->strings = nullptr;
+	this->stringsSize = 0;
+}
+
+// Returns the string whose offset and length are at field, or an empty string if they are out of bounds.
+inline std::string_view CatalogImage::String(const char* field) const {
+	std::uint64_t at = ImageLoad(field);
+	std::uint64_t length = ImageLoad(field + 4);
+	if (at + length > this->stringsSize) {
+		return std::string_view();
+	}
+	return std::string_view(this->strings + at, static_cast<std::size_t>(length));
+}
+
+// The accessors below return an empty name or title, and 0 or IMAGE_NONE, for an index out of bounds.
+inline std::string_view CatalogImage::PersonName(std::uint32_t person) const {
+	return person < this->numPersons ? this->String(this->persons + static_cast<std::size_t>(person) * IMAGE_RECORD_BYTES + IMAGE_PERSON_NAME) : std::string_view();
+}
+
+inline std::uint32_t CatalogImage::FirstBook(std::uint32_t person) const {
+	return person < this->numPersons ? ImageLoad(this->persons + static_cast<std::size_t>(person) * IMAGE_RECORD_BYTES + IMAGE_PERSON_FIRST_BOOK) : 0;
+}
+
+inline std::uint32_t CatalogImage::NumBooks(std::uint32_t person) const {
+	if (person >= this->numPersons) {
+		return 0;
+	}
+	std::uint64_t first = this->FirstBook(person);
+	std::uint64_t count = ImageLoad(this->persons + static_cast<std::size_t>(person) * IMAGE_RECORD_BYTES + IMAGE_PERSON_NUM_BOOKS);
+	// A damaged record must not lead past the last book.
+	return first + count > this->numBooks ? 0 : static_cast<std::uint32_t>(count);
+}
+
+inline std::string_view CatalogImage::BookTitle(std::uint32_t book) const {
+	return book < this->numBooks ? this->String(this->books + static_cast<std::size_t>(book) * IMAGE_RECORD_BYTES + IMAGE_BOOK_TITLE) : std::string_view();
+}
+
+inline std::uint32_t CatalogImage::BookPages(std::uint32_t book) const {
+	return book < this->numBooks ? ImageLoad(this->books + static_cast<std::size_t>(book) * IMAGE_RECORD_BYTES + IMAGE_BOOK_PAGES) : 0;
+}
+
+inline std::uint32_t CatalogImage::BookAuthor(std::uint32_t book) const {
+	return book < this->numBooks ? ImageLoad(this->books + static_cast<std::size_t>(book) * IMAGE_RECORD_BYTES + IMAGE_BOOK_AUTHOR) : IMAGE_NONE;
+}
+
+// Returns the index of a Person with the name, or IMAGE_NONE. A binary search that only touches O(log n) records.
+inline std::uint32_t CatalogImage::Find(std::string_view name) const {
+	std::uint32_t low = 0;
+	std::uint32_t high = this->numPersons;
+	while (low < high) {
+		std::uint32_t middle = low + (high - low) / 2;
+		if (this->PersonName(ImageLoad(this->index + 4 * static_cast<std::size_t>(middle))) < name) {
+			low = middle + 1;
+		}
+		else {
+			high = middle;
+		}
+	}
+	if (low < this->numPersons) {
+		std::uint32_t person = ImageLoad(this->index + 4 * static_cast<std::size_t>(low));
+		if (this->PersonName(person) == name) {
+			return person;
+		}
+	}
+	return IMAGE_NONE;
+}
+
+// Outputs the person and its books in the same format as the Person output operator.
+inline bool CatalogImage::Print(std::ostream& os, std::uint32_t person) const {
+	if (person >= this->numPersons) {
+		return false;
+	}
+	os << this->PersonName(person);
+	std::uint32_t first = this->FirstBook(person);
+	std::uint32_t count = this->NumBooks(person);
+	for (std::uint32_t book = first; book < first + count; ++book) {
+		std::uint32_t author = this->BookAuthor(book);
+		os << "\n - " << this->BookTitle(book) << ", ";
+		if (author == IMAGE_NONE) {
+			os << "Unknown";
+		}
+		else {
+			os << this->PersonName(author);
+		}
+		os << ", " << this->BookPages(book) << " pages";
+	}
+	return true;
+}
@@ -0,0 +1,141 @@
+/****************************************************************
+* Author: Leo Carroll
+* Description:
+*	Builds a catalog image as a build step, and times the first
+*	query a process can answer with and without it. A generated
+*	catalog is written to the image file given on the command
+*	line, catalog.img by default. Then the time to the first
+*	query is measured two ways: building the Persons, Books and
+*	a name index from the source data and looking an author up,
+*	and opening the image and looking the same author up with
+*	CatalogImage::Find. Both must print the author the same way.
+*
+*	The image is timed with the file already in the page cache,
+*	as it is when the build step has just written it.
+*
+*	Build on its own, apart from Main.cpp:
+*	g++ -std=c++17 -O2 CatalogImageTool.cpp
+* Date Created: 2026-10-18
+* Date Modified: 2026-10-18
+****************************************************************/
+
+#include <chrono>			// Included for std::chrono::steady_clock.
+#include <cstdint>			// Included for std::uint32_t.
+#include <iostream>			// Included for std::cout.
+#include <random>			// Included for std::mt19937_64.
+#include <sstream>			// Included for std::ostringstream.
+#include <string>			// Included for std::string.
+#include <string_view>		// Included for std::string_view.
+#include <unordered_map>	// Included for std::unordered_map.
+#include <vector>			// Included for std::vector.
+
+#include "CatalogImage.h"	// Included for CatalogImageBuilder and CatalogImage.
+#include "StableStorage.h"	// Included for PersonStorage and BookStorage.
+
+constexpr std::size_t NUM_AUTHORS = 200000;			// Number of authors in the generated catalog.
+constexpr std::size_t BOOKS_PER_AUTHOR = 5;			// Number of books each author has written.
+constexpr int NUM_REPEATS = 5;						// Each measurement is the best of this many runs.
+
+// The source data of one author, as a program would read it before building the catalog.
+struct SourceAuthor {
+	std::string name;							// Name of the author.
+	std::vector<std::string> titles;			// Titles of the author's books.
+	std::vector<std::uint32_t> pages;			// Number of pages in each book.
+};
+
+// A catalog built from the source data, with an index by name for the first query.
+struct BuiltCatalog {
+	PersonStorage persons;									// The Persons.
+	BookStorage books;										// The Books.
+	std::unordered_map<std::string_view, Person*> byName;	// Every Person by name.
+};
+
+// Runs work NUM_REPEATS times and returns the fewest seconds any run took.
+template <typename Work>
+double BestSeconds(Work work) {
+	double best = 1e30;
+	for (int run = 0; run < NUM_REPEATS; ++run) {
+		std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+		work();
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+		best = seconds < best ? seconds : best;
+	}
+	return best;
+}
+
+// Builds the catalog and its index from the source data.
+void BuildCatalog(const std::vector<SourceAuthor>& source, BuiltCatalog& catalog) {
+	catalog.byName.reserve(source.size());
+	for (const SourceAuthor& author : source) {
+		Person& person = catalog.persons.Emplace(nullptr, 0, author.name);
+		for (std::size_t j = 0; j < author.titles.size(); ++j) {
+			person.AddBook(&catalog.books.Emplace(&person, author.titles[j], author.pages[j]));
+		}
+		catalog.byName.emplace(person.name, &person);
+	}
+}
+
+int main(int argc, char** argv) {
+	std::string path = argc > 1 ? argv[1] : "catalog.img";
+
+	// Generate the source data.
+	std::vector<SourceAuthor> source(NUM_AUTHORS);
+	std::mt19937_64 rng(0);
+	for (std::size_t i = 0; i < NUM_AUTHORS; ++i) {
+		source[i].name = "Author " + std::to_string(rng() % 1000000000) + " " + std::to_string(i);
+		for (std::size_t j = 0; j < BOOKS_PER_AUTHOR; ++j) {
+			source[i].titles.push_back("The " + std::to_string(rng() % 100000) + " Chronicles of the Long Night");
+			source[i].pages.push_back(static_cast<std::uint32_t>(50 + rng() % 1200));
+		}
+	}
+	const std::string& wanted = source[NUM_AUTHORS / 3].name;		// The author that the first query looks up.
+
+	// The build step: write the image.
+	{
+		BuiltCatalog catalog;
+		BuildCatalog(source, catalog);
+		CatalogImageBuilder builder;
+		for (std::size_t i = 0; i < catalog.persons.Size(); ++i) {
+			builder.Add(catalog.persons[i]);
+		}
+		if (!builder.Write(path)) {
+			std::cout << "Could not write " << path << ".\n";
+			return 1;
+		}
+	}
+
+	// From scratch: build the catalog, then look the author up.
+	std::string fromScratch;
+	double scratchSeconds = BestSeconds([&]() {
+		BuiltCatalog catalog;
+		BuildCatalog(source, catalog);
+		std::unordered_map<std::string_view, Person*>::const_iterator it = catalog.byName.find(wanted);
+		std::ostringstream out;
+		if (it != catalog.byName.end()) {
+			out << *it->second;
+		}
+		fromScratch = out.str();
+	});
+
+	// From the image: open it, then look the author up.
+	std::string fromImage;
+	bool opened = true;
+	std::size_t imageBytes = 0;
+	double imageSeconds = BestSeconds([&]() {
+		CatalogImage image;
+		opened = image.Open(path);
+		imageBytes = image.size;
+		std::ostringstream out;
+		image.Print(out, image.Find(wanted));
+		fromImage = out.str();
+	});
+	if (!opened || fromScratch.empty() || fromScratch != fromImage) {
+		std::cout << "The image and the built catalog answered the first query differently.\n";
+		return 1;
+	}
+
+	std::cout << "Image: " << path << ", " << static_cast<double>(imageBytes) / 1e6 << " MB, " << NUM_AUTHORS << " authors, " << NUM_AUTHORS * BOOKS_PER_AUTHOR << " books\n";
+	std::cout << "First query, built from scratch: " << scratchSeconds * 1e3 << " ms\n";
+	std::cout << "First query, from the image:     " << imageSeconds * 1e3 << " ms\n";
+	return 0;
+}
@@ -0,0 +1,203 @@
+/****************************************************************
+* Author: Leo Carroll
+* Description:
+*	A concurrent map from names to values, for ingest threads
+*	that all find or create Persons by name. Lookups take no
+*	lock: they load the current table and probe it with atomic
+*	loads. Inserts lock one of CONCURRENT_MAP_STRIPES mutexes
+*	picked by the hash of the name, so inserts of different
+*	names rarely wait on each other, and two inserts of the same
+*	name are serialized and agree on one value.
+*
+*	The table is open addressed with linear probing. An entry is
+*	written in full before its pointer is published into a slot,
+*	and is never changed or removed afterwards. When the table is
+*	half full, the inserting thread takes every stripe, copies
+*	the entry pointers into a table twice the size and publishes
+*	it. Readers may still be probing the old table, so old
+*	tables are kept until the map is destroyed; together they are
+*	never larger than the current one.
+* Date Created: 2026-10-18
+* Date Modified: 2026-10-18
+****************************************************************/
+
+#pragma once
+
+#include <atomic>			// Included for std::atomic.
+#include <cstddef>			// Included for std::size_t.
+#include <cstdint>			// Included for std::uint64_t.
+#include <memory>			// Included for std::unique_ptr.
+#include <mutex>			// Included for std::mutex and std::lock_guard.
+#include <string>			// Included for std::string.
+#include <string_view>		// Included for std::string_view.
+#include <utility>			// Included for std::move.
+#include <vector>			// Included for std::vector.
+
+#include "BloomFilter.h"	// Included for BloomHash.
+
+// Number of insert locks.
+constexpr std::size_t CONCURRENT_MAP_STRIPES = 64;
+// Number of slots in a new map's table.
+constexpr std::size_t CONCURRENT_MAP_INITIAL_SLOTS = 1024;
+
+// A map from names to values with lock-free lookups and insert-if-absent.
+template <typename Value>
+struct ConcurrentMap {
+	// A name and its value. Immutable once published.
+	struct Entry {
+		std::string name;		// The key.
+		Value value;			// The value.
+	};
+
+	// One position of a table. hash is set first to claim the slot, then entry is published.
+	struct Slot {
+		std::atomic<std::uint64_t> hash{ 0 };		// Hash of the entry's name, or 0 while the slot is free.
+		std::atomic<Entry*> entry{ nullptr };		// The entry, or nullptr until it is published.
+	};
+
+	// An array of slots whose size is a power of two.
+	struct Table {
+		std::unique_ptr<Slot[]> slots;		// The slots.
+		std::size_t mask;					// Number of slots minus one.
+
+		explicit Table(std::size_t numSlots) : slots(new Slot[numSlots]), mask(numSlots - 1) {}
+	};
+
+	std::atomic<Table*> table;							// The table that lookups and inserts use.
+	std::vector<std::unique_ptr<Table>> tables;			// Every table allocated, kept for readers of old ones. Guarded by every stripe.
+	std::mutex stripes[CONCURRENT_MAP_STRIPES];			// Insert locks, picked by hash.
+	std::atomic<std::size_t> size{ 0 };					// Number of entries.
+
+	// Default constructor
+	ConcurrentMap();
+	// Destructor, frees every entry.
+	~ConcurrentMap();
+	ConcurrentMap(const ConcurrentMap&) = delete;
+	ConcurrentMap& operator=(const ConcurrentMap&) = delete;
+
+	const Value* Find(std::string_view) const;
+	template <typename Factory>
+	const Value& FindOrInsert(std::string_view, Factory&&);
+	std::size_t Size() const;
+
+	static std::uint64_t Hash(std::string_view);
+	static Entry* Probe(const Table&, std::uint64_t, std::string_view);
+	void Grow();
+};
+
+template <typename Value>
+inline ConcurrentMap<Value>::ConcurrentMap() {
+	this->tables.emplace_back(new Table(CONCURRENT_MAP_INITIAL_SLOTS));
+	this->table.store(this->tables.back().get(), std::memory_order_release);
+}
+
+template <typename Value>
+inline ConcurrentMap<Value>::~ConcurrentMap() {
+	// Every entry is in the current table, and only there is it deleted.
+	Table* current = this->table.load(std::memory_order_acquire);
+	for (std::size_t i = 0; i <= current->mask; ++i) {
+		delete current->slots[i].entry.load(std::memory_order_relaxed);
+	}
+}
+
+// Hashes a name. 0 marks a free slot, so it is never returned.
+template <typename Value>
+inline std::uint64_t ConcurrentMap<Value>::Hash(std::string_view name) {
+	std::uint64_t hash = BloomHash(name);
+	return hash == 0 ? 1 : hash;
+}
+
+// Probes a table for the name. Returns nullptr if it is not published there.
+template <typename Value>
+inline typename ConcurrentMap<Value>::Entry* ConcurrentMap<Value>::Probe(const Table& table, std::uint64_t hash, std::string_view name) {
+	for (std::size_t i = hash & table.mask; ; i = (i + 1) & table.mask) {
+		const Slot& slot = table.slots[i];
+		std::uint64_t slotHash = slot.hash.load(std::memory_order_acquire);
+		if (slotHash == 0) {
+			return nullptr;		// Names are never removed, so the probe sequence of the name ends here.
+		}
+		if (slotHash == hash) {
+			// A claimed slot whose entry is not yet published is an insert still in progress, which is not found yet.
+			Entry* entry = slot.entry.load(std::memory_order_acquire);
+			if (entry && entry->name == name) {
+				return entry;
+			}
+		}
+	}
+}
+
+// Returns the value of the name, or nullptr if it has not been inserted. Takes no lock.
+template <typename Value>
+inline const Value* ConcurrentMap<Value>::Find(std::string_view name) const {
+	Entry* entry = Probe(*this->table.load(std::memory_order_acquire), Hash(name), name);
+	return entry ? &entry->value : nullptr;
+}
+
+// Returns the value of the name, inserting factory() for it if it has none. factory is called at most once per name
+// across all threads, under the name's stripe lock. The returned reference stays valid until the map is destroyed.
+template <typename Value>
+template <typename Factory>
+inline const Value& ConcurrentMap<Value>::FindOrInsert(std::string_view name, Factory&& factory) {
+	std::uint64_t hash = Hash(name);
+	// Most names already exist, and are found without a lock.
+	if (Entry* entry = Probe(*this->table.load(std::memory_order_acquire), hash, name)) {
+		return entry->value;
+	}
+	while (true) {
+		{
+			std::lock_guard<std::mutex> lock(this->stripes[hash % CONCURRENT_MAP_STRIPES]);
+			// The table cannot be replaced while a stripe is held.
+			Table& current = *this->table.load(std::memory_order_acquire);
+			if (Entry* entry = Probe(current, hash, name)) {
+				return entry->value;
+			}
+			if (2 * (this->size.load(std::memory_order_relaxed) + 1) <= current.mask + 1) {
+				Entry* entry = new Entry{ std::string(name), factory() };
+				for (std::size_t i = hash & current.mask; ; i = (i + 1) & current.mask) {
+					std::uint64_t expected = 0;
+					// Inserts under other stripes may race for the same free slot.
+					if (current.slots[i].hash.compare_exchange_strong(expected, hash, std::memory_order_acq_rel)) {
+						current.slots[i].entry.store(entry, std::memory_order_release);
+						break;
+					}
+				}
+				this->size.fetch_add(1, std::memory_order_relaxed);
+				return entry->value;
+			}
+		}
+		this->Grow();
+	}
+}
+
+// Copies every entry into a table twice the size, holding every stripe so that no insert runs meanwhile.
+template <typename Value>
+inline void ConcurrentMap<Value>::Grow() {
+	std::unique_lock<std::mutex> locks[CONCURRENT_MAP_STRIPES];
+	for (std::size_t i = 0; i < CONCURRENT_MAP_STRIPES; ++i) {
+		locks[i] = std::unique_lock<std::mutex>(this->stripes[i]);
+	}
+	Table& current = *this->table.load(std::memory_order_acquire);
+	if (2 * (this->size.load(std::memory_order_relaxed) + 1) <= current.mask + 1) {
+		return;		// Another thread grew it first.
+	}
+	Table* grown = new Table(2 * (current.mask + 1));
+	for (std::size_t i = 0; i <= current.mask; ++i) {
+		Entry* entry = current.slots[i].entry.load(std::memory_order_relaxed);
+		if (entry) {
+			std::uint64_t hash = current.slots[i].hash.load(std::memory_order_relaxed);
+			std::size_t j = hash & grown->mask;
+			while (grown->slots[j].hash.load(std::memory_order_relaxed) != 0) {
+				j = (j + 1) & grown->mask;
+			}
+			grown->slots[j].hash.store(hash, std::memory_order_relaxed);
+			grown->slots[j].entry.store(entry, std::memory_order_relaxed);
+		}
+	}
+	this->tables.emplace_back(grown);
+	this->table.store(grown, std::memory_order_release);		// Publishes the slots written above.
+}
+
+template <typename Value>
+inline std::size_t ConcurrentMap<Value>::Size() const {
+	return this->size.load(std::memory_order_relaxed);
+}
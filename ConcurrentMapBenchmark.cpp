@@ -0,0 +1,102 @@
+/****************************************************************
+* Author: Leo Carroll
+* Description:
+*	A contention benchmark of the author registry. 64 threads
+*	find or create authors by name, picking names with Zipfian
+*	popularity, so a few authors take most of the lookups, as
+*	in a real ingest feed. The same workload is run against a
+*	mutex-protected std::unordered_map and against
+*	ConcurrentMap, and the throughput of each is printed.
+*
+*	Build on its own, apart from Main.cpp:
+*	g++ -std=c++17 -O2 -pthread ConcurrentMapBenchmark.cpp
+* Date Created: 2026-10-18
+* Date Modified: 2026-10-18
+****************************************************************/
+
+#include <algorithm>		// Included for std::lower_bound.
+#include <atomic>			// Included for std::atomic.
+#include <chrono>			// Included for std::chrono::steady_clock.
+#include <cmath>			// Included for std::pow.
+#include <cstdint>			// Included for std::uint32_t.
+#include <iostream>			// Included for std::cout.
+#include <mutex>			// Included for std::mutex.
+#include <random>			// Included for std::mt19937_64.
+#include <string>			// Included for std::string.
+#include <thread>			// Included for std::thread.
+#include <unordered_map>	// Included for std::unordered_map.
+#include <vector>			// Included for std::vector.
+
+#include "ConcurrentMap.h"	// Included for ConcurrentMap.
+
+constexpr unsigned NUM_THREADS = 64;				// Number of ingest threads.
+constexpr std::size_t NUM_AUTHORS = 1000000;		// Number of distinct author names.
+constexpr std::size_t OPS_PER_THREAD = 200000;		// Number of find-or-create calls per thread.
+constexpr double ZIPF_EXPONENT = 0.99;				// Skew of author popularity.
+
+// Runs work(thread) on NUM_THREADS threads, started together, and returns the seconds taken.
+template <typename Work>
+double TimeThreads(Work work) {
+	std::atomic<bool> start(false);
+	std::vector<std::thread> threads;
+	for (unsigned t = 0; t < NUM_THREADS; ++t) {
+		threads.emplace_back([&, t]() {
+			while (!start.load()) {
+				std::this_thread::yield();
+			}
+			work(t);
+		});
+	}
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	start.store(true);
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+int main() {
+	std::vector<std::string> names(NUM_AUTHORS);
+	for (std::size_t i = 0; i < NUM_AUTHORS; ++i) {
+		names[i] = "Author " + std::to_string(i);
+	}
+	// The cumulative distribution of popularity, sampled by binary search. Author i has weight 1 / (i + 1) ^ ZIPF_EXPONENT.
+	std::vector<double> cumulative(NUM_AUTHORS);
+	double total = 0;
+	for (std::size_t i = 0; i < NUM_AUTHORS; ++i) {
+		total += 1.0 / std::pow(static_cast<double>(i + 1), ZIPF_EXPONENT);
+		cumulative[i] = total;
+	}
+	// Draw every thread's names up front, so that sampling is not timed.
+	std::vector<std::vector<std::uint32_t>> picks(NUM_THREADS, std::vector<std::uint32_t>(OPS_PER_THREAD));
+	for (unsigned t = 0; t < NUM_THREADS; ++t) {
+		std::mt19937_64 rng(t);
+		std::uniform_real_distribution<double> uniform(0, total);
+		for (std::uint32_t& pick : picks[t]) {
+			pick = static_cast<std::uint32_t>(std::lower_bound(cumulative.begin(), cumulative.end(), uniform(rng)) - cumulative.begin());
+		}
+	}
+	double ops = static_cast<double>(NUM_THREADS) * OPS_PER_THREAD;
+
+	std::mutex mutex;
+	std::unordered_map<std::string, std::uint32_t> locked;
+	double lockedSeconds = TimeThreads([&](unsigned t) {
+		for (std::uint32_t pick : picks[t]) {
+			// try_emplace only copies the name and builds a node when the author is new, as FindOrInsert does.
+			std::lock_guard<std::mutex> lock(mutex);
+			locked.try_emplace(names[pick], static_cast<std::uint32_t>(locked.size()));
+		}
+	});
+
+	ConcurrentMap<std::uint32_t> concurrent;
+	std::atomic<std::uint32_t> nextId(0);
+	double concurrentSeconds = TimeThreads([&](unsigned t) {
+		for (std::uint32_t pick : picks[t]) {
+			concurrent.FindOrInsert(names[pick], [&]() { return nextId++; });
+		}
+	});
+
+	std::cout << NUM_THREADS << " threads, " << NUM_AUTHORS << " authors, Zipf " << ZIPF_EXPONENT << "\n";
+	std::cout << "mutex + unordered_map: " << ops / lockedSeconds / 1e6 << " Mops/s, " << locked.size() << " authors\n";
+	std::cout << "ConcurrentMap:         " << ops / concurrentSeconds / 1e6 << " Mops/s, " << concurrent.Size() << " authors\n";
+}
@@ -0,0 +1,357 @@
+/****************************************************************
+* Author: Leo Carroll
+* Description:
+*	Differential checking of the catalog. A string of bytes is
+*	decoded into catalog operations, such as adding a person,
+*	adding, removing or editing a book, or constructing a Person
+*	from an array of Books. Every operation runs on the reference
+*	Person and Book, and on the LinkedPerson and LinkedBook of
+*	IntrusiveCatalog.h. After every operation both sides must
+*	print the same text and agree on the books of each author.
+*	The invariants of each side are checked too: booksWritten
+*	ends at its first nullptr, BookStats and the catalog-wide
+*	rollup match the books, and every list ends at its lastBook.
+*
+*	Any string of bytes is a valid program, so a fuzzer can
+*	mutate inputs freely. See CatalogFuzzer.cpp for the entry
+*	point.
+*
+*	The one intended difference is that a LinkedPerson has no
+*	limit on its books. An AddBook that the reference drops
+*	because booksWritten is full is not run on the linked side.
+* Date Created: 2026-10-18
+* Date Modified: 2026-10-18
+****************************************************************/
+
+#pragma once
+
+#include <cstddef>				// Included for std::size_t.
+#include <cstdint>				// Included for std::uint8_t and std::uint32_t.
+#include <memory>				// Included for std::unique_ptr.
+#include <sstream>				// Included for std::ostringstream.
+#include <string>				// Included for std::string.
+#include <vector>				// Included for std::vector.
+
+#include "Catalog.h"			// Included for Person, Book and CatalogStats.
+#include "IntrusiveCatalog.h"	// Included for LinkedCatalog.
+#include "StableStorage.h"		// Included for PersonStorage and BookStorage.
+
+// Bounds that keep one input fast, however long it is.
+constexpr std::size_t DIFFERENTIAL_MAX_PERSONS = 64;
+constexpr std::size_t DIFFERENTIAL_MAX_BOOKS = 4096;
+constexpr std::size_t DIFFERENTIAL_MAX_STRING = 24;
+
+// The operations that a byte decodes to, modulo their count.
+enum DifferentialOp : std::uint8_t {
+	DIFFERENTIAL_ADD_PERSON,
+	DIFFERENTIAL_ADD_BOOK,
+	DIFFERENTIAL_REMOVE_BOOK,
+	DIFFERENTIAL_REMOVE_FROM_OTHER,
+	DIFFERENTIAL_SET_PAGES,
+	DIFFERENTIAL_SET_TITLE,
+	DIFFERENTIAL_CONSTRUCT_PERSON,
+	DIFFERENTIAL_RELINK,
+	DIFFERENTIAL_NUM_OPS
+};
+
+// Reads bytes of an input in order. Past the end, every read returns zeros.
+struct DifferentialReader {
+	const std::uint8_t* data;		// The input.
+	std::size_t size;				// Bytes in the input.
+	std::size_t pos = 0;			// The next byte to read.
+
+	bool AtEnd() const { return this->pos >= this->size; }
+	std::uint8_t Byte() { return this->pos < this->size ? this->data[this->pos++] : 0; }
+	std::uint32_t Word();
+	std::string String();
+};
+
+// A reference book and the linked book that mirrors it.
+struct DifferentialBook {
+	Book* reference;			// The reference book.
+	LinkedBook* linked;			// The linked book, or nullptr if it is not on a list.
+	std::size_t author;			// Index of the author in the persons of the catalog.
+	bool listed;				// Whether the book is on its author's books on both sides.
+};
+
+// Both sides of the catalog, and the operations run on them.
+struct DifferentialCatalog {
+	PersonStorage persons;									// The reference authors.
+	BookStorage books;										// The reference books.
+	std::vector<std::unique_ptr<Book[]>> bookArrays;		// Arrays that constructed Persons point into.
+	CatalogStats rollup;									// Catalog-wide totals of the reference authors.
+	LinkedCatalog linked;									// The linked side.
+	std::vector<LinkedPerson*> linkedPersons;				// The linked author of each reference author.
+	std::vector<DifferentialBook> entries;					// Every book ever made, in order.
+	std::string failure;									// What went wrong, once a check failed.
+
+	// Default constructor
+	DifferentialCatalog() = default;
+	// Destructor, detaches the authors from the rollup as Person requires.
+	~DifferentialCatalog();
+
+	bool Run(const std::uint8_t*, std::size_t);
+	void Step(DifferentialReader&);
+	void AddPerson(const std::string&);
+	void AddBook(std::size_t, const std::string&, std::uint32_t);
+	void ConstructPerson(DifferentialReader&);
+	void Relink();
+	bool Check();
+	bool Fail(const std::string&);
+};
+
+// Reads a little-endian word of four bytes.
+inline std::uint32_t DifferentialReader::Word() {
+	std::uint32_t word = 0;
+	for (int i = 0; i < 4; ++i) {
+		word |= static_cast<std::uint32_t>(this->Byte()) << (8 * i);
+	}
+	return word;
+}
+
+// Reads a length byte and then up to DIFFERENTIAL_MAX_STRING bytes of text.
+inline std::string DifferentialReader::String() {
+	std::size_t length = this->Byte() % (DIFFERENTIAL_MAX_STRING + 1);
+	std::string text;
+	for (std::size_t i = 0; i < length && !this->AtEnd(); ++i) {
+		text.push_back(static_cast<char>(this->Byte()));
+	}
+	return text;
+}
+
+inline DifferentialCatalog::~DifferentialCatalog() {
+	for (Person& person : this->persons) {
+		person.SetRollup(nullptr);
+	}
+}
+
+// Runs every operation of the input, checking both sides after each one. Returns false, with the reason in failure, on
+// the first difference.
+inline bool DifferentialCatalog::Run(const std::uint8_t* data, std::size_t size) {
+	DifferentialReader reader{ data, size };
+	while (!reader.AtEnd()) {
+		this->Step(reader);
+		if (!this->Check()) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Decodes and runs one operation. Operations on authors or books that do not exist yet do nothing.
+inline void DifferentialCatalog::Step(DifferentialReader& reader) {
+	DifferentialOp op = static_cast<DifferentialOp>(reader.Byte() % DIFFERENTIAL_NUM_OPS);
+	std::size_t numPersons = this->linkedPersons.size();
+	std::size_t numEntries = this->entries.size();
+	switch (op) {
+	case DIFFERENTIAL_ADD_PERSON: {
+		std::string name = reader.String();
+		if (numPersons < DIFFERENTIAL_MAX_PERSONS) {
+			this->AddPerson(name);
+		}
+		break;
+	}
+	case DIFFERENTIAL_ADD_BOOK: {
+		std::size_t author = reader.Byte();
+		std::uint32_t pages = reader.Word();
+		std::string title = reader.String();
+		if (numPersons > 0 && numEntries < DIFFERENTIAL_MAX_BOOKS) {
+			this->AddBook(author % numPersons, title, pages);
+		}
+		break;
+	}
+	case DIFFERENTIAL_REMOVE_BOOK: {
+		std::size_t index = reader.Word();
+		if (numEntries > 0) {
+			DifferentialBook& entry = this->entries[index % numEntries];
+			bool removedReference = this->persons[entry.author].RemoveBook(entry.reference);
+			bool removedLinked = entry.linked && this->linkedPersons[entry.author]->RemoveBook(entry.linked);
+			if (removedReference != entry.listed || removedLinked != entry.listed) {
+				this->Fail("RemoveBook returned a different result");
+			}
+			entry.listed = false;
+		}
+		break;
+	}
+	case DIFFERENTIAL_REMOVE_FROM_OTHER: {
+		std::size_t index = reader.Word();
+		std::size_t other = reader.Byte();
+		if (numEntries > 0 && numPersons > 1) {
+			// A book is never on the list of an author other than its own, so both sides must refuse.
+			DifferentialBook& entry = this->entries[index % numEntries];
+			other = (entry.author + 1 + other % (numPersons - 1)) % numPersons;
+			if (this->persons[other].RemoveBook(entry.reference) || (entry.linked && this->linkedPersons[other]->RemoveBook(entry.linked))) {
+				this->Fail("RemoveBook removed a book of another author");
+			}
+		}
+		break;
+	}
+	case DIFFERENTIAL_SET_PAGES: {
+		std::size_t index = reader.Word();
+		std::uint32_t pages = reader.Word();
+		if (numEntries > 0) {
+			DifferentialBook& entry = this->entries[index % numEntries];
+			// Removed and dropped books are edited too. They still point at their author, whose totals must not change.
+			entry.reference->SetPages(pages);
+			if (entry.linked) {
+				entry.linked->numberOfPages = pages;
+			}
+		}
+		break;
+	}
+	case DIFFERENTIAL_SET_TITLE: {
+		std::size_t index = reader.Word();
+		std::string title = reader.String();
+		if (numEntries > 0) {
+			DifferentialBook& entry = this->entries[index % numEntries];
+			entry.reference->SetTitle(title);
+			if (entry.linked) {
+				entry.linked->title = title;
+			}
+		}
+		break;
+	}
+	case DIFFERENTIAL_CONSTRUCT_PERSON:
+		this->ConstructPerson(reader);
+		break;
+	case DIFFERENTIAL_RELINK:
+		this->Relink();
+		break;
+	default:
+		break;
+	}
+}
+
+inline void DifferentialCatalog::AddPerson(const std::string& name) {
+	Person& person = this->persons.Emplace();
+	person.name = name;
+	person.SetRollup(&this->rollup);
+	this->linkedPersons.push_back(&this->linked.AddPerson(name));
+}
+
+// Adds a book on both sides, unless the reference author is full.
+inline void DifferentialCatalog::AddBook(std::size_t author, const std::string& title, std::uint32_t pages) {
+	Person& person = this->persons[author];
+	Book& book = this->books.Emplace(&person, title, pages);
+	bool full = person.booksWritten[MAX_BOOKS_WRITTEN - 1] != nullptr;
+	person.AddBook(&book);
+	if (full) {
+		// Dropped by the reference. Keep the book, author-less on the linked side, so SetTitle still reaches it.
+		this->entries.push_back({ &book, nullptr, author, false });
+		return;
+	}
+	this->entries.push_back({ &book, &this->linked.AddBook(*this->linkedPersons[author], title, pages), author, true });
+}
+
+// Constructs a reference Person from an array of Books, and imports it into the linked side.
+inline void DifferentialCatalog::ConstructPerson(DifferentialReader& reader) {
+	std::size_t numBooks = reader.Byte() % (MAX_BOOKS_WRITTEN + 1);
+	std::string name = reader.String();
+	if (this->linkedPersons.size() >= DIFFERENTIAL_MAX_PERSONS || this->entries.size() + numBooks > DIFFERENTIAL_MAX_BOOKS) {
+		return;
+	}
+	std::unique_ptr<Book[]> array(new Book[numBooks == 0 ? 1 : numBooks]);
+	for (std::size_t i = 0; i < numBooks; ++i) {
+		array[i].title = reader.String();
+		array[i].numberOfPages = reader.Word();
+	}
+	std::size_t author = this->linkedPersons.size();
+	Person& person = this->persons.Emplace(numBooks ? array.get() : nullptr, numBooks, name);
+	for (std::size_t i = 0; i < numBooks; ++i) {
+		array[i].author = &person;		// The books had to exist before their author.
+	}
+	person.SetRollup(&this->rollup);
+	LinkedPerson& linked = this->linked.Import(person);
+	this->linkedPersons.push_back(&linked);
+	LinkedBook* book = linked.firstBook;
+	for (std::size_t i = 0; i < numBooks; ++i, book = book->nextBook) {
+		this->entries.push_back({ &array[i], book, author, true });
+	}
+	this->bookArrays.push_back(std::move(array));
+}
+
+// Relinks the linked side, and finds the new address of every listed book by walking both sides together.
+inline void DifferentialCatalog::Relink() {
+	this->linked.Relink();
+	std::vector<std::vector<std::size_t>> byAuthor(this->linkedPersons.size());
+	for (DifferentialBook& entry : this->entries) {
+		entry.linked = nullptr;
+	}
+	// An author's listed entries are in list order, since books are only ever appended and removed.
+	for (std::size_t i = 0; i < this->entries.size(); ++i) {
+		if (this->entries[i].listed) {
+			byAuthor[this->entries[i].author].push_back(i);
+		}
+	}
+	for (std::size_t author = 0; author < byAuthor.size(); ++author) {
+		LinkedBook* book = this->linkedPersons[author]->firstBook;
+		for (std::size_t i = 0; i < byAuthor[author].size() && book; ++i, book = book->nextBook) {
+			this->entries[byAuthor[author][i]].linked = book;
+		}
+	}
+}
+
+// Compares both sides, and checks the invariants of each.
+inline bool DifferentialCatalog::Check() {
+	if (!this->failure.empty()) {
+		return false;
+	}
+	CatalogStats expected;
+	for (std::size_t author = 0; author < this->linkedPersons.size(); ++author) {
+		const Person& person = this->persons[author];
+		const LinkedPerson& linked = *this->linkedPersons[author];
+		std::ostringstream referenceText;
+		std::ostringstream linkedText;
+		referenceText << person;
+		linkedText << linked;
+		if (referenceText.str() != linkedText.str()) {
+			return this->Fail("Output differs for author " + std::to_string(author) + ":\n" + referenceText.str() + "\n---\n" + linkedText.str());
+		}
+		// booksWritten is in use up to its first nullptr, and empty after it.
+		std::size_t numBooks = 0;
+		while (numBooks < MAX_BOOKS_WRITTEN && person.booksWritten[numBooks]) {
+			++numBooks;
+		}
+		for (std::size_t idx = numBooks; idx < MAX_BOOKS_WRITTEN; ++idx) {
+			if (person.booksWritten[idx]) {
+				return this->Fail("booksWritten has a book after a nullptr");
+			}
+		}
+		BookStats stats;
+		for (std::size_t idx = 0; idx < numBooks; ++idx) {
+			stats.Add(person.booksWritten[idx]->numberOfPages);
+			expected.Add(person.booksWritten[idx]->numberOfPages);
+		}
+		if (stats.count != person.stats.count || stats.totalPages != person.stats.totalPages || stats.minPages != person.stats.minPages || stats.maxPages != person.stats.maxPages) {
+			return this->Fail("BookStats is out of date for author " + std::to_string(author));
+		}
+		// The linked list holds numBooks books of this author and ends at lastBook.
+		const LinkedBook* last = nullptr;
+		const LinkedBook* book = linked.firstBook;
+		std::size_t numLinked = 0;
+		for (; book && numLinked < numBooks; book = book->nextBook) {
+			if (book->author != &linked || book->numberOfPages != person.booksWritten[numLinked]->numberOfPages) {
+				return this->Fail("A linked book differs from its reference book");
+			}
+			last = book;
+			++numLinked;
+		}
+		if (book || numLinked != numBooks || linked.numBooks != numBooks || linked.lastBook != last) {
+			return this->Fail("The linked list of author " + std::to_string(author) + " is malformed");
+		}
+	}
+	if (expected.books.count != this->rollup.books.count || expected.books.totalPages != this->rollup.books.totalPages ||
+		expected.books.minPages != this->rollup.books.minPages || expected.books.maxPages != this->rollup.books.maxPages ||
+		this->rollup.numAuthors != this->linkedPersons.size()) {
+		return this->Fail("The catalog-wide rollup is out of date");
+	}
+	return true;
+}
+
+// Records the first failure, and returns false.
+inline bool DifferentialCatalog::Fail(const std::string& message) {
+	if (this->failure.empty()) {
+		this->failure = message;
+	}
+	return false;
+}
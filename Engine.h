@@ -0,0 +1,343 @@
+/****************************************************************
+* Author: Leo Carroll
+* Description:
+*	A batch-at-a-time execution engine over the books of a
+*	catalog. BookColumns copies the books into one array per
+*	field, and a book is then just its row id. Operators pull
+*	BookBatch objects of up to BOOK_BATCH_SIZE row ids from
+*	their child, with a selection vector saying which rows are
+*	still alive, so each operator runs one tight loop per batch
+*	instead of one virtual call per book.
+*
+*	The operators are scan, filter, project, aggregate, sort
+*	and limit. For example, total pages per author of books
+*	over 400 pages, largest first:
+*
+*	Sort(Aggregate(Project(Filter(Scan(c), c, PagesInRange{ 401, UINT32_MAX }), c, PagesValue()),
+*		c, AuthorKey(), AggregateKind::Sum), true)
+* Date Created: 2026-10-18
+* Date Modified: 2026-10-18
+****************************************************************/
+
+#pragma once
+
+#include <algorithm>		// Included for std::stable_sort, std::min and std::max.
+#include <cstddef>			// Included for std::size_t.
+#include <cstdint>			// Included for std::uint16_t, std::uint32_t and std::uint64_t.
+#include <memory>			// Included for std::unique_ptr.
+#include <string>			// Included for std::string.
+#include <unordered_map>	// Included for std::unordered_map.
+#include <utility>			// Included for std::move and std::pair.
+#include <vector>			// Included for std::vector.
+
+#include "Catalog.h"		// Included for Person, Book and BOOK_BATCH_SIZE.
+
+// The books of a catalog stored one column per field. Row i of every column is the same book.
+struct BookColumns {
+	std::vector<std::uint32_t> pages;			// numberOfPages of each book.
+	std::vector<std::uint32_t> authorIds;		// Index into authors of each book's author.
+	std::vector<Book*> books;					// The book itself, for fields that are not copied into a column.
+	std::vector<const Person*> authors;			// Every author, indexed by author id.
+
+	void AddPerson(const Person&);
+};
+
+// A batch of rows passed between operators.
+struct BookBatch {
+	std::size_t count = 0;						// Number of rows in ids and values.
+	std::size_t selected = 0;					// Number of entries in sel.
+	bool contiguous = false;					// Whether ids[i] == ids[0] + i, so columns can be read without a gather.
+	std::uint32_t ids[BOOK_BATCH_SIZE];			// The row id of each row. After an aggregate, the first row id of each group.
+	std::uint64_t values[BOOK_BATCH_SIZE];		// The projected value of each row. After an aggregate, the aggregate of each group.
+	std::uint16_t sel[BOOK_BATCH_SIZE];			// The rows that are still alive, as ascending indexes into ids.
+};
+
+// The interface that every operator implements. Next fills batch and returns false once there are no more rows.
+// A returned batch may have no rows selected.
+struct BatchOperator {
+	virtual ~BatchOperator() = default;
+	virtual bool Next(BookBatch&) = 0;
+};
+
+using BatchOperatorPtr = std::unique_ptr<BatchOperator>;
+
+// Adds every book that the person has written, and the person as a new author id.
+inline void BookColumns::AddPerson(const Person& person) {
+	std::uint32_t authorId = static_cast<std::uint32_t>(this->authors.size());
+	this->authors.push_back(&person);
+	for (std::size_t idx = 0; idx < MAX_BOOKS_WRITTEN && person.booksWritten[idx]; ++idx) {
+		this->pages.push_back(person.booksWritten[idx]->numberOfPages);
+		this->authorIds.push_back(authorId);
+		this->books.push_back(person.booksWritten[idx]);
+	}
+}
+
+// Produces every row of the columns in order.
+struct ScanOperator : BatchOperator {
+	const BookColumns* columns;		// The columns being scanned.
+	std::size_t next = 0;			// The next row id to produce.
+
+	explicit ScanOperator(const BookColumns& columns) : columns(&columns) {}
+	bool Next(BookBatch& batch) override {
+		std::size_t total = this->columns->pages.size();
+		if (this->next >= total) {
+			return false;
+		}
+		batch.count = std::min(BOOK_BATCH_SIZE, total - this->next);
+		batch.selected = batch.count;
+		batch.contiguous = true;
+		for (std::size_t i = 0; i < batch.count; ++i) {
+			batch.ids[i] = static_cast<std::uint32_t>(this->next + i);
+			batch.values[i] = 0;
+			batch.sel[i] = static_cast<std::uint16_t>(i);
+		}
+		this->next += batch.count;
+		return true;
+	}
+};
+
+// Keeps the selected rows for which pred(columns, rowId) is true. Pred is inlined into the loop.
+template <typename Pred>
+struct FilterOperator : BatchOperator {
+	BatchOperatorPtr child;			// Where rows come from.
+	const BookColumns* columns;		// The columns that the predicate reads.
+	Pred pred;						// The filter.
+
+	FilterOperator(BatchOperatorPtr child, const BookColumns& columns, Pred pred) : child(std::move(child)), columns(&columns), pred(std::move(pred)) {}
+	bool Next(BookBatch& batch) override {
+		if (!this->child->Next(batch)) {
+			return false;
+		}
+		// Narrow the selection in place, writing every entry and only keeping the ones that pass.
+		std::size_t n = 0;
+		for (std::size_t i = 0; i < batch.selected; ++i) {
+			std::uint16_t idx = batch.sel[i];
+			batch.sel[n] = idx;
+			n += this->pred(*this->columns, batch.ids[idx]) ? 1 : 0;
+		}
+		batch.selected = n;
+		return true;
+	}
+};
+
+// Keeps books whose page count is in [minPages, maxPages]. minPages must not be more than maxPages.
+struct PagesInRange {
+	std::uint32_t minPages;
+	std::uint32_t maxPages;
+
+	bool operator()(const BookColumns& columns, std::uint32_t id) const {
+		// One unsigned compare covers both ends of the range.
+		return columns.pages[id] - this->minPages <= this->maxPages - this->minPages;
+	}
+};
+
+// Keeps books by one author.
+struct AuthorIdIs {
+	std::uint32_t authorId;
+
+	bool operator()(const BookColumns& columns, std::uint32_t id) const { return columns.authorIds[id] == this->authorId; }
+};
+
+// Adapts a Predicate.h predicate on a Book, for fields that are not in a column.
+template <typename BookPred>
+struct BookPredicateOnColumns {
+	BookPred pred;
+
+	bool operator()(const BookColumns& columns, std::uint32_t id) const { return this->pred(*columns.books[id]); }
+};
+
+// Sets values[i] = func(columns, rowId) for every selected row.
+template <typename Func>
+struct ProjectOperator : BatchOperator {
+	BatchOperatorPtr child;			// Where rows come from.
+	const BookColumns* columns;		// The columns that the function reads.
+	Func func;						// Computes the value of a row.
+
+	ProjectOperator(BatchOperatorPtr child, const BookColumns& columns, Func func) : child(std::move(child)), columns(&columns), func(std::move(func)) {}
+	bool Next(BookBatch& batch) override {
+		if (!this->child->Next(batch)) {
+			return false;
+		}
+		if (batch.contiguous && batch.selected == batch.count) {
+			// Every row of a scan is selected, so the loop has no indirection through sel.
+			for (std::size_t i = 0; i < batch.count; ++i) {
+				batch.values[i] = this->func(*this->columns, batch.ids[i]);
+			}
+		}
+		else {
+			for (std::size_t i = 0; i < batch.selected; ++i) {
+				batch.values[batch.sel[i]] = this->func(*this->columns, batch.ids[batch.sel[i]]);
+			}
+		}
+		return true;
+	}
+};
+
+// The value of a row is its page count.
+struct PagesValue {
+	std::uint64_t operator()(const BookColumns& columns, std::uint32_t id) const { return columns.pages[id]; }
+};
+
+// The group of a row is its author.
+struct AuthorKey {
+	std::uint64_t operator()(const BookColumns& columns, std::uint32_t id) const { return columns.authorIds[id]; }
+};
+
+enum class AggregateKind { Count, Sum, Min, Max };
+
+// Groups the selected rows by key(columns, rowId) and combines their values. Produces one row per group, in the order groups
+// were first seen, with ids set to the first row of the group and values to the aggregate.
+template <typename Key>
+struct AggregateOperator : BatchOperator {
+	BatchOperatorPtr child;			// Where rows come from.
+	const BookColumns* columns;		// The columns that the key reads.
+	Key key;						// Computes the group of a row.
+	AggregateKind kind;				// How values are combined.
+	std::vector<std::pair<std::uint32_t, std::uint64_t>> groups;		// The first row id and aggregate of each group.
+	std::size_t next = 0;			// The next group to produce.
+	bool consumed = false;			// Whether the child has been read to the end.
+
+	AggregateOperator(BatchOperatorPtr child, const BookColumns& columns, Key key, AggregateKind kind)
+		: child(std::move(child)), columns(&columns), key(std::move(key)), kind(kind) {}
+	bool Next(BookBatch& batch) override {
+		if (!this->consumed) {
+			this->Consume();
+		}
+		if (this->next >= this->groups.size()) {
+			return false;
+		}
+		batch.count = std::min(BOOK_BATCH_SIZE, this->groups.size() - this->next);
+		batch.selected = batch.count;
+		batch.contiguous = false;
+		for (std::size_t i = 0; i < batch.count; ++i) {
+			batch.ids[i] = this->groups[this->next + i].first;
+			batch.values[i] = this->groups[this->next + i].second;
+			batch.sel[i] = static_cast<std::uint16_t>(i);
+		}
+		this->next += batch.count;
+		return true;
+	}
+
+	// Reads every batch of the child into groups.
+	void Consume() {
+		std::unordered_map<std::uint64_t, std::size_t> slots;		// Index into groups of each key.
+		BookBatch input;
+		while (this->child->Next(input)) {
+			for (std::size_t i = 0; i < input.selected; ++i) {
+				std::uint16_t idx = input.sel[i];
+				std::pair<std::unordered_map<std::uint64_t, std::size_t>::iterator, bool> slot =
+					slots.emplace(this->key(*this->columns, input.ids[idx]), this->groups.size());
+				std::uint64_t value = this->kind == AggregateKind::Count ? 1 : input.values[idx];
+				if (slot.second) {
+					this->groups.emplace_back(input.ids[idx], value);
+					continue;
+				}
+				std::uint64_t& aggregate = this->groups[slot.first->second].second;
+				switch (this->kind) {
+				case AggregateKind::Count: case AggregateKind::Sum: aggregate += value; break;
+				case AggregateKind::Min: aggregate = std::min(aggregate, value); break;
+				case AggregateKind::Max: aggregate = std::max(aggregate, value); break;
+				}
+			}
+		}
+		this->consumed = true;
+	}
+};
+
+// Reads every selected row of the child and produces them again ordered by value.
+// Ties keep the order that they arrived in.
+struct SortOperator : BatchOperator {
+	BatchOperatorPtr child;			// Where rows come from.
+	bool descending;				// Whether the largest value comes first.
+	std::vector<std::pair<std::uint64_t, std::uint32_t>> rows;		// The value and row id of every row.
+	std::size_t next = 0;			// The next row to produce.
+	bool consumed = false;			// Whether the child has been read and sorted.
+
+	SortOperator(BatchOperatorPtr child, bool descending) : child(std::move(child)), descending(descending) {}
+	bool Next(BookBatch& batch) override {
+		if (!this->consumed) {
+			BookBatch input;
+			while (this->child->Next(input)) {
+				for (std::size_t i = 0; i < input.selected; ++i) {
+					this->rows.emplace_back(input.values[input.sel[i]], input.ids[input.sel[i]]);
+				}
+			}
+			bool descending = this->descending;
+			std::stable_sort(this->rows.begin(), this->rows.end(), [descending](const std::pair<std::uint64_t, std::uint32_t>& a, const std::pair<std::uint64_t, std::uint32_t>& b) {
+				return descending ? b.first < a.first : a.first < b.first;
+			});
+			this->consumed = true;
+		}
+		if (this->next >= this->rows.size()) {
+			return false;
+		}
+		batch.count = std::min(BOOK_BATCH_SIZE, this->rows.size() - this->next);
+		batch.selected = batch.count;
+		batch.contiguous = false;
+		for (std::size_t i = 0; i < batch.count; ++i) {
+			batch.values[i] = this->rows[this->next + i].first;
+			batch.ids[i] = this->rows[this->next + i].second;
+			batch.sel[i] = static_cast<std::uint16_t>(i);
+		}
+		this->next += batch.count;
+		return true;
+	}
+};
+
+// Passes on the first limit selected rows of the child and stops pulling from it after that.
+struct LimitOperator : BatchOperator {
+	BatchOperatorPtr child;			// Where rows come from.
+	std::size_t remaining;			// Selected rows still allowed through.
+
+	LimitOperator(BatchOperatorPtr child, std::size_t limit) : child(std::move(child)), remaining(limit) {}
+	bool Next(BookBatch& batch) override {
+		if (this->remaining == 0 || !this->child->Next(batch)) {
+			return false;
+		}
+		if (batch.selected > this->remaining) {
+			batch.selected = this->remaining;
+		}
+		this->remaining -= batch.selected;
+		return true;
+	}
+};
+
+// Functions that build operators, so that a plan reads as nested calls.
+inline BatchOperatorPtr Scan(const BookColumns& columns) {
+	return BatchOperatorPtr(new ScanOperator(columns));
+}
+
+template <typename Pred>
+inline BatchOperatorPtr Filter(BatchOperatorPtr child, const BookColumns& columns, Pred pred) {
+	return BatchOperatorPtr(new FilterOperator<Pred>(std::move(child), columns, std::move(pred)));
+}
+
+template <typename Func>
+inline BatchOperatorPtr Project(BatchOperatorPtr child, const BookColumns& columns, Func func) {
+	return BatchOperatorPtr(new ProjectOperator<Func>(std::move(child), columns, std::move(func)));
+}
+
+template <typename Key>
+inline BatchOperatorPtr Aggregate(BatchOperatorPtr child, const BookColumns& columns, Key key, AggregateKind kind) {
+	return BatchOperatorPtr(new AggregateOperator<Key>(std::move(child), columns, std::move(key), kind));
+}
+
+inline BatchOperatorPtr Sort(BatchOperatorPtr child, bool descending = false) {
+	return BatchOperatorPtr(new SortOperator(std::move(child), descending));
+}
+
+inline BatchOperatorPtr Limit(BatchOperatorPtr child, std::size_t limit) {
+	return BatchOperatorPtr(new LimitOperator(std::move(child), limit));
+}
+
+// Runs the plan to the end and returns the row id and value of every selected row.
+inline std::vector<std::pair<std::uint32_t, std::uint64_t>> Collect(BatchOperator& root) {
+	std::vector<std::pair<std::uint32_t, std::uint64_t>> rows;
+	BookBatch batch;
+	while (root.Next(batch)) {
+		for (std::size_t i = 0; i < batch.selected; ++i) {
+			rows.emplace_back(batch.ids[batch.sel[i]], batch.values[batch.sel[i]]);
+		}
+	}
+	return rows;
+}
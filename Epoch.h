@@ -0,0 +1,196 @@
+/****************************************************************
+* Author: Leo Carroll
+* Description:
+*	Epoch-based reclamation of Persons and Books that are read
+*	by other threads while they are removed. A reader wraps its
+*	traversal of booksWritten or Book::author in an EpochGuard,
+*	which publishes the global epoch in the thread's record. A
+*	writer unlinks an object, for example with RemoveBook, and
+*	passes it to Retire instead of deleting it.
+*
+*	Retired objects wait in one of three lists per thread, by
+*	the epoch they were retired in. The global epoch only moves
+*	from e to e + 1 once every thread inside a guard has seen e,
+*	so once it reaches e + 2 no reader can still hold an object
+*	retired in e, and the list of e is freed as a batch. Every
+*	EPOCH_BATCH retirements the retiring thread tries to move the
+*	epoch on.
+*
+*	A thread's record and its retired objects stay with the
+*	domain after the thread exits, and are freed with it.
+* Date Created: 2026-10-18
+* Date Modified: 2026-10-18
+****************************************************************/
+
+#pragma once
+
+#include <atomic>			// Included for std::atomic.
+#include <cstddef>			// Included for std::size_t.
+#include <cstdint>			// Included for std::uint64_t.
+#include <utility>			// Included for std::pair.
+#include <vector>			// Included for std::vector.
+
+// Number of retirements between attempts to move the global epoch on.
+constexpr std::size_t EPOCH_BATCH = 64;
+
+// An object waiting to be freed, with the function that frees it.
+struct EpochRetired {
+	void* object;					// The object.
+	void (*destroy)(void*);			// Frees the object.
+};
+
+// The state of one thread in one domain.
+struct EpochThread {
+	std::atomic<std::uint64_t> epoch{ 0 };		// The global epoch seen on entering a guard, or 0 outside of every guard.
+	std::uint32_t depth = 0;					// Number of guards the thread is inside. Only the outermost publishes.
+	std::vector<EpochRetired> limbo[3];			// Retired objects, by epoch modulo 3.
+	std::uint64_t limboEpoch[3] = { 0, 0, 0 };	// The epoch that the objects in each list were retired in.
+	std::size_t sinceAdvance = 0;				// Retirements since the last attempt to move the epoch on.
+	EpochThread* next = nullptr;				// The next record of the domain.
+};
+
+// A set of threads that share objects, and the epoch they are reclaimed by.
+struct EpochDomain {
+	std::atomic<std::uint64_t> globalEpoch{ 1 };	// The current epoch. Starts at 1, as 0 means outside of every guard.
+	std::atomic<EpochThread*> threads{ nullptr };	// Every thread record, newest first. Records are only ever added.
+	std::uint64_t id;								// Tells domains apart in the threads' caches of their records.
+
+	// Default constructor
+	EpochDomain();
+	// Destructor, frees every retired object. No thread may be inside a guard.
+	~EpochDomain();
+	EpochDomain(const EpochDomain&) = delete;
+	EpochDomain& operator=(const EpochDomain&) = delete;
+
+	EpochThread& Local();
+	void Enter(EpochThread&);
+	void Leave(EpochThread&);
+	void Retire(void*, void (*)(void*));
+	template <typename T>
+	void Retire(T*);
+	bool TryAdvance();
+	void Collect(EpochThread&);
+};
+
+// Keeps the calling thread inside the domain's current epoch for its lifetime, so nothing it can reach is freed.
+struct EpochGuard {
+	EpochDomain& domain;		// The domain.
+	EpochThread& thread;		// The calling thread's record.
+
+	explicit EpochGuard(EpochDomain& domain) : domain(domain), thread(domain.Local()) {
+		this->domain.Enter(this->thread);
+	}
+	~EpochGuard() {
+		this->domain.Leave(this->thread);
+	}
+	EpochGuard(const EpochGuard&) = delete;
+	EpochGuard& operator=(const EpochGuard&) = delete;
+};
+
+// EpochDomain default constructor
+inline EpochDomain::EpochDomain() {
+	static std::atomic<std::uint64_t> nextId(0);
+	this->id = nextId++;
+}
+
+inline EpochDomain::~EpochDomain() {
+	EpochThread* record = this->threads.load(std::memory_order_acquire);
+	while (record) {
+		for (std::vector<EpochRetired>& limbo : record->limbo) {
+			for (const EpochRetired& retired : limbo) {
+				retired.destroy(retired.object);
+			}
+		}
+		EpochThread* next = record->next;
+		delete record;
+		record = next;
+	}
+}
+
+// Returns the calling thread's record, creating it on first use.
+inline EpochThread& EpochDomain::Local() {
+	// A thread usually uses one domain, so a short list beats a map. Ids are never reused, so stale entries never match.
+	thread_local std::vector<std::pair<std::uint64_t, EpochThread*>> cache;
+	for (const std::pair<std::uint64_t, EpochThread*>& entry : cache) {
+		if (entry.first == this->id) {
+			return *entry.second;
+		}
+	}
+	EpochThread* record = new EpochThread();
+	record->next = this->threads.load(std::memory_order_relaxed);
+	while (!this->threads.compare_exchange_weak(record->next, record, std::memory_order_release, std::memory_order_relaxed)) {
+	}
+	cache.push_back({ this->id, record });
+	return *record;
+}
+
+// Publishes the global epoch in the thread's record. The loop catches the epoch moving on between the load and the
+// store, which would otherwise leave a published epoch that TryAdvance had already counted the thread out of.
+inline void EpochDomain::Enter(EpochThread& thread) {
+	if (thread.depth++ > 0) {
+		return;
+	}
+	std::uint64_t epoch = this->globalEpoch.load(std::memory_order_seq_cst);
+	while (true) {
+		thread.epoch.store(epoch, std::memory_order_seq_cst);
+		std::uint64_t current = this->globalEpoch.load(std::memory_order_seq_cst);
+		if (current == epoch) {
+			return;
+		}
+		epoch = current;
+	}
+}
+
+inline void EpochDomain::Leave(EpochThread& thread) {
+	if (--thread.depth == 0) {
+		thread.epoch.store(0, std::memory_order_release);
+	}
+}
+
+// Moves the global epoch on if every thread inside a guard has seen it. Returns false if some thread is behind.
+inline bool EpochDomain::TryAdvance() {
+	std::uint64_t epoch = this->globalEpoch.load(std::memory_order_seq_cst);
+	for (EpochThread* record = this->threads.load(std::memory_order_acquire); record; record = record->next) {
+		std::uint64_t seen = record->epoch.load(std::memory_order_seq_cst);
+		if (seen != 0 && seen != epoch) {
+			return false;
+		}
+	}
+	return this->globalEpoch.compare_exchange_strong(epoch, epoch + 1, std::memory_order_seq_cst);
+}
+
+// Frees the calling thread's retired objects that no reader can hold any more.
+inline void EpochDomain::Collect(EpochThread& thread) {
+	std::uint64_t epoch = this->globalEpoch.load(std::memory_order_seq_cst);
+	for (int i = 0; i < 3; ++i) {
+		if (thread.limboEpoch[i] + 2 <= epoch && !thread.limbo[i].empty()) {
+			for (const EpochRetired& retired : thread.limbo[i]) {
+				retired.destroy(retired.object);
+			}
+			thread.limbo[i].clear();
+		}
+	}
+}
+
+// Frees the object once no reader can hold it. The object must already be unreachable for new readers.
+inline void EpochDomain::Retire(void* object, void (*destroy)(void*)) {
+	EpochThread& thread = this->Local();
+	if (++thread.sinceAdvance >= EPOCH_BATCH) {
+		thread.sinceAdvance = 0;
+		this->TryAdvance();
+	}
+	std::uint64_t epoch = this->globalEpoch.load(std::memory_order_seq_cst);
+	std::size_t list = static_cast<std::size_t>(epoch % 3);
+	if (thread.limboEpoch[list] != epoch) {
+		// The list holds objects of epoch - 3 or earlier, which are safe to free, and is reused for this epoch.
+		this->Collect(thread);
+		thread.limboEpoch[list] = epoch;
+	}
+	thread.limbo[list].push_back({ object, destroy });
+}
+
+// Deletes the object, for example a Person or a Book, once no reader can hold it.
+template <typename T>
+inline void EpochDomain::Retire(T* object) {
+	this->Retire(static_cast<void*>(object), [](void* retired) { delete static_cast<T*>(retired); });
+}
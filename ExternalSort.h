@@ -0,0 +1,451 @@
+/****************************************************************
+* Author: Leo Carroll
+* Description:
+*	External sorting of book records for catalogs that do not
+*	fit in memory. Records are collected until a memory budget
+*	is reached, sorted and written to a run file on disk. Run
+*	files are compressed: records are in order, so each string
+*	is stored as the length it shares with the same string of
+*	the previous record plus the rest, and numbers are stored
+*	as varints. The runs are then merged with a loser tree,
+*	which takes one comparison per level for every record.
+*
+*	A merge reads each run through a buffer of its own, so it
+*	only merges as many runs at once as the budget has buffers
+*	of EXTERNAL_SORT_MIN_BUFFER for. With more runs than that,
+*	the oldest are merged into a new run first, pass by pass,
+*	so open files and memory stay bounded however large the
+*	input is.
+*
+*	Records are copies of the author name, title and page count,
+*	so they do not need the Persons and Books to stay in memory.
+* Date Created: 2026-10-18
+* Date Modified: 2026-10-18
+****************************************************************/
+
+#pragma once
+
+#include <algorithm>		// Included for std::sort.
+#include <cstddef>			// Included for std::size_t.
+#include <cstdint>			// Included for std::uint32_t and std::uint64_t.
+#include <cstdio>			// Included for std::remove.
+#include <fstream>			// Included for std::ifstream and std::ofstream.
+#include <string>			// Included for std::string.
+#include <utility>			// Included for std::move.
+#include <vector>			// Included for std::vector.
+
+#ifdef _WIN32
+#include <process.h>		// Included for _getpid.
+#else
+#include <unistd.h>			// Included for getpid.
+#endif
+
+#include "Catalog.h"		// Included for Person and Book.
+#include "ParallelSort.h"	// Included for CatalogSortKey.
+
+// The smallest read buffer a merge gives a run. The budget decides how many runs are merged at once.
+constexpr std::size_t EXTERNAL_SORT_MIN_BUFFER = 64 * 1024;
+
+// A book copied out of the catalog.
+struct BookRecord {
+	std::string author;				// Name of the author, empty if the book has none.
+	std::string title;				// Title of the book.
+	std::uint32_t numberOfPages = 0;	// Number of pages in the book.
+};
+
+// Returns true if a comes before b in the given order. The orders are the same as CatalogLess.
+inline bool BookRecordLess(const BookRecord& a, const BookRecord& b, CatalogSortKey key) {
+	int cmp = 0;
+	switch (key) {
+	case CatalogSortKey::Pages:
+		if (a.numberOfPages != b.numberOfPages) return a.numberOfPages < b.numberOfPages;
+		cmp = a.title.compare(b.title);
+		return cmp != 0 ? cmp < 0 : a.author < b.author;
+	case CatalogSortKey::Title:
+		cmp = a.title.compare(b.title);
+		if (cmp != 0) return cmp < 0;
+		cmp = a.author.compare(b.author);
+		return cmp != 0 ? cmp < 0 : a.numberOfPages < b.numberOfPages;
+	case CatalogSortKey::Author:
+		cmp = a.author.compare(b.author);
+		if (cmp != 0) return cmp < 0;
+		cmp = a.title.compare(b.title);
+		return cmp != 0 ? cmp < 0 : a.numberOfPages < b.numberOfPages;
+	}
+	return false;
+}
+
+// Appends value to out as a varint, 7 bits per byte with the high bit set on every byte but the last.
+inline void AppendVarint(std::string& out, std::uint64_t value) {
+	while (value >= 0x80) {
+		out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+		value >>= 7;
+	}
+	out.push_back(static_cast<char>(value));
+}
+
+// Appends str to out as the length it shares with previous, then the length and bytes of the rest.
+inline void AppendFrontCoded(std::string& out, const std::string& str, const std::string& previous) {
+	std::size_t shared = 0;
+	std::size_t most = std::min(str.size(), previous.size());
+	while (shared < most && str[shared] == previous[shared]) {
+		++shared;
+	}
+	AppendVarint(out, shared);
+	AppendVarint(out, str.size() - shared);
+	out.append(str, shared, std::string::npos);
+}
+
+// Returns the path of run file index in directory, for the sorter or catalog at owner.
+// The process id keeps two processes sharing a directory apart, and the owner address keeps two owners in one process apart.
+inline std::string RunFilePath(const std::string& directory, const char* prefix, const void* owner, std::size_t index) {
+#ifdef _WIN32
+	long long pid = _getpid();
+#else
+	long long pid = getpid();
+#endif
+	return directory + "/" + prefix + "-" + std::to_string(pid) + "-" + std::to_string(reinterpret_cast<std::uintptr_t>(owner)) + "-" + std::to_string(index) + ".tmp";
+}
+
+// Writes sorted records to a run file, compressed, through a buffer of a fixed size.
+struct RunWriter {
+	std::ofstream file;			// The run file.
+	std::string out;			// Encoded bytes not yet written, written to the file in large sequential chunks.
+	std::size_t bufferSize = 0;	// Bytes to collect in out before writing them.
+	BookRecord previous;		// The last record written, that the next one is coded against.
+
+	bool Open(const std::string&, std::size_t);
+	bool Append(const BookRecord&);
+	bool Close();
+};
+
+inline bool RunWriter::Open(const std::string& path, std::size_t bufferSize) {
+	this->file.open(path, std::ios::binary | std::ios::trunc);
+	this->bufferSize = bufferSize;
+	this->out.reserve(bufferSize);
+	return this->file.is_open();
+}
+
+// Appends a record, which must not come before the previous one. Returns false if the file could not be written.
+inline bool RunWriter::Append(const BookRecord& record) {
+	AppendFrontCoded(this->out, record.author, this->previous.author);
+	AppendFrontCoded(this->out, record.title, this->previous.title);
+	AppendVarint(this->out, record.numberOfPages);
+	this->previous = record;
+	if (this->out.size() >= this->bufferSize) {
+		this->file.write(this->out.data(), static_cast<std::streamsize>(this->out.size()));
+		this->out.clear();
+	}
+	return static_cast<bool>(this->file);
+}
+
+// Writes what is left in the buffer and closes the file. Returns false if the run is not completely on disk.
+inline bool RunWriter::Close() {
+	this->file.write(this->out.data(), static_cast<std::streamsize>(this->out.size()));
+	this->out.clear();
+	this->file.close();
+	return static_cast<bool>(this->file);
+}
+
+// Reads the records of one run file back, through a buffer of a fixed size.
+struct RunReader {
+	std::ifstream file;			// The run file.
+	std::vector<char> buffer;	// Bytes read from the file and not yet decoded.
+	std::size_t pos = 0;		// Position of the next byte to decode in buffer.
+	std::size_t end = 0;		// Number of bytes in buffer.
+	BookRecord current;			// The last record read. Also the previous record that the next one is coded against.
+	bool corrupt = false;		// Whether the run ended in the middle of a record.
+
+	bool Open(const std::string&, std::size_t);
+	bool Next();
+	bool ReadByte(unsigned char&);
+	bool ReadVarint(std::uint64_t&);
+	bool ReadFrontCoded(std::string&);
+};
+
+inline bool RunReader::Open(const std::string& path, std::size_t bufferSize) {
+	this->file.open(path, std::ios::binary);
+	this->buffer.resize(bufferSize);
+	return this->file.is_open();
+}
+
+// Returns the next byte, refilling the buffer when it runs out.
+inline bool RunReader::ReadByte(unsigned char& byte) {
+	if (this->pos == this->end) {
+		this->file.read(this->buffer.data(), static_cast<std::streamsize>(this->buffer.size()));
+		this->end = static_cast<std::size_t>(this->file.gcount());
+		this->pos = 0;
+		if (this->end == 0) {
+			return false;
+		}
+	}
+	byte = static_cast<unsigned char>(this->buffer[this->pos++]);
+	return true;
+}
+
+inline bool RunReader::ReadVarint(std::uint64_t& value) {
+	value = 0;
+	unsigned char byte = 0;
+	for (unsigned shift = 0; shift < 64; shift += 7) {
+		if (!this->ReadByte(byte)) {
+			return false;
+		}
+		value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0) {
+			return true;
+		}
+	}
+	return false;		// Too many bytes for a 64 bit value.
+}
+
+// Decodes a front coded string over the previous value of the same field, which str still holds.
+inline bool RunReader::ReadFrontCoded(std::string& str) {
+	std::uint64_t shared = 0;
+	std::uint64_t rest = 0;
+	if (!this->ReadVarint(shared) || !this->ReadVarint(rest) || shared > str.size()) {
+		return false;
+	}
+	str.resize(static_cast<std::size_t>(shared));
+	for (std::uint64_t i = 0; i < rest; ++i) {
+		unsigned char byte = 0;
+		if (!this->ReadByte(byte)) {
+			return false;
+		}
+		str.push_back(static_cast<char>(byte));
+	}
+	return true;
+}
+
+// Reads the next record into current. Returns false at the end of the run, and sets corrupt if the end came mid-record.
+inline bool RunReader::Next() {
+	unsigned char first = 0;
+	if (!this->ReadByte(first)) {
+		return false;		// A clean end, between two records.
+	}
+	--this->pos;		// Put the byte back for ReadFrontCoded.
+	std::uint64_t pages = 0;
+	if (!this->ReadFrontCoded(this->current.author) || !this->ReadFrontCoded(this->current.title) || !this->ReadVarint(pages)) {
+		this->corrupt = true;
+		return false;
+	}
+	this->current.numberOfPages = static_cast<std::uint32_t>(pages);
+	return true;
+}
+
+// Merges sorted streams by repeatedly taking the smallest head. Each internal node holds the loser of the match played there,
+// so replacing the winner only replays the matches on the path from its leaf to the root.
+struct LoserTree {
+	std::vector<std::size_t> losers;		// losers[node] for internal nodes 1 to k - 1. Leaf i is node k + i.
+	std::size_t winner = 0;					// The stream with the smallest head.
+
+	template <typename Less>
+	void Build(std::size_t, const Less&);
+	template <typename Less>
+	void Replay(const Less&);
+};
+
+// Plays every match. less(a, b) must treat exhausted streams as larger than any other.
+template <typename Less>
+inline void LoserTree::Build(std::size_t k, const Less& less) {
+	this->losers.assign(k, 0);
+	std::vector<std::size_t> winners(2 * k);		// The winner of each node while building.
+	for (std::size_t i = 0; i < k; ++i) {
+		winners[k + i] = i;
+	}
+	for (std::size_t node = k - 1; node >= 1; --node) {
+		std::size_t a = winners[2 * node];
+		std::size_t b = winners[2 * node + 1];
+		bool aWins = less(a, b);
+		winners[node] = aWins ? a : b;
+		this->losers[node] = aWins ? b : a;
+	}
+	this->winner = k > 1 ? winners[1] : 0;
+}
+
+// Replays the matches above the winner's leaf after its head has changed.
+template <typename Less>
+inline void LoserTree::Replay(const Less& less) {
+	std::size_t k = this->losers.size();
+	std::size_t current = this->winner;
+	for (std::size_t node = (k + current) / 2; node >= 1; node /= 2) {
+		if (less(this->losers[node], current)) {
+			std::swap(this->losers[node], current);
+		}
+	}
+	this->winner = current;
+}
+
+// Sorts any number of records in a bounded amount of memory.
+struct ExternalSorter {
+	std::string directory;					// Where run files are written.
+	std::size_t memoryBudget;				// Bytes of records to hold before spilling a run.
+	CatalogSortKey key;						// The order to sort in.
+	std::vector<BookRecord> records;		// Records not yet written to a run.
+	std::size_t recordBytes = 0;			// Approximate memory used by records.
+	std::vector<std::string> runs;			// The run files not yet merged, oldest first.
+	std::size_t numRunFiles = 0;			// Number of run files ever written, which names the next one.
+
+	// Custom constructor
+	ExternalSorter(const std::string&, std::size_t, CatalogSortKey);
+	// Destructor, deletes the run files.
+	~ExternalSorter();
+	ExternalSorter(const ExternalSorter&) = delete;
+	ExternalSorter& operator=(const ExternalSorter&) = delete;
+
+	bool Add(BookRecord);
+	bool Add(const Book&);
+	bool SpillRun();
+	std::size_t MaxFanIn() const;
+	template <typename Sink>
+	bool MergeRuns(std::size_t, Sink&&);
+	bool MergePass();
+	template <typename Sink>
+	bool Merge(Sink&&);
+};
+
+// Custom constructor
+// Takes the directory for run files, the memory budget in bytes and the sort order.
+inline ExternalSorter::ExternalSorter(const std::string& directory, std::size_t memoryBudget, CatalogSortKey key) {
+	this->directory = directory;
+	this->memoryBudget = memoryBudget;
+	this->key = key;
+}
+
+inline ExternalSorter::~ExternalSorter() {
+	for (const std::string& path : this->runs) {
+		std::remove(path.c_str());
+	}
+}
+
+// Adds a record, spilling a run first if the budget is used up. Returns false if a run could not be written.
+inline bool ExternalSorter::Add(BookRecord record) {
+	this->recordBytes += sizeof(BookRecord) + record.author.capacity() + record.title.capacity();
+	this->records.push_back(std::move(record));
+	if (this->recordBytes >= this->memoryBudget) {
+		return this->SpillRun();
+	}
+	return true;
+}
+
+// Adds a copy of the book.
+inline bool ExternalSorter::Add(const Book& book) {
+	BookRecord record;
+	record.author = book.author ? book.author->name : std::string();
+	record.title = book.title;
+	record.numberOfPages = book.numberOfPages;
+	return this->Add(std::move(record));
+}
+
+// Sorts the records in memory and writes them to a new compressed run file.
+inline bool ExternalSorter::SpillRun() {
+	if (this->records.empty()) {
+		return true;
+	}
+	CatalogSortKey key = this->key;
+	std::sort(this->records.begin(), this->records.end(), [key](const BookRecord& a, const BookRecord& b) { return BookRecordLess(a, b, key); });
+	std::string path = RunFilePath(this->directory, "catalog-run", this, this->numRunFiles++);
+	RunWriter writer;
+	if (!writer.Open(path, std::size_t(1) << 20)) {
+		return false;
+	}
+	this->runs.push_back(path);		// Remember the file before writing it, so the destructor removes a half written one too.
+	for (const BookRecord& record : this->records) {
+		writer.Append(record);
+	}
+	this->records.clear();
+	this->records.shrink_to_fit();		// Give the memory back, so the budget really bounds what is held.
+	this->recordBytes = 0;
+	return writer.Close();
+}
+
+// Returns how many runs one merge reads at once: as many buffers of EXTERNAL_SORT_MIN_BUFFER as the budget holds, less
+// one for the output of an intermediate pass. At least two, so that every pass makes progress.
+inline std::size_t ExternalSorter::MaxFanIn() const {
+	std::size_t buffers = this->memoryBudget / EXTERNAL_SORT_MIN_BUFFER;
+	return buffers > 3 ? buffers - 1 : 2;
+}
+
+// Merges the first count runs, calling sink(const BookRecord&) for every record in order. The budget is split between
+// their read buffers and one output buffer. Returns false if a run could not be read.
+template <typename Sink>
+inline bool ExternalSorter::MergeRuns(std::size_t count, Sink&& sink) {
+	CatalogSortKey key = this->key;
+	std::size_t bufferSize = std::max<std::size_t>(this->memoryBudget / (count + 1), EXTERNAL_SORT_MIN_BUFFER);
+	std::vector<RunReader> readers(count);
+	std::vector<bool> exhausted(count);
+	for (std::size_t i = 0; i < count; ++i) {
+		if (!readers[i].Open(this->runs[i], bufferSize)) {
+			return false;
+		}
+		exhausted[i] = !readers[i].Next();
+	}
+	// Stream a comes before stream b if its head is smaller. An exhausted stream comes after everything.
+	auto less = [&](std::size_t a, std::size_t b) {
+		if (exhausted[a] || exhausted[b]) {
+			return !exhausted[a] && exhausted[b];
+		}
+		return BookRecordLess(readers[a].current, readers[b].current, key);
+	};
+	LoserTree tree;
+	tree.Build(count, less);
+	while (!exhausted[tree.winner]) {
+		if (!sink(static_cast<const BookRecord&>(readers[tree.winner].current))) {
+			return false;
+		}
+		exhausted[tree.winner] = !readers[tree.winner].Next();
+		tree.Replay(less);
+	}
+	for (const RunReader& reader : readers) {
+		if (reader.corrupt) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Merges the oldest MaxFanIn() runs into one new run at the back, and deletes them. Merging the oldest first keeps the
+// passes balanced, as every run is merged again only after all the runs older than it.
+inline bool ExternalSorter::MergePass() {
+	std::size_t count = std::min(this->MaxFanIn(), this->runs.size());
+	std::string path = RunFilePath(this->directory, "catalog-run", this, this->numRunFiles++);
+	RunWriter writer;
+	if (!writer.Open(path, std::max<std::size_t>(this->memoryBudget / (count + 1), EXTERNAL_SORT_MIN_BUFFER))) {
+		return false;
+	}
+	this->runs.push_back(path);		// The destructor removes it if the pass fails.
+	bool merged = this->MergeRuns(count, [&writer](const BookRecord& record) { return writer.Append(record); });
+	if (!writer.Close() || !merged) {
+		return false;
+	}
+	for (std::size_t i = 0; i < count; ++i) {
+		std::remove(this->runs[i].c_str());
+	}
+	this->runs.erase(this->runs.begin(), this->runs.begin() + static_cast<std::ptrdiff_t>(count));
+	return true;
+}
+
+// Calls sink(const BookRecord&) for every record added, in order. Returns false if a run could not be written or read.
+// If everything fit in the budget, nothing is written to disk.
+template <typename Sink>
+inline bool ExternalSorter::Merge(Sink&& sink) {
+	CatalogSortKey key = this->key;
+	if (this->runs.empty()) {
+		std::sort(this->records.begin(), this->records.end(), [key](const BookRecord& a, const BookRecord& b) { return BookRecordLess(a, b, key); });
+		for (const BookRecord& record : this->records) {
+			sink(record);
+		}
+		return true;
+	}
+	if (!this->SpillRun()) {
+		return false;
+	}
+	while (this->runs.size() > this->MaxFanIn()) {
+		if (!this->MergePass()) {
+			return false;
+		}
+	}
+	return this->MergeRuns(this->runs.size(), [&sink](const BookRecord& record) {
+		sink(record);
+		return true;
+	});
+}
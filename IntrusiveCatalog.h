@@ -0,0 +1,179 @@
+/****************************************************************
+* Author: Leo Carroll
+* Description:
+*	An intrusive alternative to Person and Book. Instead of an
+*	array of Book pointers in every Person, each LinkedBook holds
+*	a pointer to its author's next book, and a LinkedPerson only
+*	holds its first and last book. AddBook is an O(1) splice at
+*	the tail, an author can have any number of books, and a
+*	LinkedPerson is a few words instead of the booksWritten array.
+*
+*	Following the links jumps around memory once books of many
+*	authors are added in mixed order. LinkedCatalog::Relink moves
+*	every book so that each author's books sit next to each
+*	other, in order, which makes a traversal a sequential scan
+*	again. It also drops the storage of removed books.
+* Date Created: 2026-10-18
+* Date Modified: 2026-10-18
+****************************************************************/
+
+#pragma once
+
+#include <cstddef>			// Included for std::size_t.
+#include <cstdint>			// Included for std::uint32_t.
+#include <memory>			// Included for std::unique_ptr.
+#include <ostream>			// Included for std::ostream.
+#include <string>			// Included for std::string.
+#include <utility>			// Included for std::move.
+
+#include "Catalog.h"		// Included for Person and Book.
+#include "StableStorage.h"	// Included for StableStorage.
+
+struct LinkedBook;
+
+// An author whose books are linked through the books themselves.
+struct LinkedPerson {
+	LinkedBook* firstBook = nullptr;		// The first book written, or nullptr.
+	LinkedBook* lastBook = nullptr;			// The last book written, or nullptr.
+	std::size_t numBooks = 0;				// Number of books written.
+	std::string name;						// The name of the author.
+
+	// Custom constructor
+	explicit LinkedPerson(const std::string& = "");
+	// A book can only be on one list, so a copy would have to share it.
+	LinkedPerson(const LinkedPerson&) = delete;
+	LinkedPerson& operator=(const LinkedPerson&) = delete;
+
+	void AddBook(LinkedBook*);
+	bool RemoveBook(const LinkedBook*);
+};
+
+// A book, and its link to the next book of the same author.
+struct LinkedBook {
+	LinkedPerson* author;					// The author, or nullptr.
+	LinkedBook* nextBook = nullptr;			// The author's next book, or nullptr.
+	std::uint32_t numberOfPages;			// Number of pages in the book.
+	std::string title;						// Title of the book.
+
+	// Custom constructor
+	LinkedBook(LinkedPerson* = nullptr, const std::string& = "", std::uint32_t = 0);
+};
+
+// Owns LinkedPersons and LinkedBooks. Persons never move. Books never move either, except in Relink.
+struct LinkedCatalog {
+	StableStorage<LinkedPerson, 16> persons;						// The authors.
+	std::unique_ptr<StableStorage<LinkedBook>> books;				// The books, including removed ones until the next Relink.
+
+	// Default constructor
+	LinkedCatalog();
+
+	LinkedPerson& AddPerson(const std::string&);
+	LinkedBook& AddBook(LinkedPerson&, const std::string&, std::uint32_t);
+	LinkedPerson& Import(const Person&);
+	void Relink();
+};
+
+// LinkedPerson custom constructor
+inline LinkedPerson::LinkedPerson(const std::string& name) : name(name) {}
+
+// LinkedBook custom constructor
+inline LinkedBook::LinkedBook(LinkedPerson* author, const std::string& title, std::uint32_t pages) : author(author), numberOfPages(pages), title(title) {}
+
+// Appends the book to the end of this person's books. The book must not be on any person's list already.
+inline void LinkedPerson::AddBook(LinkedBook* book) {
+	if (book) {
+		book->nextBook = nullptr;
+		if (this->lastBook) {
+			this->lastBook->nextBook = book;
+		}
+		else {
+			this->firstBook = book;
+		}
+		this->lastBook = book;
+		++this->numBooks;
+	}
+}
+
+// Unlinks the book and returns true if it was on this person's list. The books after it keep their order.
+// The walk to the book before it is O(books written), as with Person::RemoveBook.
+inline bool LinkedPerson::RemoveBook(const LinkedBook* book) {
+	if (book == nullptr) {
+		return false;
+	}
+	LinkedBook* previous = nullptr;
+	for (LinkedBook* current = this->firstBook; current; previous = current, current = current->nextBook) {
+		if (current == book) {
+			if (previous) {
+				previous->nextBook = current->nextBook;
+			}
+			else {
+				this->firstBook = current->nextBook;
+			}
+			if (this->lastBook == current) {
+				this->lastBook = previous;
+			}
+			current->nextBook = nullptr;
+			--this->numBooks;
+			return true;
+		}
+	}
+	return false;
+}
+
+// LinkedCatalog default constructor
+inline LinkedCatalog::LinkedCatalog() : books(new StableStorage<LinkedBook>()) {}
+
+inline LinkedPerson& LinkedCatalog::AddPerson(const std::string& name) {
+	return this->persons.Emplace(name);
+}
+
+// Creates a book and appends it to the author's books.
+inline LinkedBook& LinkedCatalog::AddBook(LinkedPerson& author, const std::string& title, std::uint32_t pages) {
+	LinkedBook& book = this->books->Emplace(&author, title, pages);
+	author.AddBook(&book);
+	return book;
+}
+
+// Copies an in-memory Person and its books into the catalog.
+inline LinkedPerson& LinkedCatalog::Import(const Person& person) {
+	LinkedPerson& linked = this->AddPerson(person.name);
+	for (std::size_t idx = 0; idx < MAX_BOOKS_WRITTEN && person.booksWritten[idx]; ++idx) {
+		this->AddBook(linked, person.booksWritten[idx]->title, person.booksWritten[idx]->numberOfPages);
+	}
+	return linked;
+}
+
+// Moves every book that is on a list into new storage, author by author and in list order, and frees the old storage
+// with the removed books in it. Every LinkedBook pointer held outside of the catalog is invalidated. Persons do not move.
+inline void LinkedCatalog::Relink() {
+	std::unique_ptr<StableStorage<LinkedBook>> relinked(new StableStorage<LinkedBook>());
+	for (LinkedPerson& person : this->persons) {
+		LinkedBook* book = person.firstBook;
+		person.firstBook = nullptr;
+		person.lastBook = nullptr;
+		person.numBooks = 0;
+		while (book) {
+			LinkedBook* next = book->nextBook;
+			LinkedBook& moved = relinked->Emplace(book->author, std::string(), book->numberOfPages);
+			moved.title.swap(book->title);
+			person.AddBook(&moved);
+			book = next;
+		}
+	}
+	this->books = std::move(relinked);
+}
+
+// LinkedBook output operator overload, in the same format as the Book output operator.
+inline std::ostream& operator<<(std::ostream& os, const LinkedBook& book) {
+	os << book.title << ", " << (book.author ? book.author->name : "Unknown") << ", " << book.numberOfPages << " pages";
+	return os;
+}
+
+// LinkedPerson output operator overload, in the same format as the Person output operator.
+inline std::ostream& operator<<(std::ostream& os, const LinkedPerson& person) {
+	os << person.name;
+	for (const LinkedBook* book = person.firstBook; book; book = book->nextBook) {
+		os << "\n - " << *book;
+	}
+	return os;
+}
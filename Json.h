@@ -0,0 +1,627 @@
+/****************************************************************
+* Author: Leo Carroll
+* Description:
+*	JSON export and import of Persons and the books that they
+*	have written. The writer escapes strings 16 bytes at a time
+*	with SSE2 and formats numbers with std::to_chars into one
+*	large buffer. The reader finds every structural character
+*	in 64 byte blocks first (in the spirit of simdjson), and
+*	then walks that index to rebuild the Person/Book graph.
+*	Both paths fall back to plain scalar loops without SSE2.
+*
+*	The format is the catalog as an array of authors:
+*	[{"name":"...","booksWritten":[{"title":"...","numberOfPages":1}]}]
+* Date Created: 2026-10-18
+* Date Modified: 2026-10-18
+****************************************************************/
+
+#pragma once
+
+#include <charconv>			// Included for std::to_chars and std::from_chars.
+#include <cstdint>			// Included for std::uint32_t and std::uint64_t.
+#include <cstring>			// Included for std::memcpy and std::memset.
+#include <ostream>			// Included for std::ostream.
+#include <string>			// Included for std::string.
+#include <string_view>		// Included for std::string_view.
+#include <vector>			// Included for std::vector.
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>		// Included for the SSE2 intrinsics.
+#define CATALOG_JSON_SSE2 1
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>			// Included for _BitScanForward.
+#endif
+
+#include "Catalog.h"		// Included for Person and Book.
+#include "StableStorage.h"	// Included for PersonStorage and BookStorage.
+
+// Number of bytes the writer collects before handing them to its stream.
+constexpr std::size_t JSON_FLUSH_THRESHOLD = std::size_t(1) << 20;
+
+// Writes Persons and their books as JSON into a single growing buffer.
+// If a stream is given, the buffer is flushed to it whenever it grows past JSON_FLUSH_THRESHOLD.
+struct JsonWriter {
+	std::string buffer;		// The formatted JSON that has not been flushed yet.
+	std::ostream* sink;		// Stream that the buffer is flushed to, or nullptr to keep everything in the buffer.
+
+	// Custom constructor
+	JsonWriter(std::ostream* = nullptr);
+	// Destructor, flushes whatever is left in the buffer.
+	~JsonWriter();
+
+	void WriteCatalog(const Person* const*, std::size_t);
+	void WritePerson(const Person&);
+	void WriteBook(const Book&);
+	void WriteString(std::string_view);
+	void WriteNumber(std::uint32_t);
+	void Flush();
+};
+
+// The Persons and Books rebuilt by ReadJson.
+// Both live in stable storage, so more Persons and Books can be added afterwards without breaking the pointers between them.
+struct JsonCatalog {
+	PersonStorage persons;		// Every author in the document, in document order.
+	BookStorage books;			// Every book in the document, grouped by author.
+};
+
+// Returns the index of the lowest set bit. bits must not be zero.
+inline unsigned JsonLowestBit(std::uint64_t bits) {
+#if defined(__GNUC__) || defined(__clang__)
+	return static_cast<unsigned>(__builtin_ctzll(bits));
+#elif defined(_MSC_VER)
+	unsigned long index = 0;		// Set by _BitScanForward to the index of the lowest set bit.
+	// _BitScanForward64 only exists on 64 bit targets, so scan the two halves with the 32 bit form.
+	if (_BitScanForward(&index, static_cast<unsigned long>(bits))) {
+		return static_cast<unsigned>(index);
+	}
+	_BitScanForward(&index, static_cast<unsigned long>(bits >> 32));
+	return static_cast<unsigned>(index) + 32;
+#else
+	unsigned index = 0;
+	while ((bits & 1) == 0) {
+		bits >>= 1;
+		++index;
+	}
+	return index;
+#endif
+}
+
+// Returns the index of the first byte in the range that must be escaped in a JSON string, or the size if there is none.
+inline std::size_t JsonFindEscape(const char* str, std::size_t size) {
+	std::size_t idx = 0;		// Index of the byte being checked.
+#ifdef CATALOG_JSON_SSE2
+	const __m128i quote = _mm_set1_epi8('"');			// Every lane set to a quote.
+	const __m128i backslash = _mm_set1_epi8('\\');		// Every lane set to a backslash.
+	const __m128i control = _mm_set1_epi8(0x1F);		// Every lane set to the highest control character.
+	// Check 16 bytes at a time while a full block remains.
+	for (; idx + 16 <= size; idx += 16) {
+		__m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str + idx));
+		// A byte is a control character if its unsigned max with 0x1F is still 0x1F.
+		__m128i special = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, quote), _mm_cmpeq_epi8(block, backslash)),
+			_mm_cmpeq_epi8(_mm_max_epu8(block, control), control));
+		int mask = _mm_movemask_epi8(special);
+		if (mask != 0) {
+			return idx + static_cast<std::size_t>(JsonLowestBit(static_cast<unsigned>(mask)));
+		}
+	}
+#endif
+	// Check the remaining bytes one at a time.
+	for (; idx < size; ++idx) {
+		unsigned char c = static_cast<unsigned char>(str[idx]);
+		if (c == '"' || c == '\\' || c < 0x20) {
+			return idx;
+		}
+	}
+	return size;
+}
+
+// Returns the index of the first quote or backslash in the range, or the size if there is none.
+inline std::size_t JsonFindQuote(const char* str, std::size_t size) {
+	std::size_t idx = 0;		// Index of the byte being checked.
+#ifdef CATALOG_JSON_SSE2
+	const __m128i quote = _mm_set1_epi8('"');			// Every lane set to a quote.
+	const __m128i backslash = _mm_set1_epi8('\\');		// Every lane set to a backslash.
+	for (; idx + 16 <= size; idx += 16) {
+		__m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str + idx));
+		int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(block, quote), _mm_cmpeq_epi8(block, backslash)));
+		if (mask != 0) {
+			return idx + static_cast<std::size_t>(JsonLowestBit(static_cast<unsigned>(mask)));
+		}
+	}
+#endif
+	for (; idx < size; ++idx) {
+		if (str[idx] == '"' || str[idx] == '\\') {
+			return idx;
+		}
+	}
+	return size;
+}
+
+// JsonWriter custom constructor
+inline JsonWriter::JsonWriter(std::ostream* sink) {
+	this->sink = sink;		// Set this->sink to the sink arg.
+	// Reserve the whole flush threshold up front so the buffer does not reallocate while writing.
+	this->buffer.reserve(sink ? JSON_FLUSH_THRESHOLD + 4096 : 4096);
+}
+
+// JsonWriter destructor
+inline JsonWriter::~JsonWriter() {
+	this->Flush();
+}
+
+// Hands the buffer to the sink, if there is one.
+inline void JsonWriter::Flush() {
+	if (this->sink && !this->buffer.empty()) {
+		this->sink->write(this->buffer.data(), static_cast<std::streamsize>(this->buffer.size()));
+		this->buffer.clear();		// Clear keeps the capacity, so the next records reuse the same memory.
+	}
+}
+
+// Writes a quoted, escaped JSON string.
+inline void JsonWriter::WriteString(std::string_view str) {
+	static const char HEX_DIGITS[] = "0123456789abcdef";
+	this->buffer.push_back('"');
+	std::size_t idx = 0;		// Index of the first byte that has not been written yet.
+	while (idx < str.size()) {
+		// Copy the run of bytes that need no escaping in one go.
+		std::size_t run = JsonFindEscape(str.data() + idx, str.size() - idx);
+		this->buffer.append(str.data() + idx, run);
+		idx += run;
+		if (idx == str.size()) {
+			break;
+		}
+		char c = str[idx++];		// The byte that needs escaping.
+		switch (c) {
+		case '"': this->buffer.append("\\\""); break;
+		case '\\': this->buffer.append("\\\\"); break;
+		case '\b': this->buffer.append("\\b"); break;
+		case '\f': this->buffer.append("\\f"); break;
+		case '\n': this->buffer.append("\\n"); break;
+		case '\r': this->buffer.append("\\r"); break;
+		case '\t': this->buffer.append("\\t"); break;
+		default:
+			// Every other control character is written as a \u escape.
+			this->buffer.append("\\u00");
+			this->buffer.push_back(HEX_DIGITS[(c >> 4) & 0xF]);
+			this->buffer.push_back(HEX_DIGITS[c & 0xF]);
+			break;
+		}
+	}
+	this->buffer.push_back('"');
+}
+
+// Writes an unsigned number with std::to_chars.
+inline void JsonWriter::WriteNumber(std::uint32_t value) {
+	char digits[10];		// A uint32_t never has more than 10 digits.
+	std::to_chars_result result = std::to_chars(digits, digits + sizeof(digits), value);
+	this->buffer.append(digits, result.ptr);
+}
+
+// Writes a book as {"title":"...","numberOfPages":N}.
+// The author is not written, it is the Person that the book is listed under.
+inline void JsonWriter::WriteBook(const Book& book) {
+	this->buffer.append("{\"title\":");
+	this->WriteString(book.title);
+	this->buffer.append(",\"numberOfPages\":");
+	this->WriteNumber(book.numberOfPages);
+	this->buffer.push_back('}');
+}
+
+// Writes a person as {"name":"...","booksWritten":[...]}.
+inline void JsonWriter::WritePerson(const Person& person) {
+	this->buffer.append("{\"name\":");
+	this->WriteString(person.name);
+	this->buffer.append(",\"booksWritten\":[");
+	std::size_t idx = 0;		// Create an idx variable to hold the index.
+	// Loop the same way as the Person output operator, stopping at the first nullptr.
+	while (idx < MAX_BOOKS_WRITTEN && person.booksWritten[idx] != nullptr) {
+		if (idx != 0) {
+			this->buffer.push_back(',');
+		}
+		this->WriteBook(*person.booksWritten[idx++]);
+	}
+	this->buffer.append("]}");
+	// Only flush between records, so that a flushed chunk never ends halfway through a person.
+	if (this->buffer.size() >= JSON_FLUSH_THRESHOLD) {
+		this->Flush();
+	}
+}
+
+// Writes an array of persons. Null entries in the array are skipped.
+inline void JsonWriter::WriteCatalog(const Person* const* persons, std::size_t numPersons) {
+	this->buffer.push_back('[');
+	bool first = true;		// Whether the next person is the first one written.
+	for (std::size_t i = 0; i < numPersons; ++i) {
+		if (persons[i] == nullptr) {
+			continue;
+		}
+		if (!first) {
+			this->buffer.push_back(',');
+		}
+		first = false;
+		this->WritePerson(*persons[i]);
+	}
+	this->buffer.push_back(']');
+	this->Flush();
+}
+
+// Bit masks describing one 64 byte block of the input. Bit i is byte i of the block.
+struct JsonBlockMasks {
+	std::uint64_t quote;			// Quotes.
+	std::uint64_t backslash;		// Backslashes.
+	std::uint64_t op;				// One of {}[]:,
+	std::uint64_t whitespace;		// Spaces, tabs, carriage returns and newlines.
+};
+
+// Classifies the 64 bytes starting at block.
+inline JsonBlockMasks JsonClassifyBlock(const char* block) {
+	JsonBlockMasks masks = {};
+#ifdef CATALOG_JSON_SSE2
+	const __m128i caseBit = _mm_set1_epi8(0x20);		// Setting this bit maps '[' to '{' and ']' to '}'.
+	for (int i = 0; i < 4; ++i) {
+		__m128i lane = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * i));
+		__m128i folded = _mm_or_si128(lane, caseBit);
+		__m128i op = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(folded, _mm_set1_epi8('{')), _mm_cmpeq_epi8(folded, _mm_set1_epi8('}'))),
+			_mm_or_si128(_mm_cmpeq_epi8(lane, _mm_set1_epi8(':')), _mm_cmpeq_epi8(lane, _mm_set1_epi8(','))));
+		__m128i whitespace = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(lane, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(lane, _mm_set1_epi8('\t'))),
+			_mm_or_si128(_mm_cmpeq_epi8(lane, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(lane, _mm_set1_epi8('\r'))));
+		// Gathers the 16 lane results into their place in the 64 bit masks.
+		auto gather = [i](__m128i matches) {
+			return static_cast<std::uint64_t>(static_cast<std::uint16_t>(_mm_movemask_epi8(matches))) << (16 * i);
+		};
+		masks.quote |= gather(_mm_cmpeq_epi8(lane, _mm_set1_epi8('"')));
+		masks.backslash |= gather(_mm_cmpeq_epi8(lane, _mm_set1_epi8('\\')));
+		masks.op |= gather(op);
+		masks.whitespace |= gather(whitespace);
+	}
+#else
+	for (int i = 0; i < 64; ++i) {
+		std::uint64_t bit = std::uint64_t(1) << i;
+		switch (block[i]) {
+		case '"': masks.quote |= bit; break;
+		case '\\': masks.backslash |= bit; break;
+		case '{': case '}': case '[': case ']': case ':': case ',': masks.op |= bit; break;
+		case ' ': case '\t': case '\n': case '\r': masks.whitespace |= bit; break;
+		default: break;
+		}
+	}
+#endif
+	return masks;
+}
+
+// Returns a mask where bit i is the xor of bits 0 through i of the input.
+// Applied to the unescaped quotes, this marks every byte that is inside a string.
+inline std::uint64_t JsonPrefixXor(std::uint64_t bits) {
+	bits ^= bits << 1;
+	bits ^= bits << 2;
+	bits ^= bits << 4;
+	bits ^= bits << 8;
+	bits ^= bits << 16;
+	bits ^= bits << 32;
+	return bits;
+}
+
+// Returns the bytes that are escaped by a backslash. An odd run of backslashes escapes the byte after it.
+// prevEscaped carries whether the first byte of the next block is escaped.
+inline std::uint64_t JsonFindEscaped(std::uint64_t backslash, std::uint64_t& prevEscaped) {
+	constexpr std::uint64_t EVEN_BITS = 0x5555555555555555ULL;
+	backslash &= ~prevEscaped;		// A backslash that is itself escaped does not start a run.
+	std::uint64_t followsEscape = (backslash << 1) | prevEscaped;
+	std::uint64_t oddStarts = backslash & ~EVEN_BITS & ~followsEscape;
+	// Adding the run starts to the backslashes carries each run to the byte after it.
+	// The sum wraps around if the last run reaches the end of the block, which carries into the next block.
+	std::uint64_t evenStarts = oddStarts + backslash;
+	prevEscaped = evenStarts < oddStarts ? 1 : 0;
+	std::uint64_t invertMask = evenStarts << 1;
+	return (EVEN_BITS ^ invertMask) & followsEscape;
+}
+
+// Finds the position of every structural character outside of strings, every opening quote,
+// and the first byte of every number or literal. Returns false if a string is never closed.
+inline bool JsonIndexStructurals(std::string_view json, std::vector<std::uint32_t>& positions) {
+	std::size_t count = 0;		// Number of positions written so far.
+	positions.resize(json.size() / 4 + 64);
+	std::uint64_t prevEscaped = 0;			// Whether the first byte of the next block is escaped.
+	std::uint64_t prevInString = 0;			// All ones if the previous block ended inside a string.
+	std::uint64_t prevScalar = 0;			// 1 if the previous block ended inside a number or literal.
+	for (std::size_t base = 0; base < json.size(); base += 64) {
+		const char* block = json.data() + base;		// The start of the 64 byte block.
+		char padded[64];		// A copy of the last block padded with spaces, so the loads never read past the input.
+		if (json.size() - base < 64) {
+			std::memset(padded, ' ', sizeof(padded));
+			std::memcpy(padded, block, json.size() - base);
+			block = padded;
+		}
+		JsonBlockMasks masks = JsonClassifyBlock(block);
+		std::uint64_t quote = masks.quote & ~JsonFindEscaped(masks.backslash, prevEscaped);
+		std::uint64_t inString = JsonPrefixXor(quote) ^ prevInString;
+		prevInString = static_cast<std::uint64_t>(static_cast<std::int64_t>(inString) >> 63);
+		// A scalar is anything that is not an operator, whitespace or part of a string.
+		std::uint64_t scalar = ~(masks.op | masks.whitespace | quote | inString);
+		std::uint64_t scalarStarts = scalar & ~((scalar << 1) | prevScalar);
+		prevScalar = scalar >> 63;
+		std::uint64_t structurals = (masks.op & ~inString) | (quote & inString) | scalarStarts;
+		// Make room for a full block of positions, so that the loop below never checks the size.
+		if (count + 64 > positions.size()) {
+			positions.resize(positions.size() * 2);
+		}
+		// Write out the position of every set bit, lowest first.
+		std::uint32_t* out = positions.data() + count;
+		while (structurals != 0) {
+			*out++ = static_cast<std::uint32_t>(base + static_cast<std::size_t>(JsonLowestBit(structurals)));
+			structurals &= structurals - 1;
+		}
+		count = static_cast<std::size_t>(out - positions.data());
+	}
+	positions.resize(count);
+	return prevInString == 0;
+}
+
+// Walks the structural index produced by JsonIndexStructurals.
+struct JsonParser {
+	std::string_view json;						// The whole document.
+	const std::vector<std::uint32_t>* tape;		// The structural positions.
+	std::size_t cursor;							// Index of the next unread entry in the tape.
+
+	// Returns the character at the next structural position, or '\0' at the end of the tape.
+	char Peek() const;
+	// Returns Peek() and moves past it.
+	char Next();
+	bool ParseString(std::string&);
+	bool ParseNumber(std::uint32_t&);
+	bool SkipValue();
+};
+
+inline char JsonParser::Peek() const {
+	return this->cursor < this->tape->size() ? this->json[(*this->tape)[this->cursor]] : '\0';
+}
+
+inline char JsonParser::Next() {
+	char c = this->Peek();
+	++this->cursor;
+	return c;
+}
+
+// Reads the string that starts at the next structural position, decoding escapes into out.
+inline bool JsonParser::ParseString(std::string& out) {
+	if (this->Peek() != '"') {
+		return false;
+	}
+	std::size_t idx = (*this->tape)[this->cursor++] + 1;		// Index of the first byte after the opening quote.
+	out.clear();
+	while (true) {
+		// Copy the run up to the next quote or backslash in one go.
+		std::size_t run = JsonFindQuote(this->json.data() + idx, this->json.size() - idx);
+		out.append(this->json.data() + idx, run);
+		idx += run;
+		if (idx >= this->json.size()) {
+			return false;
+		}
+		if (this->json[idx] == '"') {
+			return true;
+		}
+		// Decode the escape after the backslash.
+		if (++idx >= this->json.size()) {
+			return false;
+		}
+		char c = this->json[idx++];
+		switch (c) {
+		case '"': case '\\': case '/': out.push_back(c); break;
+		case 'b': out.push_back('\b'); break;
+		case 'f': out.push_back('\f'); break;
+		case 'n': out.push_back('\n'); break;
+		case 'r': out.push_back('\r'); break;
+		case 't': out.push_back('\t'); break;
+		case 'u': {
+			// Reads four hex digits starting at idx.
+			auto readHex = [this](std::size_t at, std::uint32_t& value) {
+				if (at + 4 > this->json.size()) {
+					return false;
+				}
+				std::from_chars_result result = std::from_chars(this->json.data() + at, this->json.data() + at + 4, value, 16);
+				return result.ec == std::errc() && result.ptr == this->json.data() + at + 4;
+			};
+			std::uint32_t code = 0;
+			if (!readHex(idx, code)) {
+				return false;
+			}
+			idx += 4;
+			// A high surrogate must be followed by a \u escaped low surrogate.
+			if (code >= 0xD800 && code < 0xDC00) {
+				std::uint32_t low = 0;
+				if (idx + 2 > this->json.size() || this->json[idx] != '\\' || this->json[idx + 1] != 'u' || !readHex(idx + 2, low) || low < 0xDC00 || low >= 0xE000) {
+					return false;
+				}
+				idx += 6;
+				code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+			}
+			// Encode the code point as UTF-8.
+			if (code < 0x80) {
+				out.push_back(static_cast<char>(code));
+			}
+			else if (code < 0x800) {
+				out.push_back(static_cast<char>(0xC0 | (code >> 6)));
+				out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+			}
+			else if (code < 0x10000) {
+				out.push_back(static_cast<char>(0xE0 | (code >> 12)));
+				out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+				out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+			}
+			else {
+				out.push_back(static_cast<char>(0xF0 | (code >> 18)));
+				out.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+				out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+				out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+			}
+			break;
+		}
+		default:
+			return false;
+		}
+	}
+}
+
+// Reads the unsigned number that starts at the next structural position.
+inline bool JsonParser::ParseNumber(std::uint32_t& value) {
+	if (this->cursor >= this->tape->size()) {
+		return false;
+	}
+	const char* first = this->json.data() + (*this->tape)[this->cursor++];
+	const char* last = this->json.data() + this->json.size();
+	std::from_chars_result result = std::from_chars(first, last, value);
+	// The number must end at whitespace or the next structural character.
+	return result.ec == std::errc() && (result.ptr == last || *result.ptr == ',' || *result.ptr == '}' || *result.ptr == ']' ||
+		*result.ptr == ' ' || *result.ptr == '\t' || *result.ptr == '\n' || *result.ptr == '\r');
+}
+
+// Skips over the value at the next structural position, including any nested objects and arrays.
+inline bool JsonParser::SkipValue() {
+	std::size_t depth = 0;		// How many objects and arrays are open.
+	do {
+		char c = this->Next();
+		if (c == '{' || c == '[') {
+			++depth;
+		}
+		else if (c == '}' || c == ']') {
+			if (depth == 0) {
+				return false;
+			}
+			--depth;
+		}
+		else if (c == '\0') {
+			return false;
+		}
+	} while (depth != 0);
+	return true;
+}
+
+// Rebuilds the Persons and Books described by json into catalog, replacing its previous contents.
+// Returns false if the document is not valid JSON in the catalog format. Unknown keys are skipped.
+inline bool ReadJson(std::string_view json, JsonCatalog& catalog) {
+	// An author and the range of its books in the books vector, before any Person is built.
+	struct PendingPerson {
+		std::string name;
+		std::size_t firstBook;
+		std::size_t numBooks;
+	};
+	// A book before its author is built.
+	struct PendingBook {
+		std::string title;
+		std::uint32_t numberOfPages;
+	};
+
+	std::vector<std::uint32_t> tape;		// The structural positions of the document.
+	if (json.size() > UINT32_MAX || !JsonIndexStructurals(json, tape)) {
+		return false;
+	}
+	JsonParser parser = { json, &tape, 0 };
+	std::vector<PendingPerson> pendingPersons;
+	std::vector<PendingBook> pendingBooks;
+	std::string key;		// The key being read, reused to avoid allocating per key.
+
+	if (parser.Next() != '[') {
+		return false;
+	}
+	if (parser.Peek() == ']') {
+		parser.Next();
+	}
+	else {
+		// Read every person object in the array.
+		do {
+			if (parser.Next() != '{') {
+				return false;
+			}
+			PendingPerson person = { "", pendingBooks.size(), 0 };
+			if (parser.Peek() == '}') {
+				parser.Next();
+			}
+			else {
+				do {
+					if (!parser.ParseString(key) || parser.Next() != ':') {
+						return false;
+					}
+					if (key == "name") {
+						if (!parser.ParseString(person.name)) {
+							return false;
+						}
+					}
+					else if (key == "booksWritten") {
+						if (parser.Next() != '[') {
+							return false;
+						}
+						if (parser.Peek() == ']') {
+							parser.Next();
+						}
+						else {
+							// Read every book object in the array.
+							do {
+								if (parser.Next() != '{') {
+									return false;
+								}
+								PendingBook book = { "", 0 };
+								if (parser.Peek() == '}') {
+									parser.Next();
+								}
+								else {
+									do {
+										if (!parser.ParseString(key) || parser.Next() != ':') {
+											return false;
+										}
+										bool ok = key == "title" ? parser.ParseString(book.title) :
+											key == "numberOfPages" ? parser.ParseNumber(book.numberOfPages) : parser.SkipValue();
+										if (!ok) {
+											return false;
+										}
+									} while (parser.Peek() == ',' && parser.Next());
+									if (parser.Next() != '}') {
+										return false;
+									}
+								}
+								pendingBooks.push_back(std::move(book));
+							} while (parser.Peek() == ',' && parser.Next());
+							if (parser.Next() != ']') {
+								return false;
+							}
+						}
+					}
+					else if (!parser.SkipValue()) {
+						return false;
+					}
+				} while (parser.Peek() == ',' && parser.Next());
+				if (parser.Next() != '}') {
+					return false;
+				}
+			}
+			person.numBooks = pendingBooks.size() - person.firstBook;
+			pendingPersons.push_back(std::move(person));
+		} while (parser.Peek() == ',' && parser.Next());
+		if (parser.Next() != ']') {
+			return false;
+		}
+	}
+	// Nothing may follow the top level array.
+	if (parser.cursor != tape.size()) {
+		return false;
+	}
+
+	// Build each Person and then its Books. The storage never moves an element, so the pointers between them stay valid.
+	catalog.books.Clear();
+	catalog.persons.Clear();
+	for (PendingPerson& pending : pendingPersons) {
+		Person& person = catalog.persons.Emplace(nullptr, 0, pending.name);
+		for (std::size_t j = 0; j < pending.numBooks; ++j) {
+			PendingBook& pendingBook = pendingBooks[pending.firstBook + j];
+			Book& book = catalog.books.Emplace(&person, "", pendingBook.numberOfPages);
+			book.title = std::move(pendingBook.title);		// Move the title rather than copying it a second time.
+			// Same as Person::AddBook, but the next free index is already known.
+			if (j < MAX_BOOKS_WRITTEN) {
+				person.booksWritten[j] = &book;
+				person.stats.Add(book.numberOfPages);
+			}
+		}
+	}
+	return true;
+}
@@ -0,0 +1,233 @@
+/****************************************************************
+* Author: Leo Carroll
+* Description:
+*	A throughput benchmark of Json.h. A generated catalog is
+*	exported with JsonWriter and with a plain ostringstream
+*	writer that escapes one character at a time, and the output
+*	is read back with ReadJson and with an istream parser that
+*	reads one character at a time. Both pairs must produce the
+*	same document and the same catalog, and the speed of each
+*	is printed in MB/s.
+*
+*	Build on its own, apart from Main.cpp:
+*	g++ -std=c++17 -O2 JsonBenchmark.cpp
+* Date Created: 2026-10-18
+* Date Modified: 2026-10-18
+****************************************************************/
+
+#include <chrono>			// Included for std::chrono::steady_clock.
+#include <cstdint>			// Included for std::uint32_t.
+#include <iostream>			// Included for std::cout.
+#include <random>			// Included for std::mt19937_64.
+#include <sstream>			// Included for std::ostringstream and std::istringstream.
+#include <string>			// Included for std::string.
+#include <vector>			// Included for std::vector.
+
+#include "Json.h"			// Included for JsonWriter, ReadJson and JsonCatalog.
+
+constexpr std::size_t NUM_AUTHORS = 50000;			// Number of authors in the generated catalog.
+constexpr std::size_t BOOKS_PER_AUTHOR = 8;			// Number of books each author has written.
+constexpr int NUM_REPEATS = 5;						// Each measurement is the best of this many runs.
+
+// Writes str as a quoted JSON string, one character at a time.
+void NaiveWriteString(std::ostream& out, const std::string& str) {
+	out << '"';
+	for (char c : str) {
+		switch (c) {
+		case '"': out << "\\\""; break;
+		case '\\': out << "\\\\"; break;
+		case '\n': out << "\\n"; break;
+		case '\t': out << "\\t"; break;
+		default: out << c; break;
+		}
+	}
+	out << '"';
+}
+
+// Writes the catalog in the same format as JsonWriter::WriteCatalog, with the stream operators.
+void NaiveWriteCatalog(std::ostream& out, const std::vector<Person*>& persons) {
+	out << '[';
+	for (std::size_t i = 0; i < persons.size(); ++i) {
+		if (i != 0) {
+			out << ',';
+		}
+		out << "{\"name\":";
+		NaiveWriteString(out, persons[i]->name);
+		out << ",\"booksWritten\":[";
+		for (std::size_t idx = 0; idx < MAX_BOOKS_WRITTEN && persons[i]->booksWritten[idx] != nullptr; ++idx) {
+			const Book& book = *persons[i]->booksWritten[idx];
+			if (idx != 0) {
+				out << ',';
+			}
+			out << "{\"title\":";
+			NaiveWriteString(out, book.title);
+			out << ",\"numberOfPages\":" << book.numberOfPages << '}';
+		}
+		out << "]}";
+	}
+	out << ']';
+}
+
+// Reads the documents written by NaiveWriteCatalog one character at a time.
+// Only handles the keys and escapes the writers above produce, which is all the benchmark needs.
+struct NaiveReader {
+	std::istream& in;
+
+	bool Expect(char expected) {
+		in >> std::ws;
+		return in.get() == expected;
+	}
+
+	bool ReadString(std::string& out) {
+		out.clear();
+		if (!this->Expect('"')) {
+			return false;
+		}
+		for (int c = in.get(); c != '"'; c = in.get()) {
+			if (c == EOF) {
+				return false;
+			}
+			if (c == '\\') {
+				c = in.get();
+				c = c == 'n' ? '\n' : c == 't' ? '\t' : c;
+			}
+			out.push_back(static_cast<char>(c));
+		}
+		return true;
+	}
+
+	bool ReadCatalog(JsonCatalog& catalog) {
+		std::string key;
+		catalog.books.Clear();
+		catalog.persons.Clear();
+		if (!this->Expect('[')) {
+			return false;
+		}
+		do {
+			if (!this->Expect('{')) {
+				return false;
+			}
+			Person& person = catalog.persons.Emplace();
+			if (!this->ReadString(key) || key != "name" || !this->Expect(':') || !this->ReadString(person.name)) {
+				return false;
+			}
+			if (!this->Expect(',') || !this->ReadString(key) || key != "booksWritten" || !this->Expect(':') || !this->Expect('[')) {
+				return false;
+			}
+			in >> std::ws;
+			if (in.peek() == ']') {
+				in.get();
+			}
+			else {
+				do {
+					Book& book = catalog.books.Emplace(&person);
+					if (!this->Expect('{') || !this->ReadString(key) || key != "title" || !this->Expect(':') || !this->ReadString(book.title)) {
+						return false;
+					}
+					if (!this->Expect(',') || !this->ReadString(key) || key != "numberOfPages" || !this->Expect(':') || !(in >> book.numberOfPages)) {
+						return false;
+					}
+					if (!this->Expect('}')) {
+						return false;
+					}
+					person.AddBook(&book);
+					in >> std::ws;
+				} while (in.peek() == ',' && in.get());
+				if (!this->Expect(']')) {
+					return false;
+				}
+			}
+			if (!this->Expect('}')) {
+				return false;
+			}
+			in >> std::ws;
+		} while (in.peek() == ',' && in.get());
+		return this->Expect(']');
+	}
+};
+
+// Runs work NUM_REPEATS times and returns the fewest seconds any run took.
+template <typename Work>
+double BestSeconds(Work work) {
+	double best = 1e30;
+	for (int run = 0; run < NUM_REPEATS; ++run) {
+		std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+		work();
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+		best = seconds < best ? seconds : best;
+	}
+	return best;
+}
+
+// Returns whether the two catalogs hold the same authors and books in the same order.
+bool SameCatalog(JsonCatalog& left, JsonCatalog& right) {
+	if (left.persons.Size() != right.persons.Size() || left.books.Size() != right.books.Size()) {
+		return false;
+	}
+	for (std::size_t i = 0; i < left.books.Size(); ++i) {
+		const Book& a = left.books[i];
+		const Book& b = right.books[i];
+		if (a.title != b.title || a.numberOfPages != b.numberOfPages || a.author->name != b.author->name) {
+			return false;
+		}
+	}
+	return true;
+}
+
+int main() {
+	// Generate the catalog. Some titles carry quotes and backslashes, so both writers have to escape.
+	PersonStorage persons;
+	BookStorage books;
+	std::vector<Person*> authors;
+	std::mt19937_64 rng(0);
+	for (std::size_t i = 0; i < NUM_AUTHORS; ++i) {
+		Person& person = persons.Emplace(nullptr, 0, "Author " + std::to_string(i));
+		for (std::size_t j = 0; j < BOOKS_PER_AUTHOR; ++j) {
+			std::string title = "The " + std::to_string(rng() % 100000) + (rng() % 8 == 0 ? " \"Collected\" Works\\Letters" : " Chronicles of the Long Night");
+			person.AddBook(&books.Emplace(&person, title, static_cast<std::uint32_t>(50 + rng() % 1200)));
+		}
+		authors.push_back(&person);
+	}
+
+	std::string fast;
+	double fastWrite = BestSeconds([&]() {
+		JsonWriter writer;
+		writer.WriteCatalog(authors.data(), authors.size());
+		fast = std::move(writer.buffer);
+	});
+	std::string naive;
+	double naiveWrite = BestSeconds([&]() {
+		std::ostringstream out;
+		NaiveWriteCatalog(out, authors);
+		naive = out.str();
+	});
+	if (fast != naive) {
+		std::cout << "The writers produced different documents.\n";
+		return 1;
+	}
+
+	JsonCatalog fastCatalog;
+	bool fastOk = true;
+	double fastRead = BestSeconds([&]() {
+		fastOk = ReadJson(fast, fastCatalog);
+	});
+	JsonCatalog naiveCatalog;
+	bool naiveOk = true;
+	double naiveRead = BestSeconds([&]() {
+		std::istringstream in(naive);
+		NaiveReader reader = { in };
+		naiveOk = reader.ReadCatalog(naiveCatalog);
+	});
+	if (!fastOk || !naiveOk || !SameCatalog(fastCatalog, naiveCatalog)) {
+		std::cout << "The readers rebuilt different catalogs.\n";
+		return 1;
+	}
+
+	double megabytes = static_cast<double>(fast.size()) / 1e6;
+	std::cout << "Document: " << megabytes << " MB, " << NUM_AUTHORS << " authors, " << NUM_AUTHORS * BOOKS_PER_AUTHOR << " books\n";
+	std::cout << "Write  JsonWriter:    " << megabytes / fastWrite << " MB/s\n";
+	std::cout << "Write  ostringstream: " << megabytes / naiveWrite << " MB/s\n";
+	std::cout << "Read   ReadJson:      " << megabytes / fastRead << " MB/s\n";
+	std::cout << "Read   istringstream: " << megabytes / naiveRead << " MB/s\n";
+	return 0;
+}
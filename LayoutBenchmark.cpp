@@ -0,0 +1,685 @@
+/****************************************************************
+* Author: Leo Carroll
+* Description:
+*	A benchmark of storage layouts for the relation between
+*	authors and their books. The same workload is run over five
+*	layouts:
+*	 - the fixed booksWritten[100] array of Person and Book,
+*	 - a small vector of book pointers, inline up to four,
+*	 - a CSR adjacency: per author, a range in one array of ids,
+*	 - a linked list threaded through the books,
+*	 - columns of titles, pages and authors, sorted by author.
+*	The workload builds the catalog, appends more books, prints
+*	every author, removes a tenth of the books, and reads the
+*	books of randomly picked authors.
+*
+*	The fixed array, small vector and linked list append and
+*	remove one book at a time, as AddBook and RemoveBook do. CSR
+*	and columnar cannot insert or delete one row cheaply, so they
+*	take every append as one batch merged in by one rebuild, and
+*	every removal as one batch compacted away by one rebuild.
+*	Their rows are marked "(batch)": the append and remove times
+*	are of a bulk load, not of single updates, and are not
+*	comparable with the other layouts. Their access times are of
+*	compacted data with no tombstones.
+*
+*	Every phase reports its time and, on Linux where perf events
+*	are allowed, its cache misses. The heap bytes of each layout
+*	after the appends are counted by replacing operator new. The
+*	printed output and the reads are hashed, and every layout
+*	must produce the same hashes as the fixed array.
+*
+*	Authors are picked with Zipfian skew. An author has at most
+*	MAX_BOOKS_WRITTEN books in every layout, so that all of them
+*	hold the same catalog.
+*
+*	Build on its own, apart from Main.cpp:
+*	g++ -std=c++17 -O2 LayoutBenchmark.cpp
+* Date Created: 2026-10-18
+* Date Modified: 2026-10-18
+****************************************************************/
+
+#include <algorithm>		// Included for std::shuffle and std::lower_bound.
+#include <chrono>			// Included for std::chrono::steady_clock.
+#include <cmath>			// Included for std::pow.
+#include <cstddef>			// Included for std::size_t.
+#include <cstdint>			// Included for std::uint32_t and std::uint64_t.
+#include <cstdlib>			// Included for std::malloc and std::free.
+#include <cstring>			// Included for std::memset.
+#include <iomanip>			// Included for std::setw.
+#include <iostream>			// Included for std::cout.
+#include <new>				// Included for std::bad_alloc.
+#include <ostream>			// Included for std::ostream.
+#include <random>			// Included for std::mt19937_64.
+#include <streambuf>		// Included for std::streambuf.
+#include <string>			// Included for std::string.
+#include <vector>			// Included for std::vector.
+
+#ifdef __linux__
+#include <linux/perf_event.h>	// Included for perf_event_attr.
+#include <sys/ioctl.h>			// Included for ioctl.
+#include <sys/syscall.h>		// Included for SYS_perf_event_open.
+#include <unistd.h>				// Included for syscall, read and close.
+#endif
+
+#include "Catalog.h"		// Included for Person and Book.
+
+constexpr std::size_t BOOKS_PER_AUTHOR = 8;			// Average number of books drawn per author.
+constexpr double APPENDED_SHARE = 0.1;				// Share of the books added one at a time after the build.
+constexpr double REMOVED_SHARE = 0.1;				// Share of the books removed.
+constexpr std::size_t NUM_ACCESSES = 1000000;		// Number of random author reads.
+
+// Bytes currently allocated with operator new. Each allocation carries a header with its size.
+static std::size_t liveBytes = 0;
+constexpr std::size_t ALLOCATION_HEADER = 16;		// Keeps the memory after the header 16 byte aligned.
+
+// Kept out of line, or GCC sees through to malloc and free and warns about the header arithmetic.
+#if defined(__GNUC__)
+#define LAYOUT_NOINLINE __attribute__((noinline))
+#else
+#define LAYOUT_NOINLINE
+#endif
+
+LAYOUT_NOINLINE void* operator new(std::size_t size) {
+	char* memory = static_cast<char*>(std::malloc(size + ALLOCATION_HEADER));
+	if (memory == nullptr) {
+		throw std::bad_alloc();
+	}
+	*reinterpret_cast<std::size_t*>(memory) = size;
+	liveBytes += size;
+	return memory + ALLOCATION_HEADER;
+}
+
+LAYOUT_NOINLINE void operator delete(void* pointer) noexcept {
+	if (pointer) {
+		char* memory = static_cast<char*>(pointer) - ALLOCATION_HEADER;
+		liveBytes -= *reinterpret_cast<std::size_t*>(memory);
+		std::free(memory);
+	}
+}
+
+void operator delete(void* pointer, std::size_t) noexcept {
+	operator delete(pointer);
+}
+
+// Counts cache misses of the calling thread between Start and Stop, where the kernel allows it.
+struct CacheMissCounter {
+	int fd = -1;		// The perf event, or -1 if it could not be opened.
+
+	CacheMissCounter() {
+#ifdef __linux__
+		perf_event_attr attr;
+		std::memset(&attr, 0, sizeof(attr));
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.size = sizeof(attr);
+		attr.config = PERF_COUNT_HW_CACHE_MISSES;
+		attr.disabled = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		this->fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+	}
+	~CacheMissCounter() {
+#ifdef __linux__
+		if (this->fd >= 0) {
+			close(this->fd);
+		}
+#endif
+	}
+
+	void Start() {
+#ifdef __linux__
+		if (this->fd >= 0) {
+			ioctl(this->fd, PERF_EVENT_IOC_RESET, 0);
+			ioctl(this->fd, PERF_EVENT_IOC_ENABLE, 0);
+		}
+#endif
+	}
+
+	// Returns the misses since Start, or -1 if they cannot be counted.
+	long long Stop() {
+		long long count = -1;
+#ifdef __linux__
+		if (this->fd >= 0) {
+			ioctl(this->fd, PERF_EVENT_IOC_DISABLE, 0);
+			if (read(this->fd, &count, sizeof(count)) != static_cast<ssize_t>(sizeof(count))) {
+				count = -1;
+			}
+		}
+#endif
+		return count;
+	}
+};
+
+// A stream buffer that hashes what is printed instead of keeping it.
+struct HashStreambuf : std::streambuf {
+	std::uint64_t hash = 14695981039346656037ull;		// FNV-1a of every byte.
+
+	int_type overflow(int_type c) override {
+		if (!traits_type::eq_int_type(c, traits_type::eof())) {
+			this->hash = (this->hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+		}
+		return traits_type::not_eof(c);
+	}
+
+	std::streamsize xsputn(const char* s, std::streamsize count) override {
+		for (std::streamsize i = 0; i < count; ++i) {
+			this->hash = (this->hash ^ static_cast<unsigned char>(s[i])) * 1099511628211ull;
+		}
+		return count;
+	}
+};
+
+// The catalog and the operations run on it, the same for every layout.
+struct Workload {
+	std::vector<std::string> names;			// Name of each author.
+	std::vector<std::string> titles;		// Title of each book. Books from numInitial on are appended.
+	std::vector<std::uint32_t> pages;		// Page count of each book.
+	std::vector<std::uint32_t> authorOf;	// Author of each book.
+	std::size_t numInitial = 0;				// Number of books in the build.
+	std::vector<std::uint32_t> removals;	// Books to remove, in order.
+	std::vector<std::uint32_t> accesses;	// Authors to read, in order.
+};
+
+// Draws a workload. skew 0 picks authors uniformly, and 1 is the usual Zipf law.
+Workload MakeWorkload(std::size_t numAuthors, double skew, std::uint64_t seed) {
+	Workload workload;
+	std::mt19937_64 rng(seed);
+	std::vector<double> cumulative(numAuthors);
+	double total = 0;
+	for (std::size_t i = 0; i < numAuthors; ++i) {
+		total += 1.0 / std::pow(static_cast<double>(i + 1), skew);
+		cumulative[i] = total;
+	}
+	std::uniform_real_distribution<double> uniform(0, total);
+	auto pick = [&]() {
+		std::size_t author = static_cast<std::size_t>(std::lower_bound(cumulative.begin(), cumulative.end(), uniform(rng)) - cumulative.begin());
+		return static_cast<std::uint32_t>(author < numAuthors ? author : numAuthors - 1);
+	};
+	for (std::size_t i = 0; i < numAuthors; ++i) {
+		workload.names.push_back("Author " + std::to_string(i));
+	}
+	std::vector<std::size_t> counts(numAuthors, 0);
+	for (std::size_t i = 0; i < numAuthors * BOOKS_PER_AUTHOR; ++i) {
+		std::uint32_t author = pick();
+		if (counts[author] == MAX_BOOKS_WRITTEN) {
+			continue;		// The fixed array would drop it, so no layout gets it.
+		}
+		++counts[author];
+		workload.authorOf.push_back(author);
+		workload.titles.push_back("The Collected Works, Volume " + std::to_string(i));
+		workload.pages.push_back(static_cast<std::uint32_t>(50 + rng() % 1500));
+	}
+	workload.numInitial = static_cast<std::size_t>(workload.titles.size() * (1 - APPENDED_SHARE));
+	for (std::uint32_t i = 0; i < workload.titles.size(); ++i) {
+		workload.removals.push_back(i);
+	}
+	std::shuffle(workload.removals.begin(), workload.removals.end(), rng);
+	workload.removals.resize(static_cast<std::size_t>(workload.removals.size() * REMOVED_SHARE));
+	for (std::size_t i = 0; i < NUM_ACCESSES; ++i) {
+		workload.accesses.push_back(pick());
+	}
+	return workload;
+}
+
+// Prints one book in the format of the Book output operator.
+inline void PrintBook(std::ostream& os, const std::string& title, const std::string& author, std::uint32_t pages) {
+	os << "\n - " << title << ", " << author << ", " << pages << " pages";
+}
+
+// The current layout: Person with booksWritten[100], and Books pointing at their Person.
+struct FixedArrayLayout {
+	std::vector<Person> persons;		// The authors.
+	std::vector<Book> books;			// The books, by id. Reserved up front so that pointers stay valid.
+
+	void Build(const Workload& workload) {
+		this->persons.resize(workload.names.size());
+		for (std::size_t i = 0; i < workload.names.size(); ++i) {
+			this->persons[i].name = workload.names[i];
+		}
+		this->books.reserve(workload.titles.size());
+		for (std::size_t i = 0; i < workload.numInitial; ++i) {
+			this->Add(workload, i);
+		}
+	}
+	void Add(const Workload& workload, std::size_t i) {
+		this->books.emplace_back(&this->persons[workload.authorOf[i]], workload.titles[i], workload.pages[i]);
+		this->persons[workload.authorOf[i]].AddBook(&this->books.back());
+	}
+	void Append(const Workload& workload) {
+		for (std::size_t i = workload.numInitial; i < workload.titles.size(); ++i) {
+			this->Add(workload, i);
+		}
+	}
+	void Print(std::ostream& os) const {
+		for (const Person& person : this->persons) {
+			os << person << "\n";
+		}
+	}
+	void Remove(const Workload& workload) {
+		for (std::uint32_t id : workload.removals) {
+			this->persons[workload.authorOf[id]].RemoveBook(&this->books[id]);
+		}
+	}
+	std::uint64_t Access(const Workload& workload) const {
+		std::uint64_t sum = 0;
+		for (std::uint32_t author : workload.accesses) {
+			const Person& person = this->persons[author];
+			for (std::size_t idx = 0; idx < MAX_BOOKS_WRITTEN && person.booksWritten[idx]; ++idx) {
+				sum += person.booksWritten[idx]->numberOfPages;
+			}
+		}
+		return sum;
+	}
+};
+
+// A book of the layouts other than the fixed array. The author is an index.
+struct LayoutBook {
+	std::string title;				// Title of the book.
+	std::uint32_t pages = 0;		// Number of pages.
+	std::uint32_t author = 0;		// Index of the author.
+	LayoutBook* next = nullptr;		// The author's next book, used by the linked list layout only.
+};
+
+// A vector that holds up to N elements inline, and moves to the heap past that.
+template <typename T, std::size_t N>
+struct SmallVector {
+	T inlineItems[N];				// The elements while there are at most N.
+	T* items = inlineItems;			// The elements.
+	std::uint32_t size = 0;			// Number of elements.
+	std::uint32_t capacity = N;		// Number of elements that fit in items.
+
+	SmallVector() = default;
+	SmallVector(const SmallVector&) = delete;
+	SmallVector& operator=(const SmallVector&) = delete;
+	~SmallVector() {
+		if (this->items != this->inlineItems) {
+			delete[] this->items;
+		}
+	}
+	void PushBack(T item) {
+		if (this->size == this->capacity) {
+			T* grown = new T[2 * this->capacity];
+			std::copy(this->items, this->items + this->size, grown);
+			if (this->items != this->inlineItems) {
+				delete[] this->items;
+			}
+			this->items = grown;
+			this->capacity *= 2;
+		}
+		this->items[this->size++] = item;
+	}
+	void Erase(T item) {
+		T* end = this->items + this->size;
+		T* at = std::find(this->items, end, item);
+		if (at != end) {
+			std::copy(at + 1, end, at);
+			--this->size;
+		}
+	}
+};
+
+// Authors with a small vector of book pointers.
+struct SmallVectorLayout {
+	// An author.
+	struct Author {
+		std::string name;						// The name.
+		SmallVector<LayoutBook*, 4> books;		// The books, in order.
+	};
+
+	std::vector<Author> authors;		// The authors.
+	std::vector<LayoutBook> books;		// The books, by id.
+
+	void Build(const Workload& workload) {
+		this->authors = std::vector<Author>(workload.names.size());
+		for (std::size_t i = 0; i < workload.names.size(); ++i) {
+			this->authors[i].name = workload.names[i];
+		}
+		this->books.reserve(workload.titles.size());
+		for (std::size_t i = 0; i < workload.numInitial; ++i) {
+			this->Add(workload, i);
+		}
+	}
+	void Add(const Workload& workload, std::size_t i) {
+		this->books.push_back({ workload.titles[i], workload.pages[i], workload.authorOf[i], nullptr });
+		this->authors[workload.authorOf[i]].books.PushBack(&this->books.back());
+	}
+	void Append(const Workload& workload) {
+		for (std::size_t i = workload.numInitial; i < workload.titles.size(); ++i) {
+			this->Add(workload, i);
+		}
+	}
+	void Print(std::ostream& os) const {
+		for (const Author& author : this->authors) {
+			os << author.name;
+			for (std::uint32_t i = 0; i < author.books.size; ++i) {
+				PrintBook(os, author.books.items[i]->title, author.name, author.books.items[i]->pages);
+			}
+			os << "\n";
+		}
+	}
+	void Remove(const Workload& workload) {
+		for (std::uint32_t id : workload.removals) {
+			this->authors[workload.authorOf[id]].books.Erase(&this->books[id]);
+		}
+	}
+	std::uint64_t Access(const Workload& workload) const {
+		std::uint64_t sum = 0;
+		for (std::uint32_t author : workload.accesses) {
+			const SmallVector<LayoutBook*, 4>& books = this->authors[author].books;
+			for (std::uint32_t i = 0; i < books.size; ++i) {
+				sum += books.items[i]->pages;
+			}
+		}
+		return sum;
+	}
+};
+
+// Compressed sparse rows: the book ids of author a are edges[offsets[a], offsets[a + 1]).
+// Appends are merged in by one rebuild for the whole batch, and removals are compacted away by one rebuild for the whole batch.
+struct CsrLayout {
+	std::vector<std::string> names;				// Name of each author.
+	std::vector<LayoutBook> books;				// The books, by id.
+	std::vector<std::uint32_t> offsets;			// Start of each author's edges, and the end of the last.
+	std::vector<std::uint32_t> edges;			// Ids of the books that are not removed, grouped by author, in order.
+	std::vector<std::uint8_t> removed;			// Whether each book is removed.
+
+	void Build(const Workload& workload) {
+		this->names = workload.names;
+		this->books.reserve(workload.titles.size());
+		for (std::size_t i = 0; i < workload.numInitial; ++i) {
+			this->books.push_back({ workload.titles[i], workload.pages[i], workload.authorOf[i], nullptr });
+		}
+		this->Rebuild();
+	}
+	// Regroups every live book by author with a counting sort, which keeps the books of an author in id order.
+	void Rebuild() {
+		this->removed.resize(this->books.size(), 0);
+		this->offsets.assign(this->names.size() + 1, 0);
+		for (std::size_t id = 0; id < this->books.size(); ++id) {
+			this->offsets[this->books[id].author + 1] += !this->removed[id];
+		}
+		for (std::size_t a = 0; a < this->names.size(); ++a) {
+			this->offsets[a + 1] += this->offsets[a];
+		}
+		this->edges.assign(this->offsets.back(), 0);
+		std::vector<std::uint32_t> next(this->offsets.begin(), this->offsets.end() - 1);
+		for (std::uint32_t id = 0; id < this->books.size(); ++id) {
+			if (!this->removed[id]) {
+				this->edges[next[this->books[id].author]++] = id;
+			}
+		}
+	}
+	void Append(const Workload& workload) {
+		for (std::size_t i = workload.numInitial; i < workload.titles.size(); ++i) {
+			this->books.push_back({ workload.titles[i], workload.pages[i], workload.authorOf[i], nullptr });
+		}
+		this->Rebuild();
+	}
+	void Print(std::ostream& os) const {
+		for (std::size_t a = 0; a < this->names.size(); ++a) {
+			os << this->names[a];
+			for (std::uint32_t e = this->offsets[a]; e < this->offsets[a + 1]; ++e) {
+				PrintBook(os, this->books[this->edges[e]].title, this->names[a], this->books[this->edges[e]].pages);
+			}
+			os << "\n";
+		}
+	}
+	void Remove(const Workload& workload) {
+		for (std::uint32_t id : workload.removals) {
+			this->removed[id] = 1;
+		}
+		this->Rebuild();
+	}
+	std::uint64_t Access(const Workload& workload) const {
+		std::uint64_t sum = 0;
+		for (std::uint32_t author : workload.accesses) {
+			for (std::uint32_t e = this->offsets[author]; e < this->offsets[author + 1]; ++e) {
+				sum += this->books[this->edges[e]].pages;
+			}
+		}
+		return sum;
+	}
+};
+
+// A singly linked list per author through the books, with a tail pointer for O(1) appends.
+struct LinkedListLayout {
+	// An author.
+	struct Author {
+		std::string name;				// The name.
+		LayoutBook* head = nullptr;		// The first book.
+		LayoutBook* tail = nullptr;		// The last book.
+	};
+
+	std::vector<Author> authors;		// The authors.
+	std::vector<LayoutBook> books;		// The books, by id.
+
+	void Build(const Workload& workload) {
+		this->authors.resize(workload.names.size());
+		for (std::size_t i = 0; i < workload.names.size(); ++i) {
+			this->authors[i].name = workload.names[i];
+		}
+		this->books.reserve(workload.titles.size());
+		for (std::size_t i = 0; i < workload.numInitial; ++i) {
+			this->Add(workload, i);
+		}
+	}
+	void Add(const Workload& workload, std::size_t i) {
+		this->books.push_back({ workload.titles[i], workload.pages[i], workload.authorOf[i], nullptr });
+		Author& author = this->authors[workload.authorOf[i]];
+		(author.tail ? author.tail->next : author.head) = &this->books.back();
+		author.tail = &this->books.back();
+	}
+	void Append(const Workload& workload) {
+		for (std::size_t i = workload.numInitial; i < workload.titles.size(); ++i) {
+			this->Add(workload, i);
+		}
+	}
+	void Print(std::ostream& os) const {
+		for (const Author& author : this->authors) {
+			os << author.name;
+			for (const LayoutBook* book = author.head; book; book = book->next) {
+				PrintBook(os, book->title, author.name, book->pages);
+			}
+			os << "\n";
+		}
+	}
+	void Remove(const Workload& workload) {
+		for (std::uint32_t id : workload.removals) {
+			Author& author = this->authors[workload.authorOf[id]];
+			LayoutBook* previous = nullptr;
+			for (LayoutBook* book = author.head; book; previous = book, book = book->next) {
+				if (book == &this->books[id]) {
+					(previous ? previous->next : author.head) = book->next;
+					if (author.tail == book) {
+						author.tail = previous;
+					}
+					break;
+				}
+			}
+		}
+	}
+	std::uint64_t Access(const Workload& workload) const {
+		std::uint64_t sum = 0;
+		for (std::uint32_t author : workload.accesses) {
+			for (const LayoutBook* book = this->authors[author].head; book; book = book->next) {
+				sum += book->pages;
+			}
+		}
+		return sum;
+	}
+};
+
+// Columns of the book fields, sorted by author, so the books of an author are rows [offsets[a], offsets[a + 1]).
+// Appends go to the end of the columns and are sorted in by one rebuild, and removed rows are dropped by one rebuild.
+struct ColumnarLayout {
+	std::vector<std::string> names;			// Name of each author.
+	std::vector<std::string> titles;		// Title of each row.
+	std::vector<std::uint32_t> pages;		// Page count of each row.
+	std::vector<std::uint32_t> authors;		// Author of each row.
+	std::vector<std::uint32_t> ids;			// Book id of each row.
+	std::vector<std::uint8_t> live;			// Whether each row is not removed. Every row is live after a rebuild.
+	std::vector<std::uint32_t> offsets;		// First row of each author, and the end of the last.
+	std::vector<std::uint32_t> rowOf;		// Row of each book id, or UINT32_MAX once it is removed.
+	std::size_t numIds = 0;					// Number of books ever added, so one more than the largest id.
+
+	void Build(const Workload& workload) {
+		this->names = workload.names;
+		for (std::size_t i = 0; i < workload.numInitial; ++i) {
+			this->Add(workload, i);
+		}
+		this->Rebuild();
+	}
+	void Add(const Workload& workload, std::size_t i) {
+		this->titles.push_back(workload.titles[i]);
+		this->pages.push_back(workload.pages[i]);
+		this->authors.push_back(workload.authorOf[i]);
+		this->ids.push_back(static_cast<std::uint32_t>(i));
+		this->live.push_back(1);
+		++this->numIds;
+	}
+	// Sorts the live rows by author and then id with a counting sort, moving every column and dropping removed rows.
+	void Rebuild() {
+		this->offsets.assign(this->names.size() + 1, 0);
+		for (std::size_t row = 0; row < this->titles.size(); ++row) {
+			this->offsets[this->authors[row] + 1] += this->live[row];
+		}
+		for (std::size_t a = 0; a < this->names.size(); ++a) {
+			this->offsets[a + 1] += this->offsets[a];
+		}
+		// The rows are in id order within each author already: the old sorted rows, then the appended ones in id order.
+		// A stable counting sort keeps that only if the old rows come first, which they do.
+		std::size_t numRows = this->offsets.back();
+		std::vector<std::uint32_t> next(this->offsets.begin(), this->offsets.end() - 1);
+		std::vector<std::uint32_t> order(numRows);
+		for (std::uint32_t row = 0; row < this->titles.size(); ++row) {
+			if (this->live[row]) {
+				order[next[this->authors[row]]++] = row;
+			}
+		}
+		std::vector<std::string> titles(numRows);
+		std::vector<std::uint32_t> pages(numRows);
+		std::vector<std::uint32_t> authors(numRows);
+		std::vector<std::uint32_t> ids(numRows);
+		std::vector<std::uint8_t> live(numRows);
+		for (std::size_t row = 0; row < numRows; ++row) {
+			titles[row] = std::move(this->titles[order[row]]);
+			pages[row] = this->pages[order[row]];
+			authors[row] = this->authors[order[row]];
+			ids[row] = this->ids[order[row]];
+			live[row] = this->live[order[row]];
+		}
+		this->titles.swap(titles);
+		this->pages.swap(pages);
+		this->authors.swap(authors);
+		this->ids.swap(ids);
+		this->live.swap(live);
+		this->rowOf.assign(this->numIds, UINT32_MAX);
+		for (std::uint32_t row = 0; row < numRows; ++row) {
+			this->rowOf[this->ids[row]] = row;
+		}
+	}
+	void Append(const Workload& workload) {
+		for (std::size_t i = workload.numInitial; i < workload.titles.size(); ++i) {
+			this->Add(workload, i);
+		}
+		this->Rebuild();
+	}
+	void Print(std::ostream& os) const {
+		for (std::size_t a = 0; a < this->names.size(); ++a) {
+			os << this->names[a];
+			for (std::uint32_t row = this->offsets[a]; row < this->offsets[a + 1]; ++row) {
+				PrintBook(os, this->titles[row], this->names[a], this->pages[row]);
+			}
+			os << "\n";
+		}
+	}
+	void Remove(const Workload& workload) {
+		for (std::uint32_t id : workload.removals) {
+			this->live[this->rowOf[id]] = 0;
+		}
+		this->Rebuild();
+	}
+	std::uint64_t Access(const Workload& workload) const {
+		std::uint64_t sum = 0;
+		for (std::uint32_t author : workload.accesses) {
+			for (std::uint32_t row = this->offsets[author]; row < this->offsets[author + 1]; ++row) {
+				sum += this->pages[row];
+			}
+		}
+		return sum;
+	}
+};
+
+// The results of one layout on one workload.
+struct LayoutResult {
+	double milliseconds[5];			// Time of build, append, print, remove and access.
+	long long cacheMisses[5];		// Cache misses of the same phases, or -1.
+	std::size_t bytes;				// Heap bytes after the appends.
+	std::uint64_t printHash;		// Hash of the printed output.
+	std::uint64_t accessSum;		// Sum of the pages read.
+};
+
+// Runs every phase of the workload over a new Layout.
+template <typename Layout>
+LayoutResult RunLayout(const Workload& workload) {
+	LayoutResult result;
+	CacheMissCounter counter;
+	std::size_t baseBytes = liveBytes;
+	Layout* layout = new Layout();
+	HashStreambuf hashBuffer;
+	std::ostream hashStream(&hashBuffer);
+	auto phase = [&](int index, auto&& work) {
+		counter.Start();
+		std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+		work();
+		result.milliseconds[index] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+		result.cacheMisses[index] = counter.Stop();
+	};
+	phase(0, [&]() { layout->Build(workload); });
+	phase(1, [&]() { layout->Append(workload); });
+	result.bytes = liveBytes - baseBytes;
+	phase(2, [&]() { layout->Print(hashStream); });
+	phase(3, [&]() { layout->Remove(workload); });
+	phase(4, [&]() { result.accessSum = layout->Access(workload); });
+	result.printHash = hashBuffer.hash;
+	delete layout;
+	return result;
+}
+
+// Prints one row of the results table.
+void PrintResult(std::size_t numAuthors, double skew, const char* name, const LayoutResult& result, const LayoutResult& reference) {
+	std::cout << std::fixed << std::setprecision(1);
+	std::cout << std::setw(8) << numAuthors << std::setw(6) << skew << "  " << std::left << std::setw(16) << name << std::right;
+	for (int i = 0; i < 5; ++i) {
+		std::cout << std::setw(9) << result.milliseconds[i];
+	}
+	std::cout << std::setw(9) << std::setprecision(1) << result.bytes / 1e6;
+	for (int i = 0; i < 5; ++i) {
+		if (result.cacheMisses[i] < 0) {
+			std::cout << std::setw(8) << "n/a";
+		}
+		else {
+			std::cout << std::setw(8) << std::setprecision(2) << result.cacheMisses[i] / 1e6;
+		}
+	}
+	bool same = result.printHash == reference.printHash && result.accessSum == reference.accessSum;
+	std::cout << (same ? "  ok" : "  MISMATCH") << "\n";
+}
+
+int main() {
+	std::cout << " authors  skew  layout          build ms append ms print ms remove ms access ms     MB"
+		<< "  build/append/print/remove/access cache misses (M)\n";
+	for (std::size_t numAuthors : { 1000, 10000, 100000 }) {
+		for (double skew : { 0.0, 1.0 }) {
+			Workload workload = MakeWorkload(numAuthors, skew, numAuthors);
+			LayoutResult fixed = RunLayout<FixedArrayLayout>(workload);
+			PrintResult(numAuthors, skew, "fixed[100]", fixed, fixed);
+			PrintResult(numAuthors, skew, "smallvector", RunLayout<SmallVectorLayout>(workload), fixed);
+			PrintResult(numAuthors, skew, "csr (batch)", RunLayout<CsrLayout>(workload), fixed);
+			PrintResult(numAuthors, skew, "linked", RunLayout<LinkedListLayout>(workload), fixed);
+			PrintResult(numAuthors, skew, "columnar (batch)", RunLayout<ColumnarLayout>(workload), fixed);
+		}
+	}
+	std::cout << "(batch): appends merged in, and removals compacted away, by one rebuild per phase, not one book at a time.\n";
+}
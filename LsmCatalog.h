@@ -0,0 +1,678 @@
+/****************************************************************
+* Author: Leo Carroll
+* Description:
+*	A log-structured catalog of (author, title) entries for
+*	write-heavy ingestion. Writes go to an in-memory sorted
+*	memtable. A full memtable is frozen and written by a
+*	background thread to an immutable sorted run file on disk,
+*	so writers never wait on the disk unless the background
+*	thread falls two memtables behind.
+*
+*	Runs are kept in levels. Level 0 holds the runs written from
+*	memtables, which may overlap. Every deeper level holds runs
+*	of disjoint key ranges, and may hold LSM_LEVEL_RATIO times as
+*	many bytes as the level above it. When a level is over its
+*	limit the background thread merges one of its runs into the
+*	overlapping runs of the next level.
+*
+*	A read looks at the memtables and then the runs from newest
+*	to oldest, and the first entry found for a key wins. Every
+*	run has a Bloom filter of its authors and keys, and a sparse
+*	index of every LSM_INDEX_INTERVAL-th key, so most runs that
+*	do not hold an author are skipped without reading the disk,
+*	and the rest are read from the nearest index entry.
+*
+*	Run files are removed when the catalog is destroyed. There is
+*	no write-ahead log, so the catalog is a store for ingesting
+*	and merging books, not a durable database.
+* Date Created: 2026-10-18
+* Date Modified: 2026-10-18
+****************************************************************/
+
+#pragma once
+
+#include <algorithm>			// Included for std::upper_bound and std::max.
+#include <condition_variable>	// Included for std::condition_variable.
+#include <cstddef>				// Included for std::size_t.
+#include <cstdint>				// Included for std::uint32_t and std::uint64_t.
+#include <cstdio>				// Included for std::remove.
+#include <deque>				// Included for std::deque.
+#include <fstream>				// Included for std::ofstream.
+#include <iterator>				// Included for std::prev.
+#include <map>					// Included for std::map.
+#include <memory>				// Included for std::shared_ptr and std::unique_ptr.
+#include <mutex>				// Included for std::mutex and std::unique_lock.
+#include <string>				// Included for std::string.
+#include <string_view>			// Included for std::string_view.
+#include <thread>				// Included for std::thread.
+#include <utility>				// Included for std::pair and std::move.
+#include <vector>				// Included for std::vector.
+
+#include "BloomFilter.h"		// Included for BlockedBloomFilter, BloomHash and BloomCombine.
+#include "ExternalSort.h"		// Included for BookRecord, AppendVarint, AppendFrontCoded, RunReader, LoserTree and RunFilePath.
+
+// Bytes of entries a memtable holds before it is frozen.
+constexpr std::size_t LSM_MEMTABLE_BYTES = 4 << 20;
+// Number of entries between two sparse index entries.
+constexpr std::size_t LSM_INDEX_INTERVAL = 64;
+// Number of level 0 runs that starts a compaction into level 1.
+constexpr std::size_t LSM_LEVEL0_RUNS = 4;
+// How many times larger each level below level 1 may be than the level above it.
+constexpr std::size_t LSM_LEVEL_RATIO = 10;
+// Number of frozen memtables that may wait for the background thread before writers wait too.
+constexpr std::size_t LSM_MAX_IMMUTABLE = 2;
+
+// Orders entries by author and then title.
+using LsmKey = std::pair<std::string, std::string>;
+
+// The value stored for a key. A deleted entry hides older entries of the same key until compaction drops it.
+struct LsmValue {
+	std::uint32_t numberOfPages = 0;	// Number of pages in the book.
+	bool deleted = false;				// Whether the entry records a deletion.
+};
+
+// The sorted entries that writes go to.
+struct LsmMemtable {
+	std::map<LsmKey, LsmValue> entries;		// The entries by key.
+	std::size_t bytes = 0;					// Approximate memory used by the entries.
+};
+
+// Hashes an author, or an author and title, for the Bloom filters. The two are hashed apart, so a run can be checked for either.
+inline std::uint64_t LsmHash(std::string_view author, std::string_view title, bool withTitle) {
+	std::uint64_t hash = BloomHash(author);
+	return withTitle ? BloomCombine(hash, BloomHash(title)) : hash;
+}
+
+// An immutable sorted run file.
+struct LsmRun {
+	std::string path;						// The run file.
+	LsmKey first;							// The smallest key in the run.
+	LsmKey last;							// The largest key in the run.
+	std::size_t count = 0;					// Number of entries.
+	std::size_t bytes = 0;					// Size of the file.
+	BlockedBloomFilter bloom;				// Bloom filter of the authors and keys.
+	std::vector<std::pair<LsmKey, std::uint64_t>> index;	// Key and file offset of every LSM_INDEX_INTERVAL-th entry.
+	bool obsolete = false;					// Set when the run is replaced by compaction. The file is removed with the last reference.
+
+	// Destructor
+	~LsmRun() {
+		if (this->obsolete) {
+			std::remove(this->path.c_str());
+		}
+	}
+
+	bool Seek(RunReader&, const LsmKey&) const;
+};
+
+// Opens the run and positions the reader at the last index entry not after key. The entry there is not front coded.
+inline bool LsmRun::Seek(RunReader& reader, const LsmKey& key) const {
+	std::vector<std::pair<LsmKey, std::uint64_t>>::const_iterator it = std::upper_bound(this->index.begin(), this->index.end(), key,
+		[](const LsmKey& k, const std::pair<LsmKey, std::uint64_t>& entry) { return k < entry.first; });
+	std::uint64_t offset = it == this->index.begin() ? 0 : std::prev(it)->second;
+	if (!reader.Open(this->path, 16 * 1024)) {
+		return false;
+	}
+	reader.file.seekg(static_cast<std::streamoff>(offset));
+	return static_cast<bool>(reader.file);
+}
+
+// Reads the next entry of a run into the reader's current record. Returns false at the end, and sets corrupt if the end came mid-entry.
+inline bool LsmReadEntry(RunReader& reader, LsmValue& value) {
+	unsigned char first = 0;
+	if (!reader.ReadByte(first)) {
+		return false;
+	}
+	--reader.pos;
+	std::uint64_t pages = 0;
+	unsigned char deleted = 0;
+	if (!reader.ReadFrontCoded(reader.current.author) || !reader.ReadFrontCoded(reader.current.title) || !reader.ReadVarint(pages) || !reader.ReadByte(deleted)) {
+		reader.corrupt = true;
+		return false;
+	}
+	value.numberOfPages = static_cast<std::uint32_t>(pages);
+	value.deleted = deleted != 0;
+	return true;
+}
+
+// Writes entries in key order to a new run file, building its index and Bloom filter.
+struct LsmRunWriter {
+	std::shared_ptr<LsmRun> run;	// The run being written.
+	std::ofstream file;				// The run file.
+	std::string out;				// Encoded entries not yet written.
+	BookRecord previous;			// The previous entry, that the next one is front coded against.
+
+	bool Open(const std::string&, std::size_t);
+	bool Add(const std::string&, const std::string&, const LsmValue&);
+	bool Finish();
+};
+
+// Creates the run file. expectedCount sizes the Bloom filter.
+inline bool LsmRunWriter::Open(const std::string& path, std::size_t expectedCount) {
+	this->run = std::make_shared<LsmRun>();
+	this->run->path = path;
+	this->run->bloom.Reserve(2 * expectedCount);		// Two hashes per entry.
+	this->file.open(path, std::ios::binary | std::ios::trunc);
+	return this->file.is_open();
+}
+
+inline bool LsmRunWriter::Add(const std::string& author, const std::string& title, const LsmValue& value) {
+	LsmRun& run = *this->run;
+	if (run.count % LSM_INDEX_INTERVAL == 0) {
+		// Start a block that a reader can seek to, by coding its first entry against nothing.
+		run.index.push_back({ { author, title }, run.bytes + this->out.size() });
+		this->previous.author.clear();
+		this->previous.title.clear();
+	}
+	if (run.count == 0) {
+		run.first = { author, title };
+	}
+	AppendFrontCoded(this->out, author, this->previous.author);
+	AppendFrontCoded(this->out, title, this->previous.title);
+	AppendVarint(this->out, value.numberOfPages);
+	this->out.push_back(value.deleted ? 1 : 0);
+	this->previous.author = author;
+	this->previous.title = title;
+	run.bloom.Add(LsmHash(author, title, false));
+	run.bloom.Add(LsmHash(author, title, true));
+	++run.count;
+	if (this->out.size() >= 64 * 1024) {
+		this->file.write(this->out.data(), static_cast<std::streamsize>(this->out.size()));
+		run.bytes += this->out.size();
+		this->out.clear();
+	}
+	return static_cast<bool>(this->file);
+}
+
+// Writes the rest of the entries and closes the file.
+inline bool LsmRunWriter::Finish() {
+	this->file.write(this->out.data(), static_cast<std::streamsize>(this->out.size()));
+	this->run->bytes += this->out.size();
+	this->run->last = { this->previous.author, this->previous.title };
+	this->out.clear();
+	this->file.close();
+	return !this->file.fail();
+}
+
+// An LSM tree of book entries with a background flushing and compaction thread.
+struct LsmCatalog {
+	std::string directory;									// Where run files are written.
+	std::size_t memtableBytes;								// Bytes of entries a memtable holds before it is frozen.
+	std::mutex mutex;										// Guards every member below.
+	std::condition_variable workReady;						// Signals the background thread.
+	std::condition_variable workDone;						// Signals writers and Flush.
+	std::unique_ptr<LsmMemtable> active;					// The memtable that writes go to.
+	std::deque<std::shared_ptr<const LsmMemtable>> immutables;	// Frozen memtables waiting to be written, newest first.
+	std::vector<std::vector<std::shared_ptr<LsmRun>>> levels;	// Level 0 newest first. Deeper levels in key order.
+	std::vector<LsmKey> compactFrom;						// Per level, the key after which the next run to compact is picked.
+	std::size_t nextRun = 0;								// Number in the name of the next run file.
+	bool busy = false;										// Whether the background thread is writing.
+	bool stopping = false;									// Tells the background thread to exit.
+	bool failed = false;									// Set if a run could not be written.
+	std::thread worker;										// The background thread.
+
+	// Custom constructor
+	// Takes the directory for run files and the size of a memtable.
+	explicit LsmCatalog(const std::string&, std::size_t = LSM_MEMTABLE_BYTES);
+	// Destructor, stops the background thread and removes the run files.
+	~LsmCatalog();
+	LsmCatalog(const LsmCatalog&) = delete;
+	LsmCatalog& operator=(const LsmCatalog&) = delete;
+
+	bool Put(const std::string&, const std::string&, std::uint32_t);
+	bool Delete(const std::string&, const std::string&);
+	bool Get(const std::string&, const std::string&, std::uint32_t&);
+	bool Bibliography(const std::string&, std::vector<BookRecord>&);
+	bool Flush();
+
+	bool Write(const std::string&, const std::string&, LsmValue);
+	void Run();
+	bool NeedsCompaction() const;
+	std::size_t LevelLimit(std::size_t) const;
+	std::shared_ptr<LsmRun> WriteMemtable(const LsmMemtable&);
+	bool Compact();
+	std::string RunPath();
+};
+
+// LsmCatalog custom constructor
+inline LsmCatalog::LsmCatalog(const std::string& directory, std::size_t memtableBytes) {
+	this->directory = directory;
+	this->memtableBytes = memtableBytes;
+	this->active.reset(new LsmMemtable());
+	this->levels.resize(1);
+	this->worker = std::thread([this]() { this->Run(); });
+}
+
+inline LsmCatalog::~LsmCatalog() {
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->stopping = true;
+	}
+	this->workReady.notify_one();
+	this->worker.join();
+	for (std::vector<std::shared_ptr<LsmRun>>& level : this->levels) {
+		for (std::shared_ptr<LsmRun>& run : level) {
+			run->obsolete = true;
+		}
+	}
+}
+
+// Adds or replaces an entry. Returns false if the background thread failed to write a run.
+inline bool LsmCatalog::Put(const std::string& author, const std::string& title, std::uint32_t numberOfPages) {
+	return this->Write(author, title, { numberOfPages, false });
+}
+
+// Deletes an entry by writing a tombstone over it.
+inline bool LsmCatalog::Delete(const std::string& author, const std::string& title) {
+	return this->Write(author, title, { 0, true });
+}
+
+inline bool LsmCatalog::Write(const std::string& author, const std::string& title, LsmValue value) {
+	std::unique_lock<std::mutex> lock(this->mutex);
+	LsmMemtable& memtable = *this->active;
+	std::pair<std::map<LsmKey, LsmValue>::iterator, bool> result = memtable.entries.insert({ { author, title }, value });
+	if (result.second) {
+		memtable.bytes += author.size() + title.size() + sizeof(std::map<LsmKey, LsmValue>::value_type) + 32;		// 32 for the tree node.
+	}
+	else {
+		result.first->second = value;
+	}
+	if (memtable.bytes >= this->memtableBytes) {
+		// Hold writers back while the background thread is behind, so memory stays bounded.
+		this->workDone.wait(lock, [this]() { return this->immutables.size() < LSM_MAX_IMMUTABLE || this->failed; });
+		// Another writer may have frozen it while this one waited.
+		if (this->active->bytes >= this->memtableBytes) {
+			this->immutables.push_front(std::shared_ptr<const LsmMemtable>(this->active.release()));
+			this->active.reset(new LsmMemtable());
+			this->workReady.notify_one();
+		}
+	}
+	return !this->failed;
+}
+
+// Finds the newest entry of a key. Returns false if there is none or it was deleted.
+inline bool LsmCatalog::Get(const std::string& author, const std::string& title, std::uint32_t& numberOfPages) {
+	LsmKey key(author, title);
+	std::vector<std::shared_ptr<const LsmMemtable>> memtables;
+	std::vector<std::shared_ptr<LsmRun>> runs;
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		std::map<LsmKey, LsmValue>::const_iterator it = this->active->entries.find(key);
+		if (it != this->active->entries.end()) {
+			numberOfPages = it->second.numberOfPages;
+			return !it->second.deleted;
+		}
+		memtables.assign(this->immutables.begin(), this->immutables.end());
+		for (const std::vector<std::shared_ptr<LsmRun>>& level : this->levels) {
+			runs.insert(runs.end(), level.begin(), level.end());
+		}
+	}
+	for (const std::shared_ptr<const LsmMemtable>& memtable : memtables) {
+		std::map<LsmKey, LsmValue>::const_iterator it = memtable->entries.find(key);
+		if (it != memtable->entries.end()) {
+			numberOfPages = it->second.numberOfPages;
+			return !it->second.deleted;
+		}
+	}
+	std::uint64_t hash = LsmHash(author, title, true);
+	for (const std::shared_ptr<LsmRun>& run : runs) {
+		if (key < run->first || run->last < key || !run->bloom.MayContain(hash)) {
+			continue;
+		}
+		RunReader reader;
+		LsmValue value;
+		if (!run->Seek(reader, key)) {
+			return false;
+		}
+		while (LsmReadEntry(reader, value)) {
+			int order = reader.current.author.compare(author);
+			order = order != 0 ? order : reader.current.title.compare(title);
+			if (order == 0) {
+				numberOfPages = value.numberOfPages;
+				return !value.deleted;
+			}
+			if (order > 0) {
+				break;
+			}
+		}
+	}
+	return false;
+}
+
+// Collects every live book of the author in title order, merging the memtables and levels. Returns false if a run could not be read.
+inline bool LsmCatalog::Bibliography(const std::string& author, std::vector<BookRecord>& books) {
+	// Newest first, so the first entry seen for a title is its current one.
+	std::map<std::string, LsmValue> titles;
+	std::vector<std::shared_ptr<const LsmMemtable>> memtables;
+	std::vector<std::shared_ptr<LsmRun>> runs;
+	LsmKey start(author, std::string());
+	auto collect = [&](const LsmMemtable& memtable) {
+		for (std::map<LsmKey, LsmValue>::const_iterator it = memtable.entries.lower_bound(start); it != memtable.entries.end() && it->first.first == author; ++it) {
+			titles.insert({ it->first.second, it->second });
+		}
+	};
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		collect(*this->active);
+		memtables.assign(this->immutables.begin(), this->immutables.end());
+		for (const std::vector<std::shared_ptr<LsmRun>>& level : this->levels) {
+			runs.insert(runs.end(), level.begin(), level.end());
+		}
+	}
+	for (const std::shared_ptr<const LsmMemtable>& memtable : memtables) {
+		collect(*memtable);
+	}
+	std::uint64_t hash = LsmHash(author, std::string_view(), false);
+	for (const std::shared_ptr<LsmRun>& run : runs) {
+		if (author < run->first.first || run->last.first < author || !run->bloom.MayContain(hash)) {
+			continue;
+		}
+		RunReader reader;
+		LsmValue value;
+		if (!run->Seek(reader, start)) {
+			return false;
+		}
+		while (LsmReadEntry(reader, value)) {
+			int order = reader.current.author.compare(author);
+			if (order > 0) {
+				break;
+			}
+			if (order == 0) {
+				titles.insert({ reader.current.title, value });
+			}
+		}
+		if (reader.corrupt) {
+			return false;
+		}
+	}
+	books.clear();
+	for (const std::pair<const std::string, LsmValue>& entry : titles) {
+		if (!entry.second.deleted) {
+			books.push_back({ author, entry.first, entry.second.numberOfPages });
+		}
+	}
+	return true;
+}
+
+// Freezes the memtable and waits until it is written and no compaction is due. Returns false if a run could not be written.
+inline bool LsmCatalog::Flush() {
+	std::unique_lock<std::mutex> lock(this->mutex);
+	if (!this->active->entries.empty()) {
+		this->workDone.wait(lock, [this]() { return this->immutables.size() < LSM_MAX_IMMUTABLE || this->failed; });
+		if (!this->active->entries.empty()) {
+			this->immutables.push_front(std::shared_ptr<const LsmMemtable>(this->active.release()));
+			this->active.reset(new LsmMemtable());
+		}
+	}
+	this->workReady.notify_one();
+	this->workDone.wait(lock, [this]() { return this->failed || (this->immutables.empty() && !this->busy && !this->NeedsCompaction()); });
+	return !this->failed;
+}
+
+inline std::string LsmCatalog::RunPath() {
+	return RunFilePath(this->directory, "lsm-run", this, this->nextRun++);
+}
+
+// Bytes that a level may hold before it is compacted. Level 0 is limited by its number of runs instead.
+inline std::size_t LsmCatalog::LevelLimit(std::size_t level) const {
+	std::size_t limit = this->memtableBytes * LSM_LEVEL0_RUNS;
+	for (std::size_t i = 1; i < level; ++i) {
+		limit *= LSM_LEVEL_RATIO;
+	}
+	return limit;
+}
+
+inline bool LsmCatalog::NeedsCompaction() const {
+	if (this->levels[0].size() >= LSM_LEVEL0_RUNS) {
+		return true;
+	}
+	for (std::size_t level = 1; level < this->levels.size(); ++level) {
+		std::size_t bytes = 0;
+		for (const std::shared_ptr<LsmRun>& run : this->levels[level]) {
+			bytes += run->bytes;
+		}
+		if (bytes > this->LevelLimit(level)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// Writes a frozen memtable to a new run. Returns nullptr if it could not be written.
+inline std::shared_ptr<LsmRun> LsmCatalog::WriteMemtable(const LsmMemtable& memtable) {
+	std::string path;
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		path = this->RunPath();
+	}
+	LsmRunWriter writer;
+	if (!writer.Open(path, memtable.entries.size())) {
+		return nullptr;
+	}
+	for (const std::pair<const LsmKey, LsmValue>& entry : memtable.entries) {
+		writer.Add(entry.first.first, entry.first.second, entry.second);
+	}
+	if (!writer.Finish()) {
+		writer.run->obsolete = true;
+		return nullptr;
+	}
+	return writer.run;
+}
+
+// Merges one level into the next: all of level 0, or one run of a deeper level picked round robin, together with
+// the runs of the next level that overlap it. Called by the background thread without the lock held.
+inline bool LsmCatalog::Compact() {
+	std::vector<std::shared_ptr<LsmRun>> inputs;		// Newest first.
+	std::size_t level = 0;
+	bool lastLevel = false;
+	std::size_t runBytes = 2 * this->memtableBytes;
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		if (this->levels[0].size() < LSM_LEVEL0_RUNS) {
+			for (level = 1; level < this->levels.size(); ++level) {
+				std::size_t bytes = 0;
+				for (const std::shared_ptr<LsmRun>& run : this->levels[level]) {
+					bytes += run->bytes;
+				}
+				if (bytes > this->LevelLimit(level)) {
+					break;
+				}
+			}
+			if (level == this->levels.size()) {
+				return true;
+			}
+		}
+		if (this->levels.size() <= level + 1) {
+			this->levels.resize(level + 2);
+			this->compactFrom.resize(level + 2);
+		}
+		LsmKey first;
+		LsmKey last;
+		if (level == 0) {
+			inputs = this->levels[0];
+		}
+		else {
+			// The first run after where the last compaction of this level stopped, so every key range gets its turn.
+			std::vector<std::shared_ptr<LsmRun>>& runs = this->levels[level];
+			std::size_t pick = 0;
+			while (pick < runs.size() && !(this->compactFrom[level] < runs[pick]->first)) {
+				++pick;
+			}
+			pick = pick == runs.size() ? 0 : pick;
+			inputs.push_back(runs[pick]);
+			this->compactFrom[level] = runs[pick]->last;
+		}
+		first = inputs[0]->first;
+		last = inputs[0]->last;
+		for (const std::shared_ptr<LsmRun>& run : inputs) {
+			first = std::min(first, run->first);
+			last = std::max(last, run->last);
+		}
+		for (const std::shared_ptr<LsmRun>& run : this->levels[level + 1]) {
+			if (!(run->last < first) && !(last < run->first)) {
+				inputs.push_back(run);
+			}
+		}
+		// Tombstones can be dropped when nothing older than the output exists below it.
+		lastLevel = true;
+		for (std::size_t deeper = level + 2; deeper < this->levels.size(); ++deeper) {
+			lastLevel = lastLevel && this->levels[deeper].empty();
+		}
+		if (level + 1 > 1) {
+			runBytes = this->LevelLimit(level + 1) / LSM_LEVEL_RATIO;
+		}
+	}
+
+	// Merge with a loser tree. For equal keys the newer input comes first, and the older entries are skipped.
+	std::vector<RunReader> readers(inputs.size());
+	std::vector<LsmValue> values(inputs.size());
+	std::vector<bool> exhausted(inputs.size());
+	for (std::size_t i = 0; i < inputs.size(); ++i) {
+		if (!inputs[i]->Seek(readers[i], LsmKey())) {
+			return false;
+		}
+		exhausted[i] = !LsmReadEntry(readers[i], values[i]);
+	}
+	auto less = [&](std::size_t a, std::size_t b) {
+		if (exhausted[a] || exhausted[b]) {
+			return !exhausted[a] && exhausted[b];
+		}
+		int order = readers[a].current.author.compare(readers[b].current.author);
+		order = order != 0 ? order : readers[a].current.title.compare(readers[b].current.title);
+		return order != 0 ? order < 0 : a < b;
+	};
+	std::size_t total = 0;			// Number of entries in the inputs.
+	std::size_t totalBytes = 0;		// Size of the inputs.
+	for (const std::shared_ptr<LsmRun>& run : inputs) {
+		total += run->count;
+		totalBytes += run->bytes;
+	}
+	// Each output is cut at runBytes, so it holds about runBytes worth of the inputs' average entry, and its Bloom filter
+	// is sized for that many rather than for every input entry. A quarter more covers entries smaller than the average.
+	std::size_t perRun = total;		// Expected entries in one output run.
+	if (runBytes < totalBytes && total != 0) {
+		double entryBytes = static_cast<double>(totalBytes) / static_cast<double>(total);
+		perRun = std::min(total, static_cast<std::size_t>(static_cast<double>(runBytes) / entryBytes * 1.25) + 1);
+	}
+	std::vector<std::shared_ptr<LsmRun>> outputs;
+	LsmRunWriter writer;
+	bool open = false;
+	// Marks the finished outputs and the one being written obsolete, so that their files are removed when they go out of
+	// scope, and a failed compaction leaves nothing behind on disk.
+	auto fail = [&outputs, &writer]() {
+		for (const std::shared_ptr<LsmRun>& run : outputs) {
+			run->obsolete = true;
+		}
+		if (writer.run) {
+			writer.run->obsolete = true;
+		}
+		return false;
+	};
+	BookRecord previous;
+	bool hasPrevious = false;
+	LoserTree tree;
+	tree.Build(readers.size(), less);
+	while (!exhausted[tree.winner]) {
+		const BookRecord& current = readers[tree.winner].current;
+		const LsmValue& value = values[tree.winner];
+		bool duplicate = hasPrevious && current.author == previous.author && current.title == previous.title;
+		if (!duplicate && !(lastLevel && value.deleted)) {
+			if (!open) {
+				std::string path;
+				{
+					std::lock_guard<std::mutex> lock(this->mutex);
+					path = this->RunPath();
+				}
+				if (!writer.Open(path, perRun)) {
+					return fail();
+				}
+				open = true;
+			}
+			writer.Add(current.author, current.title, value);
+			if (writer.run->bytes >= runBytes) {
+				if (!writer.Finish()) {
+					return fail();
+				}
+				outputs.push_back(writer.run);
+				writer = LsmRunWriter();
+				open = false;
+			}
+		}
+		if (!duplicate) {
+			previous.author = current.author;
+			previous.title = current.title;
+			hasPrevious = true;
+		}
+		exhausted[tree.winner] = !LsmReadEntry(readers[tree.winner], values[tree.winner]);
+		tree.Replay(less);
+	}
+	for (const RunReader& reader : readers) {
+		if (reader.corrupt) {
+			return fail();
+		}
+	}
+	if (open) {
+		if (!writer.Finish()) {
+			return fail();
+		}
+		outputs.push_back(writer.run);
+	}
+
+	// Replace the inputs with the outputs. Readers holding the inputs keep them, and their files, until they finish.
+	std::lock_guard<std::mutex> lock(this->mutex);
+	for (std::size_t from : { level, level + 1 }) {
+		std::vector<std::shared_ptr<LsmRun>>& runs = this->levels[from];
+		std::vector<std::shared_ptr<LsmRun>> kept;
+		for (std::shared_ptr<LsmRun>& run : runs) {
+			if (std::find(inputs.begin(), inputs.end(), run) == inputs.end()) {
+				kept.push_back(run);
+			}
+			else {
+				run->obsolete = true;
+			}
+		}
+		runs.swap(kept);
+	}
+	std::vector<std::shared_ptr<LsmRun>>& next = this->levels[level + 1];
+	next.insert(next.end(), outputs.begin(), outputs.end());
+	std::sort(next.begin(), next.end(), [](const std::shared_ptr<LsmRun>& a, const std::shared_ptr<LsmRun>& b) { return a->first < b->first; });
+	return true;
+}
+
+// The background thread: writes frozen memtables, oldest first, then compacts while any level is over its limit.
+// After a failure it only drops frozen memtables, so that writers are not left waiting.
+inline void LsmCatalog::Run() {
+	std::unique_lock<std::mutex> lock(this->mutex);
+	while (true) {
+		this->workReady.wait(lock, [this]() { return this->stopping || !this->immutables.empty() || (this->NeedsCompaction() && !this->failed); });
+		if (this->stopping) {
+			return;
+		}
+		if (!this->immutables.empty()) {
+			std::shared_ptr<const LsmMemtable> memtable = this->immutables.back();
+			std::shared_ptr<LsmRun> run;
+			if (!this->failed) {
+				this->busy = true;
+				lock.unlock();
+				run = this->WriteMemtable(*memtable);
+				lock.lock();
+				this->busy = false;
+			}
+			if (run) {
+				this->levels[0].insert(this->levels[0].begin(), run);
+			}
+			else {
+				this->failed = true;
+			}
+			this->immutables.pop_back();		// Readers see the run before the memtable goes.
+			this->workDone.notify_all();
+			continue;
+		}
+		this->busy = true;
+		lock.unlock();
+		bool compacted = this->Compact();
+		lock.lock();
+		this->busy = false;
+		this->failed = this->failed || !compacted;
+		this->workDone.notify_all();
+	}
+}
@@ -0,0 +1,276 @@
+/****************************************************************
+* Author: Leo Carroll
+* Description:
+*	Materialized views over the catalog. A view is a filter, a
+*	grouping and an optional condition on each group (a 'having'
+*	clause). Each group keeps the count and the sum of pages of
+*	the books that passed the filter. Views are registered with
+*	a ViewRegistry, which listens to the Persons attached to it
+*	and applies each added or removed book to every view, so the
+*	views never have to be recomputed from scratch.
+*
+*	Each view remembers the group and page count that every book
+*	was counted under, so a remove takes out exactly what the add
+*	put in, even if the book has changed in between. A remove of
+*	a book the view does not hold, or a second add of one it
+*	does, is not applied but counted as unmatched, and Verify
+*	reports it.
+*
+*	For example, "authors with more than 10 books over 400 pages"
+*	is a filter on pages > 400, grouped by author, having a count
+*	over 10. A page-count histogram per author is no filter,
+*	grouped by author and pages / 100.
+* Date Created: 2026-10-18
+* Date Modified: 2026-10-18
+****************************************************************/
+
+#pragma once
+
+#include <cstddef>			// Included for std::size_t.
+#include <cstdint>			// Included for std::uint64_t.
+#include <functional>		// Included for std::function and std::hash.
+#include <memory>			// Included for std::unique_ptr.
+#include <string>			// Included for std::string.
+#include <unordered_map>	// Included for std::unordered_map.
+#include <unordered_set>	// Included for std::unordered_set.
+#include <utility>			// Included for std::move.
+#include <vector>			// Included for std::vector.
+
+#include "Catalog.h"		// Included for Person, Book and CatalogListener.
+
+// The group that a book falls in. Views grouped by author use the author, views grouped by a value use the bucket, or both.
+struct ViewKey {
+	const Person* author;		// The author of the group, or nullptr if the view does not group by author.
+	std::uint64_t bucket;		// Any other grouping value, such as pages / 100.
+
+	bool operator==(const ViewKey& other) const { return this->author == other.author && this->bucket == other.bucket; }
+};
+
+// Hash for ViewKey so that it can be used in the unordered containers.
+struct ViewKeyHash {
+	std::size_t operator()(const ViewKey& key) const {
+		return std::hash<const void*>()(key.author) ^ (std::hash<std::uint64_t>()(key.bucket) * 0x9E3779B97F4A7C15ULL);
+	}
+};
+
+// The aggregate kept for each group. Only aggregates that can be undone when a book is removed are kept.
+// The minimum and maximum per author are already kept by Person::stats.
+struct ViewAggregate {
+	std::size_t count = 0;				// Number of books in the group.
+	std::uint64_t totalPages = 0;		// Sum of numberOfPages over the books in the group.
+};
+
+// What a view did with a book when it was added.
+struct ViewMember {
+	ViewKey key;						// The group that the book was counted in.
+	std::uint32_t numberOfPages;		// The page count that the book was counted with.
+	bool counted;						// Whether the book passed the filter, and so was counted at all.
+};
+
+using ViewFilter = std::function<bool(const Person&, const Book&)>;
+using ViewGroup = std::function<ViewKey(const Person&, const Book&)>;
+using ViewHaving = std::function<bool(const ViewAggregate&)>;
+
+struct MaterializedView {
+	std::string name;			// Name that the view was registered under.
+	ViewFilter filter;			// Books that fail the filter are not counted. Empty to count every book.
+	ViewGroup group;			// Picks the group of a book.
+	ViewHaving having;			// Groups that fail this are not rows of the view. Empty to make every group a row.
+	std::unordered_map<ViewKey, ViewAggregate, ViewKeyHash> groups;		// Every group with at least one book.
+	std::unordered_set<ViewKey, ViewKeyHash> rows;						// The groups that pass having.
+	std::unordered_map<const Book*, ViewMember> members;				// Every book added and not yet removed.
+	std::size_t unmatched = 0;											// Removes of books not held, and adds of books already held.
+
+	void Apply(const Person&, const Book&, bool);
+	bool IsRow(const ViewKey&) const;
+	const ViewAggregate* Find(const ViewKey&) const;
+};
+
+// Holds the views, and keeps them up to date by listening to the Persons attached to it.
+struct ViewRegistry : CatalogListener {
+	std::vector<std::unique_ptr<MaterializedView>> views;		// The views. Held by pointer so that references handed out stay valid.
+	std::vector<Person*> attached;								// The Persons whose books are counted.
+
+	MaterializedView& Register(const std::string&, ViewFilter, ViewGroup, ViewHaving = ViewHaving());
+	// Default constructor
+	ViewRegistry() = default;
+	// Destructor, stops listening to the Persons still attached, which must outlive the registry or be detached first.
+	~ViewRegistry() override;
+	ViewRegistry(const ViewRegistry&) = delete;
+	ViewRegistry& operator=(const ViewRegistry&) = delete;
+
+	MaterializedView* Find(const std::string&) const;
+	bool Attach(Person&);
+	void Detach(Person&);
+	bool Verify() const;
+
+	void OnBookAdded(const Person&, const Book&) override;
+	void OnBookRemoved(const Person&, const Book&) override;
+};
+
+// Adds the book to its group if added is true, and takes it out otherwise.
+// A book is taken out of the group and with the page count it was added with. A remove of a book the view does not hold,
+// or an add of one it already holds, changes nothing and is counted in unmatched.
+inline void MaterializedView::Apply(const Person& person, const Book& book, bool added) {
+	std::unordered_map<const Book*, ViewMember>::iterator member = this->members.find(&book);
+	if (added == (member != this->members.end())) {
+		++this->unmatched;
+		return;
+	}
+	ViewMember counted;
+	if (added) {
+		counted.counted = !this->filter || this->filter(person, book);
+		counted.key = counted.counted ? this->group(person, book) : ViewKey{ nullptr, 0 };
+		counted.numberOfPages = book.numberOfPages;
+		this->members.emplace(&book, counted);
+	}
+	else {
+		counted = member->second;
+		this->members.erase(member);
+	}
+	if (!counted.counted) {
+		return;
+	}
+	ViewKey key = counted.key;
+	ViewAggregate& aggregate = this->groups[key];
+	if (added) {
+		++aggregate.count;
+		aggregate.totalPages += counted.numberOfPages;
+	}
+	else {
+		--aggregate.count;
+		aggregate.totalPages -= counted.numberOfPages;
+	}
+	// Only the group that changed can move in or out of the rows.
+	bool isRow = aggregate.count != 0 && (!this->having || this->having(aggregate));
+	if (isRow) {
+		this->rows.insert(key);
+	}
+	else {
+		this->rows.erase(key);
+	}
+	if (aggregate.count == 0) {
+		this->groups.erase(key);		// Empty groups are dropped, so a recompute and the view hold the same groups.
+	}
+}
+
+// Returns whether the group is a row of the view. O(1).
+inline bool MaterializedView::IsRow(const ViewKey& key) const {
+	return this->rows.count(key) != 0;
+}
+
+// Returns the aggregate of the group, or nullptr if it has no books.
+inline const ViewAggregate* MaterializedView::Find(const ViewKey& key) const {
+	std::unordered_map<ViewKey, ViewAggregate, ViewKeyHash>::const_iterator it = this->groups.find(key);
+	return it != this->groups.end() ? &it->second : nullptr;
+}
+
+// Registers a view and fills it from the Persons that are already attached.
+inline MaterializedView& ViewRegistry::Register(const std::string& name, ViewFilter filter, ViewGroup group, ViewHaving having) {
+	std::unique_ptr<MaterializedView> view(new MaterializedView());
+	view->name = name;
+	view->filter = std::move(filter);
+	view->group = std::move(group);
+	view->having = std::move(having);
+	for (Person* person : this->attached) {
+		for (std::size_t idx = 0; idx < MAX_BOOKS_WRITTEN && person->booksWritten[idx]; ++idx) {
+			view->Apply(*person, *person->booksWritten[idx], true);
+		}
+	}
+	this->views.push_back(std::move(view));
+	return *this->views.back();
+}
+
+inline ViewRegistry::~ViewRegistry() {
+	// The views go with the registry, so there is nothing to take the books out of.
+	for (Person* person : this->attached) {
+		person->listener = nullptr;
+	}
+}
+
+// Returns the view registered under the name, or nullptr.
+inline MaterializedView* ViewRegistry::Find(const std::string& name) const {
+	for (const std::unique_ptr<MaterializedView>& view : this->views) {
+		if (view->name == name) {
+			return view.get();
+		}
+	}
+	return nullptr;
+}
+
+// Starts listening to the person and counts the books that it already has.
+// A Person has a single listener, so this returns false, and changes nothing, if another listener is already set.
+inline bool ViewRegistry::Attach(Person& person) {
+	if (person.listener == this) {
+		return true;
+	}
+	if (person.listener != nullptr) {
+		return false;
+	}
+	person.listener = this;
+	this->attached.push_back(&person);
+	for (std::size_t idx = 0; idx < MAX_BOOKS_WRITTEN && person.booksWritten[idx]; ++idx) {
+		this->OnBookAdded(person, *person.booksWritten[idx]);
+	}
+	return true;
+}
+
+// Stops listening to the person and takes its books out of every view.
+inline void ViewRegistry::Detach(Person& person) {
+	if (person.listener != this) {
+		return;
+	}
+	for (std::size_t idx = 0; idx < MAX_BOOKS_WRITTEN && person.booksWritten[idx]; ++idx) {
+		this->OnBookRemoved(person, *person.booksWritten[idx]);
+	}
+	person.listener = nullptr;
+	for (std::size_t i = 0; i < this->attached.size(); ++i) {
+		if (this->attached[i] == &person) {
+			this->attached[i] = this->attached.back();		// Order does not matter, so swap with the last one.
+			this->attached.pop_back();
+			break;
+		}
+	}
+}
+
+inline void ViewRegistry::OnBookAdded(const Person& person, const Book& book) {
+	for (std::unique_ptr<MaterializedView>& view : this->views) {
+		view->Apply(person, book, true);
+	}
+}
+
+inline void ViewRegistry::OnBookRemoved(const Person& person, const Book& book) {
+	for (std::unique_ptr<MaterializedView>& view : this->views) {
+		view->Apply(person, book, false);
+	}
+}
+
+// Recomputes every view from scratch over the attached Persons and compares it with the maintained one.
+// Returns true if they all match and no view has seen an unmatched add or remove. This is meant for testing, it costs a
+// full scan of the catalog.
+inline bool ViewRegistry::Verify() const {
+	for (const std::unique_ptr<MaterializedView>& view : this->views) {
+		if (view->unmatched != 0) {
+			return false;
+		}
+		MaterializedView fresh;
+		fresh.filter = view->filter;
+		fresh.group = view->group;
+		fresh.having = view->having;
+		for (const Person* person : this->attached) {
+			for (std::size_t idx = 0; idx < MAX_BOOKS_WRITTEN && person->booksWritten[idx]; ++idx) {
+				fresh.Apply(*person, *person->booksWritten[idx], true);
+			}
+		}
+		if (fresh.members.size() != view->members.size() || fresh.groups.size() != view->groups.size() || fresh.rows != view->rows) {
+			return false;
+		}
+		for (const std::pair<const ViewKey, ViewAggregate>& entry : fresh.groups) {
+			const ViewAggregate* kept = view->Find(entry.first);
+			if (kept == nullptr || kept->count != entry.second.count || kept->totalPages != entry.second.totalPages) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
@@ -0,0 +1,226 @@
+/****************************************************************
+* Author: Leo Carroll
+* Description:
+*	Output of Persons and Books from many threads at once. Each
+*	thread prints through its own OutputWriter, a std::ostream,
+*	so the existing output operators work unchanged. A writer
+*	formats into a buffer of its own, and once the buffer holds
+*	OUTPUT_BUFFER_BYTES at the end of a record, hands it to the
+*	OutputSink's writer thread. That is the only thread that
+*	touches the real stream, so threads never contend on the
+*	stream's lock, and since buffers only change hands between
+*	records, records are never interleaved.
+*
+*	Buffers are handed over through a lock-free multi-producer,
+*	single-consumer queue: a producer swaps its buffer in as the
+*	new head with one atomic exchange and links the old head to
+*	it. The writer thread only sleeps when the queue is empty.
+*	Flush queues an empty marker buffer, and the writer thread
+*	flushes the real stream when it reaches it, so the stream is
+*	never touched by any other thread.
+* Date Created: 2026-10-18
+* Date Modified: 2026-10-18
+****************************************************************/
+
+#pragma once
+
+#include <atomic>				// Included for std::atomic.
+#include <condition_variable>	// Included for std::condition_variable.
+#include <cstddef>				// Included for std::size_t.
+#include <mutex>				// Included for std::mutex.
+#include <ostream>				// Included for std::ostream.
+#include <streambuf>			// Included for std::streambuf.
+#include <string>				// Included for std::string.
+#include <thread>				// Included for std::thread.
+#include <utility>				// Included for std::move.
+
+// Bytes a writer collects before it hands its buffer over at the next record boundary.
+constexpr std::size_t OUTPUT_BUFFER_BYTES = 64 * 1024;
+
+// A buffer of whole records, and its link in the queue.
+struct OutputBuffer {
+	std::string data;								// The formatted records.
+	bool* flushed = nullptr;						// If set, the writer thread flushes the real stream after data and sets this under the mutex.
+	std::atomic<OutputBuffer*> next{ nullptr };		// The buffer queued after this one.
+};
+
+// Owns the real stream and the thread that writes buffers to it.
+struct OutputSink {
+	std::ostream& out;							// The real stream.
+	std::atomic<OutputBuffer*> head;			// The last buffer queued. Producers exchange it.
+	OutputBuffer* tail;							// The buffer before the next one to write. Only the writer thread uses it.
+	std::atomic<std::size_t> queued{ 0 };		// Number of buffers queued.
+	std::atomic<std::size_t> written{ 0 };		// Number of buffers written to out.
+	std::atomic<bool> sleeping{ false };		// Whether the writer thread is waiting for work.
+	std::atomic<bool> stopping{ false };		// Tells the writer thread to exit once the queue is empty.
+	std::mutex mutex;							// Only for sleeping and waking.
+	std::condition_variable wake;				// Wakes the writer thread.
+	std::condition_variable drained;			// Wakes Flush.
+	std::thread writer;							// The writer thread.
+
+	// Custom constructor
+	explicit OutputSink(std::ostream&);
+	// Destructor, writes every queued buffer and stops the writer thread.
+	~OutputSink();
+	OutputSink(const OutputSink&) = delete;
+	OutputSink& operator=(const OutputSink&) = delete;
+
+	void Push(OutputBuffer*);
+	OutputBuffer* Pop();
+	void Flush();
+	void Run();
+};
+
+// The stream buffer of an OutputWriter. Appends everything to the current buffer.
+struct OutputStreambuf : std::streambuf {
+	OutputBuffer* buffer = new OutputBuffer();		// Records not yet handed over.
+
+	~OutputStreambuf() override {
+		delete this->buffer;
+	}
+
+	int_type overflow(int_type c) override {
+		if (!traits_type::eq_int_type(c, traits_type::eof())) {
+			this->buffer->data.push_back(traits_type::to_char_type(c));
+		}
+		return traits_type::not_eof(c);
+	}
+
+	std::streamsize xsputn(const char* s, std::streamsize count) override {
+		this->buffer->data.append(s, static_cast<std::size_t>(count));
+		return count;
+	}
+};
+
+// A per-thread stream into a sink. Use from one thread, and call EndRecord after each record.
+struct OutputWriter : std::ostream {
+	OutputSink& sink;				// Where full buffers go.
+	OutputStreambuf streambuf;		// Formats into the current buffer.
+
+	// Custom constructor
+	explicit OutputWriter(OutputSink&);
+	// Destructor, hands over the records left.
+	~OutputWriter() override;
+
+	void EndRecord();
+	void Handoff();
+};
+
+// OutputSink custom constructor
+inline OutputSink::OutputSink(std::ostream& out) : out(out) {
+	// The queue always holds one buffer that was already written, or a stub at first, so push and pop never meet at empty.
+	this->tail = new OutputBuffer();
+	this->head.store(this->tail, std::memory_order_relaxed);
+	this->writer = std::thread([this]() { this->Run(); });
+}
+
+inline OutputSink::~OutputSink() {
+	this->stopping.store(true, std::memory_order_seq_cst);
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->wake.notify_one();
+	}
+	this->writer.join();
+	delete this->tail;
+}
+
+// Queues a buffer. Safe from any number of threads.
+inline void OutputSink::Push(OutputBuffer* buffer) {
+	buffer->next.store(nullptr, std::memory_order_relaxed);
+	this->queued.fetch_add(1, std::memory_order_relaxed);
+	OutputBuffer* previous = this->head.exchange(buffer, std::memory_order_acq_rel);
+	// Between the exchange and this store the queue looks shorter to the writer thread, which may then go to sleep. The
+	// store and the load of sleeping are sequentially consistent, as are the writer thread's store of sleeping and load of
+	// the link, so either the writer thread sees the link or this sees it sleeping and wakes it.
+	previous->next.store(buffer, std::memory_order_seq_cst);
+	if (this->sleeping.load(std::memory_order_seq_cst)) {
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->wake.notify_one();
+	}
+}
+
+// Takes the next buffer to write, or returns nullptr if there is none yet. Only the writer thread calls it.
+// The buffer stays in the queue as the new tail, so its data is moved out and the old tail freed instead.
+inline OutputBuffer* OutputSink::Pop() {
+	OutputBuffer* next = this->tail->next.load(std::memory_order_acquire);
+	if (next == nullptr) {
+		return nullptr;
+	}
+	OutputBuffer* done = this->tail;
+	this->tail = next;
+	done->data = std::move(next->data);
+	done->flushed = next->flushed;
+	next->data.clear();
+	return done;
+}
+
+// The writer thread.
+inline void OutputSink::Run() {
+	while (true) {
+		OutputBuffer* buffer = this->Pop();
+		if (buffer) {
+			this->out.write(buffer->data.data(), static_cast<std::streamsize>(buffer->data.size()));
+			if (buffer->flushed) {
+				this->out.flush();
+				std::lock_guard<std::mutex> lock(this->mutex);		// Flush checks the flag under the mutex, so it cannot miss this.
+				*buffer->flushed = true;
+				this->drained.notify_all();
+			}
+			delete buffer;
+			this->written.fetch_add(1, std::memory_order_release);
+			continue;
+		}
+		if (this->stopping.load(std::memory_order_seq_cst) && this->written.load() == this->queued.load()) {
+			this->out.flush();
+			return;
+		}
+		std::unique_lock<std::mutex> lock(this->mutex);
+		this->sleeping.store(true, std::memory_order_seq_cst);
+		// Recheck after announcing the sleep. A push whose link is stored after this load sees sleeping and wakes the
+		// thread, and it has to take the mutex to do so, so the wakeup cannot come before the wait.
+		if (this->tail->next.load(std::memory_order_seq_cst) == nullptr && !this->stopping.load(std::memory_order_seq_cst)) {
+			this->wake.wait(lock);
+		}
+		this->sleeping.store(false, std::memory_order_relaxed);
+	}
+}
+
+// Waits until every buffer queued so far is written and the real stream is flushed.
+// The flush is queued as a marker for the writer thread, as out may only be used from that thread. The buffers are
+// written in queue order, so once the marker is, so is every buffer queued before it.
+inline void OutputSink::Flush() {
+	bool flushed = false;
+	OutputBuffer* marker = new OutputBuffer();
+	marker->flushed = &flushed;
+	this->Push(marker);
+	std::unique_lock<std::mutex> lock(this->mutex);
+	while (!flushed) {
+		this->drained.wait(lock);
+	}
+}
+
+// OutputWriter custom constructor
+inline OutputWriter::OutputWriter(OutputSink& sink) : std::ostream(nullptr), sink(sink) {
+	this->rdbuf(&this->streambuf);
+}
+
+inline OutputWriter::~OutputWriter() {
+	this->Handoff();
+}
+
+// Marks the end of a record. The buffer is handed over once it is large enough, so a record is never split.
+inline void OutputWriter::EndRecord() {
+	if (this->streambuf.buffer->data.size() >= OUTPUT_BUFFER_BYTES) {
+		this->Handoff();
+	}
+}
+
+// Hands the buffer over now, whatever its size. Call only at a record boundary.
+inline void OutputWriter::Handoff() {
+	if (this->streambuf.buffer->data.empty()) {
+		return;
+	}
+	this->sink.Push(this->streambuf.buffer);
+	this->streambuf.buffer = new OutputBuffer();
+	this->streambuf.buffer->data.reserve(OUTPUT_BUFFER_BYTES + OUTPUT_BUFFER_BYTES / 4);
+}
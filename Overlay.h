@@ -0,0 +1,298 @@
+/****************************************************************
+* Author: Leo Carroll
+* Description:
+*	Request-scoped overlays for what-if queries on the catalog.
+*	A CatalogOverlay records books added to existing Persons and
+*	new authors with their books, on top of a base catalog that
+*	it never changes. Reads through the overlay see the base
+*	books of an author followed by the books the overlay added,
+*	in the same formats as the Person output operator, while
+*	every other reader keeps reading the base at full speed.
+*
+*	Everything an overlay records, including the copies of its
+*	strings and its table of touched authors, is allocated from
+*	an OverlayArena by bumping a pointer. Nothing is freed one by
+*	one: Discard rewinds the arena in O(1), keeping its blocks
+*	for the next request. The base must not change while an
+*	overlay on it is in use.
+* Date Created: 2026-10-18
+* Date Modified: 2026-10-18
+****************************************************************/
+
+#pragma once
+
+#include <cstddef>			// Included for std::size_t.
+#include <cstdint>			// Included for std::uint32_t and std::uintptr_t.
+#include <cstring>			// Included for std::memcpy and std::memset.
+#include <memory>			// Included for std::unique_ptr.
+#include <new>				// Included for placement new.
+#include <ostream>			// Included for std::ostream.
+#include <string_view>		// Included for std::string_view.
+#include <type_traits>		// Included for std::is_trivially_destructible.
+#include <utility>			// Included for std::forward.
+#include <vector>			// Included for std::vector.
+
+#include "Catalog.h"		// Included for Person, Book and BookStats.
+
+// Size of the first block of an arena. Each new block is twice the size of the one before.
+constexpr std::size_t OVERLAY_BLOCK_BYTES = 64 * 1024;
+
+// Hands out memory by bumping a pointer through a list of blocks. Objects in it are never destroyed, so only trivially
+// destructible types may be put in it.
+struct OverlayArena {
+	std::vector<std::unique_ptr<char[]>> blocks;		// The blocks, each kept across Reset.
+	std::vector<std::size_t> blockSizes;				// Bytes in each block.
+	std::size_t current = 0;							// The block being allocated from.
+	std::size_t used = 0;								// Bytes used in the current block.
+
+	void* Allocate(std::size_t, std::size_t);
+	template <typename T, typename... Args>
+	T* New(Args&&...);
+	std::string_view Copy(std::string_view);
+	void Reset();
+};
+
+struct OverlayBook;
+
+// An author that an overlay added books to: an existing Person of the base, or a new author of the overlay.
+struct OverlayAuthor {
+	const Person* base;					// The Person in the base, or nullptr for a new author.
+	std::string_view name;				// The name of the author.
+	OverlayBook* firstBook;				// The first book the overlay added, or nullptr.
+	OverlayBook* lastBook;				// The last book the overlay added, or nullptr.
+	std::uint32_t numBooks;				// Number of books the overlay added.
+	OverlayAuthor* next;				// The next new author, for new authors only.
+};
+
+// A book added by an overlay.
+struct OverlayBook {
+	std::string_view title;				// Title of the book.
+	OverlayAuthor* author;				// The author.
+	OverlayBook* nextBook;				// The author's next added book, or nullptr.
+	std::uint32_t numberOfPages;		// Number of pages in the book.
+};
+
+// Pending additions on top of an immutable base catalog.
+struct CatalogOverlay {
+	OverlayArena arena;							// Where everything below is allocated.
+	OverlayAuthor** slots = nullptr;			// Open-addressed table of the touched base Persons, nullptr for a free slot.
+	std::size_t capacity = 0;					// Number of slots, a power of two.
+	std::size_t numTouched = 0;					// Number of base Persons in the table.
+	OverlayAuthor* firstNewAuthor = nullptr;	// The new authors, in the order they were added.
+	OverlayAuthor* lastNewAuthor = nullptr;		// The last new author.
+	std::size_t numNewAuthors = 0;				// Number of new authors.
+	std::size_t numBooks = 0;					// Number of books added.
+
+	OverlayAuthor* AddPerson(std::string_view);
+	OverlayBook* AddBook(const Person&, std::string_view, std::uint32_t);
+	OverlayBook* AddBook(OverlayAuthor&, std::string_view, std::uint32_t);
+	const OverlayAuthor* Find(const Person&) const;
+	std::size_t NumBooks(const Person&) const;
+	BookStats Stats(const Person&) const;
+	template <typename Func>
+	void ForEachBook(const Person&, Func&&) const;
+	void Print(std::ostream&, const Person&) const;
+	void Print(std::ostream&, const OverlayAuthor&) const;
+	void Discard();
+
+	OverlayAuthor* Touch(const Person&);
+	void Grow();
+	std::size_t Slot(const Person*) const;
+};
+
+// Returns bytes aligned to align, a power of two of at most alignof(std::max_align_t).
+inline void* OverlayArena::Allocate(std::size_t bytes, std::size_t align) {
+	while (this->current < this->blocks.size()) {
+		std::size_t start = (this->used + align - 1) & ~(align - 1);
+		if (start + bytes <= this->blockSizes[this->current]) {
+			this->used = start + bytes;
+			return this->blocks[this->current].get() + start;
+		}
+		++this->current;		// Move on to the next block kept from before a Reset, or past the last one.
+		this->used = 0;
+	}
+	std::size_t size = this->blockSizes.empty() ? OVERLAY_BLOCK_BYTES : 2 * this->blockSizes.back();
+	while (size < bytes) {
+		size *= 2;
+	}
+	this->blocks.emplace_back(new char[size]);
+	this->blockSizes.push_back(size);
+	this->current = this->blocks.size() - 1;
+	this->used = bytes;
+	return this->blocks.back().get();
+}
+
+template <typename T, typename... Args>
+inline T* OverlayArena::New(Args&&... args) {
+	static_assert(std::is_trivially_destructible<T>::value, "Objects in an OverlayArena are never destroyed.");
+	return new (this->Allocate(sizeof(T), alignof(T))) T{ std::forward<Args>(args)... };
+}
+
+// Copies a string into the arena, and returns the copy.
+inline std::string_view OverlayArena::Copy(std::string_view text) {
+	if (text.empty()) {
+		return std::string_view();
+	}
+	char* copy = static_cast<char*>(this->Allocate(text.size(), 1));
+	std::memcpy(copy, text.data(), text.size());
+	return std::string_view(copy, text.size());
+}
+
+// Forgets every allocation in O(1). The blocks are kept, so a later request of the same size allocates nothing.
+inline void OverlayArena::Reset() {
+	this->current = 0;
+	this->used = 0;
+}
+
+// Adds a new author.
+inline OverlayAuthor* CatalogOverlay::AddPerson(std::string_view name) {
+	OverlayAuthor* author = this->arena.New<OverlayAuthor>(nullptr, this->arena.Copy(name), nullptr, nullptr, 0u, nullptr);
+	if (this->lastNewAuthor) {
+		this->lastNewAuthor->next = author;
+	}
+	else {
+		this->firstNewAuthor = author;
+	}
+	this->lastNewAuthor = author;
+	++this->numNewAuthors;
+	return author;
+}
+
+// Adds a book to an existing Person. Returns nullptr, adding nothing, if the Person would pass MAX_BOOKS_WRITTEN books,
+// as Person::AddBook would refuse the book once the overlay is applied.
+inline OverlayBook* CatalogOverlay::AddBook(const Person& person, std::string_view title, std::uint32_t pages) {
+	if (this->NumBooks(person) >= MAX_BOOKS_WRITTEN) {
+		return nullptr;
+	}
+	return this->AddBook(*this->Touch(person), title, pages);
+}
+
+// Adds a book to an author of this overlay.
+inline OverlayBook* CatalogOverlay::AddBook(OverlayAuthor& author, std::string_view title, std::uint32_t pages) {
+	OverlayBook* book = this->arena.New<OverlayBook>(this->arena.Copy(title), &author, nullptr, pages);
+	if (author.lastBook) {
+		author.lastBook->nextBook = book;
+	}
+	else {
+		author.firstBook = book;
+	}
+	author.lastBook = book;
+	++author.numBooks;
+	++this->numBooks;
+	return book;
+}
+
+inline std::size_t CatalogOverlay::Slot(const Person* person) const {
+	// Multiplying by an odd constant and keeping the high bits mixes the address bits that differ between Persons.
+	std::uint64_t hash = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(person)) * 0x9E3779B97F4A7C15ull;
+	return static_cast<std::size_t>(hash >> 32) & (this->capacity - 1);
+}
+
+// Returns the entry of a base Person, or nullptr if the overlay added nothing to it.
+inline const OverlayAuthor* CatalogOverlay::Find(const Person& person) const {
+	if (this->numTouched == 0) {
+		return nullptr;
+	}
+	for (std::size_t slot = this->Slot(&person); this->slots[slot]; slot = (slot + 1) & (this->capacity - 1)) {
+		if (this->slots[slot]->base == &person) {
+			return this->slots[slot];
+		}
+	}
+	return nullptr;
+}
+
+// Returns the entry of a base Person, creating it on first use.
+inline OverlayAuthor* CatalogOverlay::Touch(const Person& person) {
+	if (const OverlayAuthor* found = this->Find(person)) {
+		return const_cast<OverlayAuthor*>(found);
+	}
+	if (2 * (this->numTouched + 1) > this->capacity) {
+		this->Grow();
+	}
+	std::size_t slot = this->Slot(&person);
+	while (this->slots[slot]) {
+		slot = (slot + 1) & (this->capacity - 1);
+	}
+	this->slots[slot] = this->arena.New<OverlayAuthor>(&person, std::string_view(person.name), nullptr, nullptr, 0u, nullptr);
+	++this->numTouched;
+	return this->slots[slot];
+}
+
+// Doubles the table. The old one stays in the arena until Discard.
+inline void CatalogOverlay::Grow() {
+	OverlayAuthor** old = this->slots;
+	std::size_t oldCapacity = this->capacity;
+	this->capacity = oldCapacity ? 2 * oldCapacity : 64;
+	this->slots = static_cast<OverlayAuthor**>(this->arena.Allocate(this->capacity * sizeof(OverlayAuthor*), alignof(OverlayAuthor*)));
+	std::memset(this->slots, 0, this->capacity * sizeof(OverlayAuthor*));
+	for (std::size_t i = 0; i < oldCapacity; ++i) {
+		if (old[i]) {
+			std::size_t slot = this->Slot(old[i]->base);
+			while (this->slots[slot]) {
+				slot = (slot + 1) & (this->capacity - 1);
+			}
+			this->slots[slot] = old[i];
+		}
+	}
+}
+
+// Returns the number of books of the Person with the overlay applied.
+inline std::size_t CatalogOverlay::NumBooks(const Person& person) const {
+	const OverlayAuthor* author = this->Find(person);
+	return person.stats.count + (author ? author->numBooks : 0);
+}
+
+// Returns the totals of the Person's books with the overlay applied.
+inline BookStats CatalogOverlay::Stats(const Person& person) const {
+	BookStats stats = person.stats;
+	const OverlayAuthor* author = this->Find(person);
+	for (const OverlayBook* book = author ? author->firstBook : nullptr; book; book = book->nextBook) {
+		stats.Add(book->numberOfPages);
+	}
+	return stats;
+}
+
+// Calls func(title, pages) for every book of the Person with the overlay applied: the base books, then the added ones.
+template <typename Func>
+inline void CatalogOverlay::ForEachBook(const Person& person, Func&& func) const {
+	for (std::size_t idx = 0; idx < MAX_BOOKS_WRITTEN && person.booksWritten[idx]; ++idx) {
+		func(std::string_view(person.booksWritten[idx]->title), person.booksWritten[idx]->numberOfPages);
+	}
+	const OverlayAuthor* author = this->Find(person);
+	for (const OverlayBook* book = author ? author->firstBook : nullptr; book; book = book->nextBook) {
+		func(book->title, book->numberOfPages);
+	}
+}
+
+// Outputs the Person with the overlay applied, in the same format as the Person output operator.
+// Base books go through the Book output operator, so they show their own author. Added books are by the Person.
+inline void CatalogOverlay::Print(std::ostream& os, const Person& person) const {
+	os << person.name;
+	for (std::size_t idx = 0; idx < MAX_BOOKS_WRITTEN && person.booksWritten[idx]; ++idx) {
+		os << "\n - " << *person.booksWritten[idx];
+	}
+	const OverlayAuthor* author = this->Find(person);
+	for (const OverlayBook* book = author ? author->firstBook : nullptr; book; book = book->nextBook) {
+		os << "\n - " << book->title << ", " << person.name << ", " << book->numberOfPages << " pages";
+	}
+}
+
+// Outputs a new author of the overlay, in the same format as the Person output operator.
+inline void CatalogOverlay::Print(std::ostream& os, const OverlayAuthor& author) const {
+	os << author.name;
+	for (const OverlayBook* book = author.firstBook; book; book = book->nextBook) {
+		os << "\n - " << book->title << ", " << author.name << ", " << book->numberOfPages << " pages";
+	}
+}
+
+// Drops everything the overlay recorded, in O(1). Pointers it handed out are invalid afterwards.
+inline void CatalogOverlay::Discard() {
+	this->arena.Reset();
+	this->slots = nullptr;
+	this->capacity = 0;
+	this->numTouched = 0;
+	this->firstNewAuthor = nullptr;
+	this->lastNewAuthor = nullptr;
+	this->numNewAuthors = 0;
+	this->numBooks = 0;
+}
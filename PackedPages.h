@@ -0,0 +1,333 @@
+/****************************************************************
+* Author: Leo Carroll
+* Description:
+*	A compressed column of page counts. Values are split into
+*	blocks of PACKED_BLOCK_SIZE. Each block stores its smallest
+*	value (the frame of reference) and its largest, and packs
+*	every value as its difference from the smallest in just
+*	enough bits for the largest difference. Page counts of one
+*	catalog usually differ by less than a few thousand, so a
+*	block takes 10 to 12 bits per value instead of 32.
+*
+*	The bits of a block are laid out in four interleaved lanes,
+*	value i going to lane i % 4, so that one SSE2 shift and mask
+*	unpacks four consecutive values at once. The filter and
+*	aggregate kernels work on the packed blocks: a block whose
+*	range is wholly inside or outside a filter is decided from
+*	its header alone, and minimum and maximum never unpack.
+* Date Created: 2026-10-18
+* Date Modified: 2026-10-18
+****************************************************************/
+
+#pragma once
+
+#include <array>			// Included for std::array.
+#include <cstddef>			// Included for std::size_t.
+#include <cstdint>			// Included for std::uint32_t and std::uint64_t.
+#include <utility>			// Included for std::index_sequence.
+#include <vector>			// Included for std::vector.
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>		// Included for the SSE2 intrinsics.
+#define CATALOG_PACKED_SSE2 1
+#endif
+
+// Number of values in a block. Four lanes of 32 values, each lane packed into whole 32 bit words.
+constexpr std::size_t PACKED_BLOCK_SIZE = 128;
+
+// A packed column of page counts.
+struct PackedPages {
+	// The header of a block.
+	struct Block {
+		std::uint32_t base;			// The smallest value in the block.
+		std::uint32_t max;			// The largest value in the block.
+		std::uint32_t firstWord;	// Index of the block's first word in words.
+		std::uint32_t width;		// Bits per packed value, 0 to 32.
+	};
+
+	std::vector<Block> blocks;				// The block headers.
+	std::vector<std::uint32_t> words;		// The packed values. A block of width w takes 4 * w words.
+	std::size_t count = 0;					// Number of values.
+
+	void Build(const std::uint32_t*, std::size_t);
+	void Build(const std::vector<std::uint32_t>&);
+	std::uint32_t Get(std::size_t) const;
+	void Unpack(std::size_t, std::uint32_t*) const;
+	void UnpackDeltas(std::size_t, std::uint32_t*) const;
+	std::size_t BlockCount(std::size_t) const;
+	std::size_t CountInRange(std::uint32_t, std::uint32_t) const;
+	void FilterRange(std::uint32_t, std::uint32_t, std::vector<std::uint32_t>&) const;
+	std::uint64_t Sum() const;
+	std::uint32_t Min() const;
+	std::uint32_t Max() const;
+	std::size_t Bytes() const;
+};
+
+// Number of values in a block. Only the last block may be short.
+inline std::size_t PackedPages::BlockCount(std::size_t block) const {
+	std::size_t start = block * PACKED_BLOCK_SIZE;
+	return this->count - start < PACKED_BLOCK_SIZE ? this->count - start : PACKED_BLOCK_SIZE;
+}
+
+// Packs the values. A short last block is padded with its base, which packs as 0.
+inline void PackedPages::Build(const std::uint32_t* values, std::size_t count) {
+	this->count = count;
+	this->blocks.clear();
+	this->words.clear();
+	for (std::size_t start = 0; start < count; start += PACKED_BLOCK_SIZE) {
+		std::size_t n = count - start < PACKED_BLOCK_SIZE ? count - start : PACKED_BLOCK_SIZE;
+		Block block;
+		block.base = values[start];
+		block.max = values[start];
+		for (std::size_t i = 1; i < n; ++i) {
+			block.base = values[start + i] < block.base ? values[start + i] : block.base;
+			block.max = values[start + i] > block.max ? values[start + i] : block.max;
+		}
+		block.width = 0;
+		while (block.width < 32 && ((block.max - block.base) >> block.width) != 0) {
+			++block.width;
+		}
+		block.firstWord = static_cast<std::uint32_t>(this->words.size());
+		this->words.resize(this->words.size() + 4 * block.width, 0);
+		std::uint32_t* out = this->words.data() + block.firstWord;
+		for (std::size_t i = 0; i < n && block.width > 0; ++i) {
+			std::uint32_t delta = values[start + i] - block.base;
+			std::size_t lane = i % 4;
+			std::size_t bit = (i / 4) * block.width;
+			std::size_t word = bit / 32;
+			std::size_t shift = bit % 32;
+			out[word * 4 + lane] |= delta << shift;
+			if (shift + block.width > 32) {
+				out[(word + 1) * 4 + lane] |= delta >> (32 - shift);
+			}
+		}
+		this->blocks.push_back(block);
+	}
+}
+
+inline void PackedPages::Build(const std::vector<std::uint32_t>& values) {
+	this->Build(values.data(), values.size());
+}
+
+// Returns one value without unpacking its block.
+inline std::uint32_t PackedPages::Get(std::size_t index) const {
+	const Block& block = this->blocks[index / PACKED_BLOCK_SIZE];
+	if (block.width == 0) {
+		return block.base;
+	}
+	std::size_t i = index % PACKED_BLOCK_SIZE;
+	const std::uint32_t* in = this->words.data() + block.firstWord;
+	std::size_t bit = (i / 4) * block.width;
+	std::size_t word = bit / 32;
+	std::size_t shift = bit % 32;
+	std::uint64_t pair = in[word * 4 + i % 4];
+	if (shift + block.width > 32) {
+		pair |= static_cast<std::uint64_t>(in[(word + 1) * 4 + i % 4]) << 32;
+	}
+	std::uint64_t mask = (1ull << block.width) - 1;
+	return block.base + static_cast<std::uint32_t>((pair >> shift) & mask);
+}
+
+// Unpacks the differences from the base of all PACKED_BLOCK_SIZE values of a block of the given width.
+// The width is a template argument so that every shift is a constant and the loop unrolls.
+template <unsigned Width>
+inline void PackedUnpackDeltas(const std::uint32_t* in, std::uint32_t* out) {
+	if (Width == 0) {
+		for (std::size_t i = 0; i < PACKED_BLOCK_SIZE; ++i) {
+			out[i] = 0;
+		}
+		return;
+	}
+	constexpr std::uint32_t MASK = Width >= 32 ? ~0u : (1u << (Width % 32)) - 1;
+#ifdef CATALOG_PACKED_SSE2
+	// Four lanes at once: the j-th value of every lane sits at the same bit offset in the lane's words.
+	const __m128i mask = _mm_set1_epi32(static_cast<int>(MASK));
+	for (unsigned j = 0; j < PACKED_BLOCK_SIZE / 4; ++j) {
+		const unsigned bit = j * Width;
+		const unsigned shift = bit % 32;
+		const __m128i* at = reinterpret_cast<const __m128i*>(in + (bit / 32) * 4);
+		__m128i value = _mm_srli_epi32(_mm_loadu_si128(at), static_cast<int>(shift));
+		if (shift + Width > 32) {
+			value = _mm_or_si128(value, _mm_slli_epi32(_mm_loadu_si128(at + 1), static_cast<int>((32 - shift) % 32)));
+		}
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4 * j), _mm_and_si128(value, mask));
+	}
+#else
+	for (unsigned j = 0; j < PACKED_BLOCK_SIZE / 4; ++j) {
+		const unsigned bit = j * Width;
+		const unsigned shift = bit % 32;
+		const std::uint32_t* at = in + (bit / 32) * 4;
+		for (unsigned lane = 0; lane < 4; ++lane) {
+			std::uint32_t value = at[lane] >> shift;
+			if (shift + Width > 32) {
+				value |= at[4 + lane] << ((32 - shift) % 32);
+			}
+			out[4 * j + lane] = value & MASK;
+		}
+	}
+#endif
+}
+
+// A PackedUnpackDeltas for one width.
+using PackedUnpackFunction = void (*)(const std::uint32_t*, std::uint32_t*);
+
+// Builds the table of PackedUnpackDeltas by width.
+template <std::size_t... Widths>
+constexpr std::array<PackedUnpackFunction, sizeof...(Widths)> PackedUnpackTable(std::index_sequence<Widths...>) {
+	return { { &PackedUnpackDeltas<static_cast<unsigned>(Widths)>... } };
+}
+
+// PackedUnpackDeltas for every width from 0 to 32.
+constexpr std::array<PackedUnpackFunction, 33> PACKED_UNPACK = PackedUnpackTable(std::make_index_sequence<33>());
+
+// Unpacks the differences from the base of all PACKED_BLOCK_SIZE values of a block, padding included, into out.
+inline void PackedPages::UnpackDeltas(std::size_t blockIndex, std::uint32_t* out) const {
+	const Block& block = this->blocks[blockIndex];
+	PACKED_UNPACK[block.width](this->words.data() + block.firstWord, out);
+}
+
+// Unpacks all PACKED_BLOCK_SIZE values of a block, padding included, into out.
+inline void PackedPages::Unpack(std::size_t blockIndex, std::uint32_t* out) const {
+	this->UnpackDeltas(blockIndex, out);
+	std::uint32_t base = this->blocks[blockIndex].base;
+	for (std::size_t i = 0; i < PACKED_BLOCK_SIZE; ++i) {
+		out[i] += base;
+	}
+}
+
+// Counts the unpacked differences in [low, high], over whole vectors. Padding must not match, which the caller ensures
+// by counting a short block separately.
+inline std::size_t PackedCountDeltas(const std::uint32_t* deltas, std::uint32_t low, std::uint32_t high) {
+#ifdef CATALOG_PACKED_SSE2
+	// SSE2 only compares signed numbers, so flip the sign bits to compare unsigned ones.
+	const __m128i sign = _mm_set1_epi32(static_cast<int>(0x80000000u));
+	const __m128i lowVector = _mm_set1_epi32(static_cast<int>(low ^ 0x80000000u));
+	const __m128i highVector = _mm_set1_epi32(static_cast<int>(high ^ 0x80000000u));
+	__m128i counts = _mm_setzero_si128();
+	for (std::size_t i = 0; i < PACKED_BLOCK_SIZE; i += 4) {
+		__m128i value = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(deltas + i)), sign);
+		__m128i outside = _mm_or_si128(_mm_cmplt_epi32(value, lowVector), _mm_cmpgt_epi32(value, highVector));
+		counts = _mm_sub_epi32(counts, _mm_andnot_si128(outside, _mm_set1_epi32(-1)));		// Adds 1 per match.
+	}
+	std::uint32_t lanes[4];
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), counts);
+	return static_cast<std::size_t>(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+#else
+	std::size_t matches = 0;
+	for (std::size_t i = 0; i < PACKED_BLOCK_SIZE; ++i) {
+		matches += deltas[i] >= low && deltas[i] <= high;
+	}
+	return matches;
+#endif
+}
+
+// Counts the values in [low, high].
+inline std::size_t PackedPages::CountInRange(std::uint32_t low, std::uint32_t high) const {
+	std::size_t matches = 0;
+	std::uint32_t deltas[PACKED_BLOCK_SIZE];
+	for (std::size_t b = 0; b < this->blocks.size(); ++b) {
+		const Block& block = this->blocks[b];
+		std::size_t n = this->BlockCount(b);
+		if (block.max < low || block.base > high) {
+			continue;		// No value can match.
+		}
+		if (block.base >= low && block.max <= high) {
+			matches += n;		// Every value matches.
+			continue;
+		}
+		// Compare the differences, so the base is never added. The range overlaps the block, so high >= base.
+		std::uint32_t deltaLow = low > block.base ? low - block.base : 0;
+		std::uint32_t deltaHigh = high - block.base;
+		this->UnpackDeltas(b, deltas);
+		if (n == PACKED_BLOCK_SIZE) {
+			matches += PackedCountDeltas(deltas, deltaLow, deltaHigh);
+			continue;
+		}
+		for (std::size_t i = 0; i < n; ++i) {
+			matches += deltas[i] >= deltaLow && deltas[i] <= deltaHigh;
+		}
+	}
+	return matches;
+}
+
+// Appends the indexes of the values in [low, high] to out, in order.
+inline void PackedPages::FilterRange(std::uint32_t low, std::uint32_t high, std::vector<std::uint32_t>& out) const {
+	std::uint32_t deltas[PACKED_BLOCK_SIZE];
+	for (std::size_t b = 0; b < this->blocks.size(); ++b) {
+		const Block& block = this->blocks[b];
+		std::size_t n = this->BlockCount(b);
+		std::uint32_t start = static_cast<std::uint32_t>(b * PACKED_BLOCK_SIZE);
+		if (block.max < low || block.base > high) {
+			continue;
+		}
+		if (block.base >= low && block.max <= high) {
+			for (std::uint32_t i = 0; i < n; ++i) {
+				out.push_back(start + i);
+			}
+			continue;
+		}
+		std::uint32_t deltaLow = low > block.base ? low - block.base : 0;
+		std::uint32_t deltaHigh = high - block.base;
+		this->UnpackDeltas(b, deltas);
+		// Write every index and advance only past matches, which avoids a branch per value.
+		std::size_t size = out.size();
+		out.resize(size + n);
+		for (std::size_t i = 0; i < n; ++i) {
+			out[size] = start + static_cast<std::uint32_t>(i);
+			size += deltas[i] >= deltaLow && deltas[i] <= deltaHigh;
+		}
+		out.resize(size);
+	}
+}
+
+// Returns the sum of every value: per block, its base times its count plus the sum of its differences.
+inline std::uint64_t PackedPages::Sum() const {
+	std::uint64_t total = 0;
+	std::uint32_t deltas[PACKED_BLOCK_SIZE];
+	for (std::size_t b = 0; b < this->blocks.size(); ++b) {
+		const Block& block = this->blocks[b];
+		std::size_t n = this->BlockCount(b);
+		total += static_cast<std::uint64_t>(block.base) * n;
+		if (block.width == 0) {
+			continue;
+		}
+		this->UnpackDeltas(b, deltas);
+		// Padding packs as 0, so every block can be summed whole. 128 differences of up to 24 bits fit in 32 bit sums.
+		if (block.width <= 24) {
+			std::uint32_t sum = 0;
+			for (std::size_t i = 0; i < PACKED_BLOCK_SIZE; ++i) {
+				sum += deltas[i];
+			}
+			total += sum;
+		}
+		else {
+			for (std::size_t i = 0; i < PACKED_BLOCK_SIZE; ++i) {
+				total += deltas[i];
+			}
+		}
+	}
+	return total;
+}
+
+// Returns the smallest value, or 0 if there are none. Reads only the block headers.
+inline std::uint32_t PackedPages::Min() const {
+	std::uint32_t min = this->blocks.empty() ? 0 : this->blocks[0].base;
+	for (const Block& block : this->blocks) {
+		min = block.base < min ? block.base : min;
+	}
+	return min;
+}
+
+// Returns the largest value, or 0 if there are none. Reads only the block headers.
+inline std::uint32_t PackedPages::Max() const {
+	std::uint32_t max = 0;
+	for (const Block& block : this->blocks) {
+		max = block.max > max ? block.max : max;
+	}
+	return max;
+}
+
+// Returns the memory taken by the packed values and the block headers.
+inline std::size_t PackedPages::Bytes() const {
+	return this->words.size() * sizeof(std::uint32_t) + this->blocks.size() * sizeof(Block);
+}
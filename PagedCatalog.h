@@ -0,0 +1,511 @@
+/****************************************************************
+* Author: Leo Carroll
+* Description:
+*	A disk-resident catalog for catalogs much larger than memory.
+*	Persons and Books are records in fixed size slotted pages of
+*	one file, and refer to each other by record id (page and
+*	slot) instead of by pointer. A Person record holds the ids of
+*	its first and last book, and each Book record holds the id of
+*	its author and of the author's next book, so AddBook touches
+*	at most three records however many books the author has.
+*
+*	Pages are read through a BufferPool with a fixed number of
+*	frames. A frame in use is pinned and is never evicted. When
+*	a frame is needed, a CLOCK hand sweeps the frames, giving
+*	every recently used page a second chance, so pages of hot
+*	authors stay in memory.
+* Date Created: 2026-10-18
+* Date Modified: 2026-10-18
+****************************************************************/
+
+#pragma once
+
+#include <cstddef>			// Included for std::size_t.
+#include <cstdint>			// Included for std::uint16_t, std::uint32_t and std::uint64_t.
+#include <cstring>			// Included for std::memcpy and std::memset.
+#include <fstream>			// Included for std::fstream.
+#include <ostream>			// Included for std::ostream.
+#include <string>			// Included for std::string.
+#include <unordered_map>	// Included for std::unordered_map.
+#include <vector>			// Included for std::vector.
+
+#include "Catalog.h"		// Included for Person and Book.
+
+// Size of a page on disk and of a frame in memory.
+constexpr std::size_t PAGED_PAGE_SIZE = 4096;
+
+// Identifies a record as (page << 16) | slot.
+using RecordId = std::uint64_t;
+
+// A record id that refers to nothing.
+constexpr RecordId RECORD_NONE = UINT64_MAX;
+
+// Marks the catalog's first page, so that other files are not opened by mistake.
+constexpr std::uint32_t PAGED_MAGIC = 0x474C5443;		// "CTLG"
+
+// The fields of a Person record.
+struct PagedPerson {
+	RecordId firstBook = RECORD_NONE;		// The first book written, or RECORD_NONE.
+	RecordId lastBook = RECORD_NONE;		// The last book written, or RECORD_NONE.
+	std::uint32_t numBooks = 0;				// Number of books written.
+	std::string name;						// The name of the author.
+};
+
+// The fields of a Book record.
+struct PagedBook {
+	RecordId author = RECORD_NONE;			// The author, or RECORD_NONE.
+	RecordId nextBook = RECORD_NONE;		// The author's next book, or RECORD_NONE.
+	std::uint32_t numberOfPages = 0;		// Number of pages in the book.
+	std::string title;						// Title of the book.
+};
+
+// Caches pages of a file in a fixed number of frames.
+struct BufferPool {
+	// A page held in memory.
+	struct Frame {
+		std::uint32_t page = UINT32_MAX;	// The page in the frame, or UINT32_MAX if it is empty.
+		std::uint32_t pinCount = 0;			// Number of users of the frame. A pinned frame is never evicted.
+		bool dirty = false;					// Whether the frame differs from the page on disk.
+		bool referenced = false;			// Set on every use, and cleared by the CLOCK hand as it passes.
+	};
+
+	std::fstream* file;									// The file that pages are read from and written to.
+	std::vector<Frame> frames;							// The frames.
+	std::vector<char> memory;							// The bytes of every frame, PAGED_PAGE_SIZE each.
+	std::unordered_map<std::uint32_t, std::size_t> pageTable;		// Frame of each page in memory.
+	std::size_t clockHand = 0;							// The frame the CLOCK hand looks at next.
+	std::size_t hits = 0;								// Number of Pin calls served from memory.
+	std::size_t misses = 0;								// Number of Pin calls that read from the file.
+
+	// Custom constructor
+	BufferPool(std::fstream*, std::size_t);
+
+	char* Pin(std::uint32_t, bool);
+	void Unpin(std::uint32_t, bool);
+	bool FlushAll();
+	bool WriteFrame(std::size_t);
+	void Discard();
+};
+
+// Keeps a page pinned for the lifetime of the guard.
+struct PageGuard {
+	BufferPool* pool;		// The pool the page is pinned in.
+	std::uint32_t page;		// The pinned page.
+	char* data;				// The bytes of the page, or nullptr if it could not be pinned.
+	bool dirty = false;		// Set by the user after writing to data.
+
+	PageGuard(BufferPool& pool, std::uint32_t page, bool isNew = false) : pool(&pool), page(page), data(pool.Pin(page, isNew)) {}
+	~PageGuard() {
+		if (this->data) {
+			this->pool->Unpin(this->page, this->dirty);
+		}
+	}
+	PageGuard(const PageGuard&) = delete;
+	PageGuard& operator=(const PageGuard&) = delete;
+};
+
+// A catalog of Person and Book records in a page file.
+// Page 0 holds the magic number and the page count. Every other page is a slotted page: a record count and the end of the
+// record area at the start, records growing up from there, and a slot of (offset, length) per record growing down from the end.
+struct PagedCatalog {
+	std::fstream file;				// The page file.
+	BufferPool pool;				// The cache of pages.
+	std::uint32_t numPages = 0;		// Number of pages in the file, including page 0.
+
+	// Custom constructor
+	// Takes the number of frames in the buffer pool.
+	explicit PagedCatalog(std::size_t);
+	// Destructor, writes every dirty page back.
+	~PagedCatalog();
+
+	bool Open(const std::string&, bool);
+	bool Flush();
+
+	RecordId AddPerson(const std::string&);
+	RecordId AddBook(RecordId, const std::string&, std::uint32_t);
+	bool ReadPerson(RecordId, PagedPerson&);
+	bool ReadBook(RecordId, PagedBook&);
+	bool SetPages(RecordId, std::uint32_t);
+	bool Print(std::ostream&, RecordId);
+	RecordId Import(const Person&);
+
+	RecordId Insert(const std::vector<char>&);
+	char* Locate(PageGuard&, RecordId, std::uint16_t&);
+};
+
+// Offsets of the fields inside records. Ids and counts are fixed size and come first, so they can be updated in place.
+constexpr std::size_t PERSON_FIRST_BOOK = 0;
+constexpr std::size_t PERSON_LAST_BOOK = 8;
+constexpr std::size_t PERSON_NUM_BOOKS = 16;
+constexpr std::size_t PERSON_NAME = 20;
+constexpr std::size_t BOOK_AUTHOR = 0;
+constexpr std::size_t BOOK_NEXT = 8;
+constexpr std::size_t BOOK_PAGES = 16;
+constexpr std::size_t BOOK_TITLE = 20;
+
+// Reads a fixed size field from unaligned bytes.
+template <typename T>
+inline T PagedLoad(const char* at) {
+	T value;
+	std::memcpy(&value, at, sizeof(T));
+	return value;
+}
+
+// Writes a fixed size field to unaligned bytes.
+template <typename T>
+inline void PagedStore(char* at, T value) {
+	std::memcpy(at, &value, sizeof(T));
+}
+
+// BufferPool custom constructor
+// Takes the file and the number of frames.
+inline BufferPool::BufferPool(std::fstream* file, std::size_t numFrames) {
+	this->file = file;
+	this->frames.resize(numFrames);
+	this->memory.resize(numFrames * PAGED_PAGE_SIZE);
+}
+
+// Writes a frame back to its page.
+inline bool BufferPool::WriteFrame(std::size_t frame) {
+	this->file->seekp(static_cast<std::streamoff>(this->frames[frame].page) * static_cast<std::streamoff>(PAGED_PAGE_SIZE));
+	this->file->write(&this->memory[frame * PAGED_PAGE_SIZE], static_cast<std::streamsize>(PAGED_PAGE_SIZE));
+	this->frames[frame].dirty = false;
+	return static_cast<bool>(*this->file);
+}
+
+// Returns the bytes of the page, reading it into a frame if it is not in memory, and pins it.
+// A new page is zeroed instead of read. Returns nullptr if every frame is pinned or the page cannot be read.
+inline char* BufferPool::Pin(std::uint32_t page, bool isNew) {
+	std::unordered_map<std::uint32_t, std::size_t>::iterator it = this->pageTable.find(page);
+	if (it != this->pageTable.end()) {
+		Frame& frame = this->frames[it->second];
+		++frame.pinCount;
+		frame.referenced = true;
+		++this->hits;
+		return &this->memory[it->second * PAGED_PAGE_SIZE];
+	}
+	++this->misses;
+	// Sweep for a victim. Two full turns clear every reference bit, so if nothing is found by then every frame is pinned.
+	std::size_t victim = this->frames.size();
+	for (std::size_t step = 0; step < 2 * this->frames.size(); ++step) {
+		Frame& frame = this->frames[this->clockHand];
+		std::size_t current = this->clockHand;
+		this->clockHand = (this->clockHand + 1) % this->frames.size();
+		if (frame.pinCount != 0) {
+			continue;
+		}
+		if (frame.referenced) {
+			frame.referenced = false;		// Second chance.
+			continue;
+		}
+		victim = current;
+		break;
+	}
+	if (victim == this->frames.size()) {
+		return nullptr;
+	}
+	Frame& frame = this->frames[victim];
+	if (frame.page != UINT32_MAX) {
+		if (frame.dirty && !this->WriteFrame(victim)) {
+			return nullptr;
+		}
+		this->pageTable.erase(frame.page);
+	}
+	char* data = &this->memory[victim * PAGED_PAGE_SIZE];
+	if (isNew) {
+		std::memset(data, 0, PAGED_PAGE_SIZE);
+	}
+	else {
+		this->file->seekg(static_cast<std::streamoff>(page) * static_cast<std::streamoff>(PAGED_PAGE_SIZE));
+		this->file->read(data, static_cast<std::streamsize>(PAGED_PAGE_SIZE));
+		if (!*this->file) {
+			this->file->clear();
+			frame.page = UINT32_MAX;
+			return nullptr;
+		}
+	}
+	frame.page = page;
+	frame.pinCount = 1;
+	frame.dirty = isNew;		// A new page must reach the file even if nothing is written to it.
+	frame.referenced = true;
+	this->pageTable[page] = victim;
+	return data;
+}
+
+// Releases one pin on the page, marking it dirty if the user wrote to it.
+inline void BufferPool::Unpin(std::uint32_t page, bool dirty) {
+	std::unordered_map<std::uint32_t, std::size_t>::iterator it = this->pageTable.find(page);
+	if (it != this->pageTable.end()) {
+		Frame& frame = this->frames[it->second];
+		--frame.pinCount;
+		frame.dirty = frame.dirty || dirty;
+	}
+}
+
+// Writes every dirty frame back to the file.
+inline bool BufferPool::FlushAll() {
+	bool ok = true;
+	for (std::size_t i = 0; i < this->frames.size(); ++i) {
+		if (this->frames[i].page != UINT32_MAX && this->frames[i].dirty) {
+			ok = this->WriteFrame(i) && ok;
+		}
+	}
+	this->file->flush();
+	return ok && static_cast<bool>(*this->file);
+}
+
+// Empties every frame without writing it back, for when the file turns out not to be one that may be written.
+inline void BufferPool::Discard() {
+	for (Frame& frame : this->frames) {
+		frame = Frame();
+	}
+	this->pageTable.clear();
+	this->clockHand = 0;
+}
+
+// PagedCatalog custom constructor
+inline PagedCatalog::PagedCatalog(std::size_t numFrames) : pool(&this->file, numFrames < 4 ? 4 : numFrames) {}
+
+inline PagedCatalog::~PagedCatalog() {
+	if (this->file.is_open()) {
+		this->Flush();
+	}
+}
+
+// Opens the page file, creating a new empty catalog if create is true. Returns false if the file is not a catalog.
+// On failure the file is closed again and nothing is cached, so the destructor never writes to a file that is not a catalog.
+inline bool PagedCatalog::Open(const std::string& path, bool create) {
+	std::ios::openmode mode = std::ios::in | std::ios::out | std::ios::binary;
+	this->file.open(path, create ? mode | std::ios::trunc : mode);
+	if (!this->file.is_open()) {
+		return false;
+	}
+	// Forgets the file, for every path below that cannot use it.
+	auto fail = [this]() {
+		this->pool.Discard();
+		this->file.close();
+		this->numPages = 0;
+		return false;
+	};
+	if (create) {
+		this->numPages = 1;
+		PageGuard meta(this->pool, 0, true);
+		if (meta.data == nullptr) {
+			return fail();
+		}
+		PagedStore<std::uint32_t>(meta.data, PAGED_MAGIC);
+		PagedStore<std::uint32_t>(meta.data + 4, this->numPages);
+		meta.dirty = true;
+		return true;
+	}
+	bool isCatalog = false;		// Whether page 0 could be read and starts with the magic number.
+	{
+		PageGuard meta(this->pool, 0);
+		if (meta.data != nullptr && PagedLoad<std::uint32_t>(meta.data) == PAGED_MAGIC) {
+			this->numPages = PagedLoad<std::uint32_t>(meta.data + 4);
+			isCatalog = this->numPages != 0;
+		}
+	}
+	return isCatalog ? true : fail();
+}
+
+// Records the page count and writes every dirty page back.
+inline bool PagedCatalog::Flush() {
+	{
+		PageGuard meta(this->pool, 0);
+		if (meta.data == nullptr) {
+			return false;
+		}
+		PagedStore<std::uint32_t>(meta.data + 4, this->numPages);
+		meta.dirty = true;
+	}
+	return this->pool.FlushAll();
+}
+
+// Stores the bytes as a new record on the last page, or on a new page if they do not fit. Returns RECORD_NONE on failure.
+inline RecordId PagedCatalog::Insert(const std::vector<char>& bytes) {
+	constexpr std::size_t HEADER = 4;		// Record count and end of the record area, two bytes each.
+	constexpr std::size_t SLOT = 4;			// Offset and length, two bytes each.
+	if (bytes.size() + HEADER + SLOT > PAGED_PAGE_SIZE) {
+		return RECORD_NONE;		// Too large for any page.
+	}
+	// Every page but the last is full as far as this is concerned, so appends never search for space.
+	for (int attempt = 0; attempt < 2; ++attempt) {
+		bool isNew = this->numPages == 1 || attempt == 1;
+		std::uint32_t page = isNew ? this->numPages : this->numPages - 1;
+		PageGuard guard(this->pool, page, isNew);
+		if (guard.data == nullptr) {
+			return RECORD_NONE;
+		}
+		if (isNew) {
+			++this->numPages;
+			PagedStore<std::uint16_t>(guard.data + 2, static_cast<std::uint16_t>(HEADER));
+			guard.dirty = true;
+		}
+		std::uint16_t numSlots = PagedLoad<std::uint16_t>(guard.data);
+		std::uint16_t recordsEnd = PagedLoad<std::uint16_t>(guard.data + 2);
+		std::size_t slotsStart = PAGED_PAGE_SIZE - static_cast<std::size_t>(numSlots + 1) * SLOT;		// Where the new slot would go.
+		if (recordsEnd + bytes.size() > slotsStart || numSlots == UINT16_MAX) {
+			continue;		// Does not fit, try a new page.
+		}
+		std::memcpy(guard.data + recordsEnd, bytes.data(), bytes.size());
+		PagedStore<std::uint16_t>(guard.data + slotsStart, recordsEnd);
+		PagedStore<std::uint16_t>(guard.data + slotsStart + 2, static_cast<std::uint16_t>(bytes.size()));
+		PagedStore<std::uint16_t>(guard.data, static_cast<std::uint16_t>(numSlots + 1));
+		PagedStore<std::uint16_t>(guard.data + 2, static_cast<std::uint16_t>(recordsEnd + bytes.size()));
+		guard.dirty = true;
+		return (static_cast<RecordId>(page) << 16) | numSlots;
+	}
+	return RECORD_NONE;
+}
+
+// Returns the bytes of the record in the pinned page, and writes its length. Returns nullptr if the id is not valid.
+// The slot and the record it points at come from disk, so both are checked to lie inside the page before they are used.
+inline char* PagedCatalog::Locate(PageGuard& guard, RecordId id, std::uint16_t& length) {
+	constexpr std::size_t HEADER = 4;		// Record count and end of the record area, two bytes each.
+	constexpr std::size_t SLOT = 4;			// Offset and length, two bytes each.
+	std::size_t slot = static_cast<std::size_t>(id & 0xFFFF);
+	if (guard.data == nullptr || slot >= PagedLoad<std::uint16_t>(guard.data) || (slot + 1) * SLOT > PAGED_PAGE_SIZE - HEADER) {
+		return nullptr;
+	}
+	std::size_t slotAt = PAGED_PAGE_SIZE - (slot + 1) * SLOT;
+	std::size_t offset = PagedLoad<std::uint16_t>(guard.data + slotAt);
+	length = PagedLoad<std::uint16_t>(guard.data + slotAt + 2);
+	if (offset < HEADER || offset + length > slotAt) {
+		return nullptr;
+	}
+	return guard.data + offset;
+}
+
+// Returns the page that a valid record id is on, or 0, which never holds records.
+inline std::uint32_t PagedPageOf(RecordId id, std::uint32_t numPages) {
+	if (id == RECORD_NONE || (id >> 16) == 0 || (id >> 16) >= numPages) {
+		return 0;
+	}
+	return static_cast<std::uint32_t>(id >> 16);
+}
+
+// Adds a Person with no books.
+inline RecordId PagedCatalog::AddPerson(const std::string& name) {
+	if (name.size() > UINT16_MAX) {
+		return RECORD_NONE;
+	}
+	std::vector<char> bytes(PERSON_NAME + name.size());
+	PagedStore<RecordId>(&bytes[PERSON_FIRST_BOOK], RECORD_NONE);
+	PagedStore<RecordId>(&bytes[PERSON_LAST_BOOK], RECORD_NONE);
+	PagedStore<std::uint32_t>(&bytes[PERSON_NUM_BOOKS], 0);
+	std::memcpy(bytes.data() + PERSON_NAME, name.data(), name.size());
+	return this->Insert(bytes);
+}
+
+// Adds a Book after the last book of its author. author may be RECORD_NONE for a book with no author.
+inline RecordId PagedCatalog::AddBook(RecordId author, const std::string& title, std::uint32_t pages) {
+	std::uint32_t authorPage = PagedPageOf(author, this->numPages);
+	if (author != RECORD_NONE && authorPage == 0) {
+		return RECORD_NONE;
+	}
+	std::vector<char> bytes(BOOK_TITLE + title.size());
+	PagedStore<RecordId>(&bytes[BOOK_AUTHOR], author);
+	PagedStore<RecordId>(&bytes[BOOK_NEXT], RECORD_NONE);
+	PagedStore<std::uint32_t>(&bytes[BOOK_PAGES], pages);
+	std::memcpy(bytes.data() + BOOK_TITLE, title.data(), title.size());
+	RecordId id = this->Insert(bytes);
+	if (id == RECORD_NONE || author == RECORD_NONE) {
+		return id;
+	}
+	// Link the book after the author's last one, then make it the last one.
+	std::uint16_t length = 0;
+	PageGuard authorGuard(this->pool, authorPage);
+	char* person = this->Locate(authorGuard, author, length);
+	if (person == nullptr || length < PERSON_NAME) {
+		return RECORD_NONE;
+	}
+	RecordId lastBook = PagedLoad<RecordId>(person + PERSON_LAST_BOOK);
+	if (lastBook == RECORD_NONE) {
+		PagedStore<RecordId>(person + PERSON_FIRST_BOOK, id);
+	}
+	else {
+		PageGuard lastGuard(this->pool, PagedPageOf(lastBook, this->numPages));
+		char* last = this->Locate(lastGuard, lastBook, length);
+		if (last == nullptr || length < BOOK_TITLE) {
+			return RECORD_NONE;
+		}
+		PagedStore<RecordId>(last + BOOK_NEXT, id);
+		lastGuard.dirty = true;
+	}
+	PagedStore<RecordId>(person + PERSON_LAST_BOOK, id);
+	PagedStore<std::uint32_t>(person + PERSON_NUM_BOOKS, PagedLoad<std::uint32_t>(person + PERSON_NUM_BOOKS) + 1);
+	authorGuard.dirty = true;
+	return id;
+}
+
+// Reads a Person record. Returns false if the id is not valid.
+inline bool PagedCatalog::ReadPerson(RecordId id, PagedPerson& person) {
+	PageGuard guard(this->pool, PagedPageOf(id, this->numPages));
+	std::uint16_t length = 0;
+	char* bytes = this->Locate(guard, id, length);
+	if (bytes == nullptr || length < PERSON_NAME) {
+		return false;
+	}
+	person.firstBook = PagedLoad<RecordId>(bytes + PERSON_FIRST_BOOK);
+	person.lastBook = PagedLoad<RecordId>(bytes + PERSON_LAST_BOOK);
+	person.numBooks = PagedLoad<std::uint32_t>(bytes + PERSON_NUM_BOOKS);
+	person.name.assign(bytes + PERSON_NAME, length - PERSON_NAME);
+	return true;
+}
+
+// Reads a Book record. Returns false if the id is not valid.
+inline bool PagedCatalog::ReadBook(RecordId id, PagedBook& book) {
+	PageGuard guard(this->pool, PagedPageOf(id, this->numPages));
+	std::uint16_t length = 0;
+	char* bytes = this->Locate(guard, id, length);
+	if (bytes == nullptr || length < BOOK_TITLE) {
+		return false;
+	}
+	book.author = PagedLoad<RecordId>(bytes + BOOK_AUTHOR);
+	book.nextBook = PagedLoad<RecordId>(bytes + BOOK_NEXT);
+	book.numberOfPages = PagedLoad<std::uint32_t>(bytes + BOOK_PAGES);
+	book.title.assign(bytes + BOOK_TITLE, length - BOOK_TITLE);
+	return true;
+}
+
+// Changes the page count of a book in place.
+inline bool PagedCatalog::SetPages(RecordId id, std::uint32_t pages) {
+	PageGuard guard(this->pool, PagedPageOf(id, this->numPages));
+	std::uint16_t length = 0;
+	char* bytes = this->Locate(guard, id, length);
+	if (bytes == nullptr || length < BOOK_TITLE) {
+		return false;
+	}
+	PagedStore<std::uint32_t>(bytes + BOOK_PAGES, pages);
+	guard.dirty = true;
+	return true;
+}
+
+// Outputs the person and its books in the same format as the Person output operator.
+inline bool PagedCatalog::Print(std::ostream& os, RecordId id) {
+	PagedPerson person;
+	if (!this->ReadPerson(id, person)) {
+		return false;
+	}
+	os << person.name;
+	PagedBook book;
+	for (RecordId next = person.firstBook; next != RECORD_NONE; next = book.nextBook) {
+		if (!this->ReadBook(next, book)) {
+			return false;
+		}
+		os << "\n - " << book.title << ", " << person.name << ", " << book.numberOfPages << " pages";
+	}
+	return true;
+}
+
+// Copies an in-memory Person and its books into the catalog, and returns the id of the new Person record.
+inline RecordId PagedCatalog::Import(const Person& person) {
+	RecordId id = this->AddPerson(person.name);
+	for (std::size_t idx = 0; id != RECORD_NONE && idx < MAX_BOOKS_WRITTEN && person.booksWritten[idx]; ++idx) {
+		if (this->AddBook(id, person.booksWritten[idx]->title, person.booksWritten[idx]->numberOfPages) == RECORD_NONE) {
+			return RECORD_NONE;
+		}
+	}
+	return id;
+}
@@ -0,0 +1,333 @@
+/****************************************************************
+* Author: Leo Carroll
+* Description:
+*	Parallel sorting of books for sorted exports and queries.
+*	Page counts are sorted with a parallel LSD radix sort, where
+*	each thread counts digits over its own part of the input
+*	and then scatters it. Titles and author names are sorted by
+*	splitting the books into one bucket per thread around
+*	sampled splitters, and sorting each bucket with a multikey
+*	quicksort, which never compares the same prefix twice.
+*
+*	Every order is total: pages, titles and author names break
+*	each other's ties, so the output does not depend on the
+*	number of threads.
+* Date Created: 2026-10-18
+* Date Modified: 2026-10-18
+****************************************************************/
+
+#pragma once
+
+#include <algorithm>		// Included for std::sort, std::min and std::reverse.
+#include <atomic>			// Included for std::atomic.
+#include <cstddef>			// Included for std::size_t.
+#include <cstdint>			// Included for std::uint32_t.
+#include <string>			// Included for std::string.
+#include <thread>			// Included for std::thread.
+#include <utility>			// Included for std::pair and std::swap.
+#include <vector>			// Included for std::vector.
+
+#include "Catalog.h"		// Included for Person and Book.
+
+// The orders that books can be sorted in. The first field is the main key, the others break ties.
+enum class CatalogSortKey {
+	Pages,		// Pages, then title, then author name.
+	Title,		// Title, then author name, then pages.
+	Author		// Author name, then title, then pages.
+};
+
+// Below this many books a single thread is faster than starting more.
+constexpr std::size_t PARALLEL_SORT_MIN_PER_THREAD = std::size_t(1) << 15;
+
+// Returns the name of the book's author, or an empty string if it has none.
+inline const std::string& SortAuthorName(const Book* book) {
+	static const std::string NO_AUTHOR;
+	return book->author ? book->author->name : NO_AUTHOR;
+}
+
+// Returns true if a comes before b in the given order.
+inline bool CatalogLess(const Book* a, const Book* b, CatalogSortKey key) {
+	int cmp = 0;
+	switch (key) {
+	case CatalogSortKey::Pages:
+		if (a->numberOfPages != b->numberOfPages) return a->numberOfPages < b->numberOfPages;
+		cmp = a->title.compare(b->title);
+		return cmp != 0 ? cmp < 0 : SortAuthorName(a) < SortAuthorName(b);
+	case CatalogSortKey::Title:
+		cmp = a->title.compare(b->title);
+		if (cmp != 0) return cmp < 0;
+		cmp = SortAuthorName(a).compare(SortAuthorName(b));
+		return cmp != 0 ? cmp < 0 : a->numberOfPages < b->numberOfPages;
+	case CatalogSortKey::Author:
+		cmp = SortAuthorName(a).compare(SortAuthorName(b));
+		if (cmp != 0) return cmp < 0;
+		cmp = a->title.compare(b->title);
+		return cmp != 0 ? cmp < 0 : a->numberOfPages < b->numberOfPages;
+	}
+	return false;
+}
+
+// Returns the number of threads worth using for count books.
+inline unsigned SortThreadCount(std::size_t count) {
+	unsigned hardware = std::thread::hardware_concurrency();
+	std::size_t useful = count / PARALLEL_SORT_MIN_PER_THREAD;
+	if (useful < 1) {
+		useful = 1;
+	}
+	return static_cast<unsigned>(std::min<std::size_t>(hardware ? hardware : 1, useful));
+}
+
+// Runs work(i) for every i in [0, count) on up to numThreads threads, the calling thread being one of them.
+// Tasks are handed out one at a time, so uneven tasks still keep every thread busy.
+template <typename Work>
+inline void SortRunParallel(std::size_t count, unsigned numThreads, Work work) {
+	std::atomic<std::size_t> nextTask(0);		// The next task not yet taken.
+	auto worker = [&]() {
+		for (std::size_t i = nextTask++; i < count; i = nextTask++) {
+			work(i);
+		}
+	};
+	std::vector<std::thread> threads;
+	for (unsigned t = 1; t < numThreads && t < count; ++t) {
+		threads.emplace_back(worker);
+	}
+	worker();
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+}
+
+// Gathers every book of every person into one vector, in catalog order.
+inline std::vector<Book*> GatherBooks(const Person* const* persons, std::size_t numPersons) {
+	std::vector<Book*> books;
+	for (std::size_t i = 0; i < numPersons; ++i) {
+		for (std::size_t idx = 0; persons[i] && idx < MAX_BOOKS_WRITTEN && persons[i]->booksWritten[idx]; ++idx) {
+			books.push_back(persons[i]->booksWritten[idx]);
+		}
+	}
+	return books;
+}
+
+// Sorts the books by page count with a parallel, stable LSD radix sort on 8 bit digits.
+// Digits that are the same for every book, such as the top bytes of page counts under 65536, are skipped.
+inline void ParallelRadixSortByPages(std::vector<Book*>& books) {
+	constexpr std::size_t RADIX = 256;
+	std::size_t count = books.size();
+	unsigned numThreads = SortThreadCount(count);
+	// Sort the page count next to the pointer, so that the passes never dereference a book.
+	std::vector<std::pair<std::uint32_t, Book*>> items(count);
+	std::vector<std::pair<std::uint32_t, Book*>> scratch(count);
+	std::uint32_t allBits = 0;			// Bits set in any page count.
+	std::uint32_t commonBits = ~0u;		// Bits set in every page count.
+	for (std::size_t i = 0; i < count; ++i) {
+		items[i] = { books[i]->numberOfPages, books[i] };
+		allBits |= books[i]->numberOfPages;
+		commonBits &= books[i]->numberOfPages;
+	}
+	// Each thread owns one contiguous part of the input, which keeps the sort stable.
+	std::vector<std::size_t> histograms(static_cast<std::size_t>(numThreads) * RADIX);
+	auto partBegin = [count, numThreads](unsigned t) { return count * t / numThreads; };
+	for (unsigned shift = 0; shift < 32; shift += 8) {
+		if ((((allBits ^ commonBits) >> shift) & 0xFF) == 0) {
+			continue;		// Every book has the same digit here, so the pass would not move anything.
+		}
+		// Count the digits of each part.
+		SortRunParallel(numThreads, numThreads, [&](std::size_t t) {
+			std::size_t* histogram = &histograms[t * RADIX];
+			std::fill(histogram, histogram + RADIX, 0);
+			for (std::size_t i = partBegin(static_cast<unsigned>(t)); i < partBegin(static_cast<unsigned>(t) + 1); ++i) {
+				++histogram[(items[i].first >> shift) & 0xFF];
+			}
+		});
+		// Turn the counts into where each part starts writing each digit: digit major, then part.
+		std::size_t offset = 0;
+		for (std::size_t digit = 0; digit < RADIX; ++digit) {
+			for (unsigned t = 0; t < numThreads; ++t) {
+				std::size_t n = histograms[t * RADIX + digit];
+				histograms[t * RADIX + digit] = offset;
+				offset += n;
+			}
+		}
+		// Scatter each part into its slots.
+		SortRunParallel(numThreads, numThreads, [&](std::size_t t) {
+			std::size_t* positions = &histograms[t * RADIX];
+			for (std::size_t i = partBegin(static_cast<unsigned>(t)); i < partBegin(static_cast<unsigned>(t) + 1); ++i) {
+				scratch[positions[(items[i].first >> shift) & 0xFF]++] = items[i];
+			}
+		});
+		items.swap(scratch);
+	}
+	for (std::size_t i = 0; i < count; ++i) {
+		books[i] = items[i].second;
+	}
+}
+
+// Returns the character of the key at depth, or -1 past the end, so that shorter keys sort first.
+template <typename KeyOf>
+inline int SortCharAt(const Book* book, std::size_t depth, const KeyOf& keyOf) {
+	const std::string& key = keyOf(book);
+	return depth < key.size() ? static_cast<unsigned char>(key[depth]) : -1;
+}
+
+// Sorts books[0, count) by key with a multikey quicksort, knowing that the keys agree on their first depth characters.
+// Keys that are equal end up next to each other, in no particular order.
+template <typename KeyOf>
+inline void MultikeyQuicksort(Book** books, std::size_t count, std::size_t depth, const KeyOf& keyOf) {
+	while (count > 1) {
+		if (count < 16) {
+			// Insertion sort on the remaining suffixes for small ranges.
+			for (std::size_t i = 1; i < count; ++i) {
+				for (std::size_t j = i; j > 0 && keyOf(books[j]).compare(depth, std::string::npos, keyOf(books[j - 1]), depth, std::string::npos) < 0; --j) {
+					std::swap(books[j], books[j - 1]);
+				}
+			}
+			return;
+		}
+		// Median of three characters as the pivot.
+		int a = SortCharAt(books[0], depth, keyOf);
+		int b = SortCharAt(books[count / 2], depth, keyOf);
+		int c = SortCharAt(books[count - 1], depth, keyOf);
+		int pivot = a < b ? (b < c ? b : (a < c ? c : a)) : (a < c ? a : (b < c ? c : b));
+		// Three way partition on the character at depth: [0, lt) less, [lt, gt) equal, [gt, count) greater.
+		std::size_t lt = 0;
+		std::size_t i = 0;
+		std::size_t gt = count;
+		while (i < gt) {
+			int ch = SortCharAt(books[i], depth, keyOf);
+			if (ch < pivot) {
+				std::swap(books[lt++], books[i++]);
+			}
+			else if (ch > pivot) {
+				std::swap(books[i], books[--gt]);
+			}
+			else {
+				++i;
+			}
+		}
+		MultikeyQuicksort(books, lt, depth, keyOf);
+		MultikeyQuicksort(books + gt, count - gt, depth, keyOf);
+		// The equal part moves on to the next character, unless every key in it has ended.
+		if (pivot < 0) {
+			return;
+		}
+		books += lt;
+		count = gt - lt;
+		++depth;
+	}
+}
+
+// Sorts the books by a string key. The books are split into one bucket per thread around splitters taken from a sorted sample,
+// each bucket is sorted with a multikey quicksort, and runs of equal keys are then ordered by the rest of the given order.
+template <typename KeyOf>
+inline void ParallelStringSort(std::vector<Book*>& books, const KeyOf& keyOf, CatalogSortKey order) {
+	constexpr std::size_t OVERSAMPLE = 32;		// Samples per bucket, which evens out the bucket sizes.
+	std::size_t count = books.size();
+	unsigned numBuckets = SortThreadCount(count);
+	std::vector<std::size_t> bucketStart(1, 0);		// Where each bucket starts in sorted, and the end of the last one.
+	std::vector<Book*> sorted;
+	if (numBuckets == 1) {
+		sorted.swap(books);
+		bucketStart.push_back(count);
+	}
+	else {
+		// Take evenly spaced samples and sort them to pick the splitters.
+		std::vector<Book*> sample;
+		std::size_t numSamples = static_cast<std::size_t>(numBuckets) * OVERSAMPLE;
+		for (std::size_t i = 0; i < numSamples; ++i) {
+			sample.push_back(books[i * count / numSamples]);
+		}
+		std::sort(sample.begin(), sample.end(), [&keyOf](const Book* a, const Book* b) { return keyOf(a) < keyOf(b); });
+		std::vector<const std::string*> splitters;
+		for (unsigned b = 1; b < numBuckets; ++b) {
+			splitters.push_back(&keyOf(sample[b * OVERSAMPLE]));
+		}
+		// Equal keys always land in the same bucket, as the bucket is the number of splitters less than or equal to the key.
+		std::vector<std::uint32_t> bucketOf(count);
+		std::vector<std::size_t> counts(static_cast<std::size_t>(numBuckets) * numBuckets);		// Books per bucket, per part of the input.
+		auto partBegin = [count, numBuckets](std::size_t t) { return count * t / numBuckets; };
+		SortRunParallel(numBuckets, numBuckets, [&](std::size_t t) {
+			for (std::size_t i = partBegin(t); i < partBegin(t + 1); ++i) {
+				const std::string& key = keyOf(books[i]);
+				std::size_t bucket = static_cast<std::size_t>(std::upper_bound(splitters.begin(), splitters.end(), &key,
+					[](const std::string* x, const std::string* y) { return *x < *y; }) - splitters.begin());
+				bucketOf[i] = static_cast<std::uint32_t>(bucket);
+				++counts[t * numBuckets + bucket];
+			}
+		});
+		// Lay the buckets out one after another, with each part writing its own slots in each bucket.
+		std::size_t offset = 0;
+		for (unsigned bucket = 0; bucket < numBuckets; ++bucket) {
+			for (unsigned t = 0; t < numBuckets; ++t) {
+				std::size_t n = counts[t * numBuckets + bucket];
+				counts[t * numBuckets + bucket] = offset;
+				offset += n;
+			}
+			bucketStart.push_back(offset);
+		}
+		sorted.resize(count);
+		SortRunParallel(numBuckets, numBuckets, [&](std::size_t t) {
+			for (std::size_t i = partBegin(t); i < partBegin(t + 1); ++i) {
+				sorted[counts[t * numBuckets + bucketOf[i]]++] = books[i];
+			}
+		});
+	}
+	// Sort each bucket, then order each run of equal keys by the rest of the order.
+	SortRunParallel(bucketStart.size() - 1, numBuckets, [&](std::size_t bucket) {
+		Book** first = sorted.data() + bucketStart[bucket];
+		std::size_t n = bucketStart[bucket + 1] - bucketStart[bucket];
+		MultikeyQuicksort(first, n, 0, keyOf);
+		for (std::size_t i = 0; i < n;) {
+			std::size_t j = i + 1;
+			while (j < n && keyOf(first[j]) == keyOf(first[i])) {
+				++j;
+			}
+			if (j - i > 1) {
+				std::sort(first + i, first + j, [order](const Book* a, const Book* b) { return CatalogLess(a, b, order); });
+			}
+			i = j;
+		}
+	});
+	books.swap(sorted);
+}
+
+// Sorts the books in the given order, using every core that is worth using.
+inline void ParallelSortCatalog(std::vector<Book*>& books, CatalogSortKey key, bool descending = false) {
+	switch (key) {
+	case CatalogSortKey::Pages: {
+		ParallelRadixSortByPages(books);
+		// Books with the same page count are next to each other now, order each run by title and author.
+		std::vector<std::pair<std::size_t, std::size_t>> runs;
+		for (std::size_t i = 0; i < books.size();) {
+			std::size_t j = i + 1;
+			while (j < books.size() && books[j]->numberOfPages == books[i]->numberOfPages) {
+				++j;
+			}
+			if (j - i > 1) {
+				runs.emplace_back(i, j);
+			}
+			i = j;
+		}
+		SortRunParallel(runs.size(), SortThreadCount(books.size()), [&](std::size_t r) {
+			std::sort(books.begin() + static_cast<std::ptrdiff_t>(runs[r].first), books.begin() + static_cast<std::ptrdiff_t>(runs[r].second),
+				[](const Book* a, const Book* b) { return CatalogLess(a, b, CatalogSortKey::Pages); });
+		});
+		break;
+	}
+	case CatalogSortKey::Title:
+		ParallelStringSort(books, [](const Book* book) -> const std::string& { return book->title; }, key);
+		break;
+	case CatalogSortKey::Author:
+		ParallelStringSort(books, [](const Book* book) -> const std::string& { return SortAuthorName(book); }, key);
+		break;
+	}
+	if (descending) {
+		std::reverse(books.begin(), books.end());
+	}
+}
+
+// Returns every book of every person, sorted in the given order. This is the input for a globally sorted export.
+inline std::vector<Book*> SortedCatalog(const Person* const* persons, std::size_t numPersons, CatalogSortKey key) {
+	std::vector<Book*> books = GatherBooks(persons, numPersons);
+	ParallelSortCatalog(books, key);
+	return books;
+}
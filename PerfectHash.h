@@ -0,0 +1,359 @@
+/****************************************************************
+* Author: Leo Carroll
+* Description:
+*	Minimal perfect hashing for catalogs whose author names and
+*	titles are all known when the catalog is frozen. PerfectHash
+*	maps each of n distinct keys to its own number in [0, n),
+*	PTHash style: keys are spread over small buckets, and every
+*	bucket stores a pilot, the first number that, mixed into the
+*	hashes of its keys, sends all of them to free positions. The
+*	largest buckets are placed first, while positions are easy
+*	to find. Pilots are stored as indexes into a dictionary of
+*	the distinct pilot values, in as few bits as that takes.
+*
+*	Keys are first split into partitions of a few thousand, and
+*	the partitions are built in parallel. A lookup mixes one
+*	hash, reads the partition, reads one pilot and computes the
+*	position, so the only access that misses the cache is the
+*	pilot.
+*
+*	A perfect hash maps keys it was not built from to some
+*	position too. FrozenDictionary stores the keys next to their
+*	values to tell the two apart.
+* Date Created: 2026-10-18
+* Date Modified: 2026-10-18
+****************************************************************/
+
+#pragma once
+
+#include <algorithm>		// Included for std::sort, std::max and std::lower_bound.
+#include <cstddef>			// Included for std::size_t.
+#include <cstdint>			// Included for std::uint32_t and std::uint64_t.
+#include <map>				// Included for std::map.
+#include <string>			// Included for std::string.
+#include <string_view>		// Included for std::string_view.
+#include <thread>			// Included for std::thread::hardware_concurrency.
+#include <utility>			// Included for std::pair and std::move.
+#include <vector>			// Included for std::vector.
+
+#include "BloomFilter.h"	// Included for BloomHash and BloomMix.
+#include "Catalog.h"		// Included for Person and Book.
+#include "ParallelSort.h"	// Included for SortRunParallel.
+
+// Average number of keys in a partition.
+constexpr std::size_t PERFECT_HASH_PARTITION_KEYS = 4096;
+// Average number of keys in a bucket. Larger buckets need fewer pilots but take longer to place.
+constexpr double PERFECT_HASH_BUCKET_KEYS = 6.0;
+// Ratio of keys to positions while placing. The positions past the number of keys are then remapped to the free ones below it.
+constexpr double PERFECT_HASH_LOAD = 0.97;
+// Number of pilots tried for one bucket before the partition is retried with another seed.
+constexpr std::uint64_t PERFECT_HASH_MAX_PILOT = 1 << 20;
+
+// Maps n distinct 64 bit key hashes to [0, n).
+struct PerfectHash {
+	// A part of the keys with its own buckets and positions.
+	struct Partition {
+		std::uint64_t seed = 0;				// Mixed into the pilots of the partition.
+		std::uint32_t firstPosition = 0;	// The position of the partition's first key among all keys.
+		std::uint32_t numKeys = 0;			// Number of keys in the partition.
+		std::uint32_t tableSize = 0;		// Number of positions while placing, at least numKeys.
+		std::uint32_t numBuckets = 0;		// Number of buckets.
+		std::uint32_t firstPilot = 0;		// Index of the partition's first pilot in pilots.
+		std::uint32_t firstRemap = 0;		// Index of the partition's first entry in remap.
+	};
+
+	std::vector<Partition> partitions;		// The partitions.
+	std::vector<std::uint64_t> pilotDictionary;		// Every distinct pilot value.
+	std::vector<std::uint64_t> pilots;		// Per bucket, the index of its pilot in pilotDictionary, pilotWidth bits each.
+	unsigned pilotWidth = 0;				// Bits per packed pilot index.
+	std::vector<std::uint16_t> remap;		// Per partition, the free position below numKeys of each position at or past it.
+	std::size_t numKeys = 0;				// Number of keys built from.
+
+	bool Build(const std::vector<std::uint64_t>&);
+	std::size_t Lookup(std::uint64_t) const;
+	std::size_t Bits() const;
+};
+
+// The bucket of a key. Sixty percent of the keys go to the first thirty percent of the buckets, which makes a few large
+// buckets that are placed first and many small ones that fill the gaps.
+inline std::uint32_t PerfectHashBucket(std::uint64_t hash, std::uint32_t numBuckets) {
+	std::uint32_t dense = static_cast<std::uint32_t>(numBuckets * 3ull / 10);
+	std::uint32_t low = static_cast<std::uint32_t>(hash);
+	if (dense > 0 && low < static_cast<std::uint32_t>(0.6 * 4294967296.0)) {
+		return static_cast<std::uint32_t>(((hash >> 32) * dense) >> 32);
+	}
+	return dense + static_cast<std::uint32_t>(((hash >> 32) * (numBuckets - dense)) >> 32);
+}
+
+// The position of a key for a pilot.
+inline std::uint32_t PerfectHashPosition(std::uint64_t hash, std::uint64_t pilot, std::uint64_t seed, std::uint32_t tableSize) {
+	std::uint64_t mixed = BloomMix(hash ^ (pilot * 0x9E3779B97F4A7C15ull + seed));
+	return static_cast<std::uint32_t>(((mixed >> 32) * tableSize) >> 32);
+}
+
+// The partition of a key.
+inline std::size_t PerfectHashPartitionOf(std::uint64_t hash, std::size_t numPartitions) {
+	return static_cast<std::size_t>(((BloomMix(hash) >> 32) * numPartitions) >> 32);
+}
+
+// Places the keys of one partition, filling in its seed, sizes, pilots and remap. Returns false if two keys are equal.
+inline bool PerfectHashPlace(const std::uint64_t* keys, std::uint32_t numKeys, PerfectHash::Partition& partition,
+	std::vector<std::uint64_t>& pilots, std::vector<std::uint16_t>& remap) {
+	partition.numKeys = numKeys;
+	if (numKeys > UINT16_MAX) {
+		return false;		// Remapped positions are 16 bits. Partitions average PERFECT_HASH_PARTITION_KEYS, so this does not happen.
+	}
+	partition.tableSize = std::max(numKeys, static_cast<std::uint32_t>(numKeys / PERFECT_HASH_LOAD));
+	partition.numBuckets = std::max<std::uint32_t>(1, static_cast<std::uint32_t>(numKeys / PERFECT_HASH_BUCKET_KEYS + 1));
+	// Order the keys by bucket, and the buckets from the largest.
+	std::vector<std::pair<std::uint32_t, std::uint64_t>> byBucket(numKeys);
+	for (std::uint32_t i = 0; i < numKeys; ++i) {
+		byBucket[i] = { PerfectHashBucket(keys[i], partition.numBuckets), keys[i] };
+	}
+	std::sort(byBucket.begin(), byBucket.end());
+	std::vector<std::pair<std::uint32_t, std::uint32_t>> buckets;		// Start in byBucket and bucket, of each nonempty bucket.
+	for (std::uint32_t i = 0; i < numKeys; ++i) {
+		if (i > 0 && byBucket[i] == byBucket[i - 1]) {
+			return false;
+		}
+		if (i == 0 || byBucket[i].first != byBucket[i - 1].first) {
+			buckets.push_back({ i, byBucket[i].first });
+		}
+	}
+	std::vector<std::uint32_t> order(buckets.size());
+	for (std::uint32_t b = 0; b < order.size(); ++b) {
+		order[b] = b;
+	}
+	auto sizeOf = [&](std::uint32_t b) { return (b + 1 < buckets.size() ? buckets[b + 1].first : numKeys) - buckets[b].first; };
+	std::stable_sort(order.begin(), order.end(), [&](std::uint32_t a, std::uint32_t b) { return sizeOf(a) > sizeOf(b); });
+
+	std::vector<bool> taken;
+	std::vector<std::uint32_t> positions;
+	for (std::uint64_t seed = partition.seed; ; seed = BloomMix(seed + 1)) {
+		partition.seed = seed;
+		taken.assign(partition.tableSize, false);
+		pilots.assign(partition.numBuckets, 0);
+		bool placed = true;
+		for (std::size_t o = 0; o < order.size() && placed; ++o) {
+			std::uint32_t start = buckets[order[o]].first;
+			std::uint32_t size = sizeOf(order[o]);
+			placed = false;
+			for (std::uint64_t pilot = 0; pilot < PERFECT_HASH_MAX_PILOT && !placed; ++pilot) {
+				positions.clear();
+				bool fits = true;
+				for (std::uint32_t k = start; k < start + size && fits; ++k) {
+					std::uint32_t position = PerfectHashPosition(byBucket[k].second, pilot, seed, partition.tableSize);
+					fits = !taken[position] && std::find(positions.begin(), positions.end(), position) == positions.end();
+					positions.push_back(position);
+				}
+				if (fits) {
+					for (std::uint32_t position : positions) {
+						taken[position] = true;
+					}
+					pilots[buckets[order[o]].second] = pilot;
+					placed = true;
+				}
+			}
+		}
+		if (placed) {
+			break;
+		}
+	}
+	// Send the keys placed past numKeys to the free positions below it, in order.
+	remap.assign(partition.tableSize - numKeys, 0);
+	std::uint32_t free = 0;
+	for (std::uint32_t position = numKeys; position < partition.tableSize; ++position) {
+		if (taken[position]) {
+			while (taken[free]) {
+				++free;
+			}
+			remap[position - numKeys] = static_cast<std::uint16_t>(free++);
+		}
+	}
+	return true;
+}
+
+// Builds the function from distinct key hashes, in parallel. Returns false if two hashes are equal.
+// Each partition is a few thousand keys, whose remapped positions fit in 16 bits.
+inline bool PerfectHash::Build(const std::vector<std::uint64_t>& hashes) {
+	this->numKeys = hashes.size();
+	std::size_t numPartitions = std::max<std::size_t>(1, hashes.size() / PERFECT_HASH_PARTITION_KEYS);
+	// Group the keys by partition with a counting sort.
+	std::vector<std::size_t> starts(numPartitions + 1, 0);
+	for (std::uint64_t hash : hashes) {
+		++starts[PerfectHashPartitionOf(hash, numPartitions) + 1];
+	}
+	for (std::size_t p = 0; p < numPartitions; ++p) {
+		starts[p + 1] += starts[p];
+	}
+	std::vector<std::uint64_t> grouped(hashes.size());
+	std::vector<std::size_t> next(starts.begin(), starts.end() - 1);
+	for (std::uint64_t hash : hashes) {
+		grouped[next[PerfectHashPartitionOf(hash, numPartitions)]++] = hash;
+	}
+
+	// Place the partitions in parallel, each into its own vectors.
+	this->partitions.assign(numPartitions, Partition());
+	std::vector<std::vector<std::uint64_t>> partPilots(numPartitions);
+	std::vector<std::vector<std::uint16_t>> partRemaps(numPartitions);
+	std::vector<char> ok(numPartitions, 1);
+	unsigned hardware = std::thread::hardware_concurrency();
+	unsigned numThreads = static_cast<unsigned>(std::min<std::size_t>(hardware ? hardware : 1, numPartitions));
+	SortRunParallel(numPartitions, numThreads, [&](std::size_t p) {
+		this->partitions[p].seed = BloomMix(p);
+		this->partitions[p].firstPosition = static_cast<std::uint32_t>(starts[p]);
+		ok[p] = PerfectHashPlace(grouped.data() + starts[p], static_cast<std::uint32_t>(starts[p + 1] - starts[p]), this->partitions[p], partPilots[p], partRemaps[p]);
+	});
+	for (char partOk : ok) {
+		if (!partOk) {
+			return false;
+		}
+	}
+
+	// Pack the pilots as indexes into the dictionary of distinct values, the most common first.
+	std::map<std::uint64_t, std::size_t> frequency;
+	for (const std::vector<std::uint64_t>& part : partPilots) {
+		for (std::uint64_t pilot : part) {
+			++frequency[pilot];
+		}
+	}
+	std::vector<std::pair<std::size_t, std::uint64_t>> byFrequency;
+	for (const std::pair<const std::uint64_t, std::size_t>& entry : frequency) {
+		byFrequency.push_back({ entry.second, entry.first });
+	}
+	std::sort(byFrequency.begin(), byFrequency.end(), [](const std::pair<std::size_t, std::uint64_t>& a, const std::pair<std::size_t, std::uint64_t>& b) {
+		return a.first != b.first ? a.first > b.first : a.second < b.second;
+	});
+	this->pilotDictionary.clear();
+	std::map<std::uint64_t, std::uint64_t> indexOf;
+	for (const std::pair<std::size_t, std::uint64_t>& entry : byFrequency) {
+		indexOf[entry.second] = this->pilotDictionary.size();
+		this->pilotDictionary.push_back(entry.second);
+	}
+	this->pilotWidth = 1;
+	while ((1ull << this->pilotWidth) < this->pilotDictionary.size()) {
+		++this->pilotWidth;
+	}
+	std::size_t totalBuckets = 0;
+	std::size_t totalRemap = 0;
+	for (std::size_t p = 0; p < numPartitions; ++p) {
+		this->partitions[p].firstPilot = static_cast<std::uint32_t>(totalBuckets);
+		this->partitions[p].firstRemap = static_cast<std::uint32_t>(totalRemap);
+		totalBuckets += partPilots[p].size();
+		totalRemap += partRemaps[p].size();
+	}
+	this->pilots.assign((totalBuckets * this->pilotWidth + 63) / 64 + 1, 0);		// One word of padding for reads across the end.
+	this->remap.clear();
+	this->remap.reserve(totalRemap);
+	for (std::size_t p = 0; p < numPartitions; ++p) {
+		for (std::size_t b = 0; b < partPilots[p].size(); ++b) {
+			std::uint64_t bit = (this->partitions[p].firstPilot + b) * static_cast<std::uint64_t>(this->pilotWidth);
+			std::uint64_t value = indexOf[partPilots[p][b]];
+			this->pilots[bit / 64] |= value << (bit % 64);
+			if (bit % 64 + this->pilotWidth > 64) {
+				this->pilots[bit / 64 + 1] |= value >> (64 - bit % 64);
+			}
+		}
+		this->remap.insert(this->remap.end(), partRemaps[p].begin(), partRemaps[p].end());
+	}
+	return true;
+}
+
+// Returns the number in [0, n) of a key hash built from. Other hashes get some number in [0, n), or 0 if there are no keys.
+inline std::size_t PerfectHash::Lookup(std::uint64_t hash) const {
+	if (this->numKeys == 0) {
+		return 0;
+	}
+	const Partition& partition = this->partitions[PerfectHashPartitionOf(hash, this->partitions.size())];
+	std::uint64_t bit = (partition.firstPilot + PerfectHashBucket(hash, partition.numBuckets)) * static_cast<std::uint64_t>(this->pilotWidth);
+	std::uint64_t value = this->pilots[bit / 64] >> (bit % 64);
+	if (bit % 64 + this->pilotWidth > 64) {
+		value |= this->pilots[bit / 64 + 1] << (64 - bit % 64);
+	}
+	value &= (1ull << this->pilotWidth) - 1;
+	std::size_t position = PerfectHashPosition(hash, this->pilotDictionary[value], partition.seed, partition.tableSize);
+	if (position >= partition.numKeys) {
+		position = this->remap[partition.firstRemap + position - partition.numKeys];
+	}
+	return partition.firstPosition + position;
+}
+
+// Returns the size of the function in bits.
+inline std::size_t PerfectHash::Bits() const {
+	return 8 * (this->partitions.size() * sizeof(Partition) + this->pilotDictionary.size() * sizeof(std::uint64_t)
+		+ this->pilots.size() * sizeof(std::uint64_t) + this->remap.size() * sizeof(std::uint16_t));
+}
+
+// A read-only map from strings to values, built once from every entry.
+template <typename Value>
+struct FrozenDictionary {
+	PerfectHash hash;					// Gives every key its position.
+	std::vector<std::string> keys;		// The key at each position.
+	std::vector<Value> values;			// The value at each position.
+
+	bool Build(std::vector<std::pair<std::string, Value>>);
+	const Value* Find(std::string_view) const;
+	std::size_t Size() const;
+};
+
+// Builds the dictionary. Returns false if two keys are equal or their hashes collide.
+template <typename Value>
+inline bool FrozenDictionary<Value>::Build(std::vector<std::pair<std::string, Value>> entries) {
+	std::vector<std::uint64_t> hashes(entries.size());
+	for (std::size_t i = 0; i < entries.size(); ++i) {
+		hashes[i] = BloomHash(entries[i].first);
+	}
+	if (!this->hash.Build(hashes)) {
+		this->keys.clear();
+		this->values.clear();
+		return false;
+	}
+	this->keys.assign(entries.size(), std::string());
+	this->values.assign(entries.size(), Value());
+	for (std::size_t i = 0; i < entries.size(); ++i) {
+		std::size_t position = this->hash.Lookup(hashes[i]);
+		this->keys[position] = std::move(entries[i].first);
+		this->values[position] = std::move(entries[i].second);
+	}
+	return true;
+}
+
+// Returns the value of the key, or nullptr if it was not built from.
+template <typename Value>
+inline const Value* FrozenDictionary<Value>::Find(std::string_view key) const {
+	if (this->keys.empty()) {
+		return nullptr;
+	}
+	std::size_t position = this->hash.Lookup(BloomHash(key));
+	return this->keys[position] == key ? &this->values[position] : nullptr;
+}
+
+template <typename Value>
+inline std::size_t FrozenDictionary<Value>::Size() const {
+	return this->keys.size();
+}
+
+// Builds a dictionary from author name to Person. Of persons with the same name, the first is kept.
+inline bool BuildAuthorDictionary(const Person* const* persons, std::size_t count, FrozenDictionary<const Person*>& dictionary) {
+	std::vector<std::pair<std::string, const Person*>> entries;
+	entries.reserve(count);
+	for (std::size_t i = 0; i < count; ++i) {
+		entries.push_back({ persons[i]->name, persons[i] });
+	}
+	std::stable_sort(entries.begin(), entries.end(), [](const std::pair<std::string, const Person*>& a, const std::pair<std::string, const Person*>& b) { return a.first < b.first; });
+	entries.erase(std::unique(entries.begin(), entries.end(), [](const std::pair<std::string, const Person*>& a, const std::pair<std::string, const Person*>& b) { return a.first == b.first; }), entries.end());
+	return dictionary.Build(std::move(entries));
+}
+
+// Builds a dictionary from title to Book over the books of the persons. Of books with the same title, the first is kept.
+inline bool BuildTitleDictionary(const Person* const* persons, std::size_t count, FrozenDictionary<const Book*>& dictionary) {
+	std::vector<std::pair<std::string, const Book*>> entries;
+	for (std::size_t i = 0; i < count; ++i) {
+		for (std::size_t idx = 0; idx < MAX_BOOKS_WRITTEN && persons[i]->booksWritten[idx]; ++idx) {
+			entries.push_back({ persons[i]->booksWritten[idx]->title, persons[i]->booksWritten[idx] });
+		}
+	}
+	std::stable_sort(entries.begin(), entries.end(), [](const std::pair<std::string, const Book*>& a, const std::pair<std::string, const Book*>& b) { return a.first < b.first; });
+	entries.erase(std::unique(entries.begin(), entries.end(), [](const std::pair<std::string, const Book*>& a, const std::pair<std::string, const Book*>& b) { return a.first == b.first; }), entries.end());
+	return dictionary.Build(std::move(entries));
+}
@@ -0,0 +1,187 @@
+/****************************************************************
+* Author: Leo Carroll
+* Description:
+*	Book filters built from expression templates. A filter such
+*	as 'Pages() > 400 && Author() == &king' is a type, not a tree
+*	of objects, so FilterSelection compiles it into one loop over
+*	a batch of books with every comparison inlined and no
+*	indirect call per book.
+*
+*	RuntimePredicate is for filters that are only known at run
+*	time. It is a list of compiled filters that are and'ed
+*	together, and it makes one indirect call per filter per
+*	batch instead of one per book.
+* Date Created: 2026-10-18
+* Date Modified: 2026-10-18
+****************************************************************/
+
+#pragma once
+
+#include <cstddef>			// Included for std::size_t.
+#include <cstdint>			// Included for std::uint16_t and std::uint32_t.
+#include <memory>			// Included for std::shared_ptr.
+#include <string>			// Included for std::string.
+#include <type_traits>		// Included for std::enable_if_t and std::is_base_of.
+#include <utility>			// Included for std::move.
+#include <vector>			// Included for std::vector.
+
+#include "Catalog.h"		// Included for Person, Book and BOOK_BATCH_SIZE.
+
+// Every predicate derives from this, so that the operators below only apply to predicates.
+struct BookPredicate {};
+
+template <typename T>
+constexpr bool IS_BOOK_PREDICATE = std::is_base_of<BookPredicate, T>::value;
+
+// The fields that a predicate can compare.
+struct PagesField {
+	std::uint32_t operator()(const Book& book) const { return book.numberOfPages; }
+};
+struct AuthorField {
+	const Person* operator()(const Book& book) const { return book.author; }
+};
+struct TitleField {
+	const std::string& operator()(const Book& book) const { return book.title; }
+};
+
+// The comparison operators, as types so that they are inlined into the loop.
+struct EqualOp { template <typename A, typename B> bool operator()(const A& a, const B& b) const { return a == b; } };
+struct NotEqualOp { template <typename A, typename B> bool operator()(const A& a, const B& b) const { return !(a == b); } };
+struct LessOp { template <typename A, typename B> bool operator()(const A& a, const B& b) const { return a < b; } };
+struct LessEqualOp { template <typename A, typename B> bool operator()(const A& a, const B& b) const { return !(b < a); } };
+struct GreaterOp { template <typename A, typename B> bool operator()(const A& a, const B& b) const { return b < a; } };
+struct GreaterEqualOp { template <typename A, typename B> bool operator()(const A& a, const B& b) const { return !(a < b); } };
+
+// Compares a field of the book against a value.
+template <typename Field, typename Op, typename Value>
+struct ComparePredicate : BookPredicate {
+	Value value;		// The value compared against.
+
+	explicit ComparePredicate(Value value) : value(std::move(value)) {}
+	bool operator()(const Book& book) const { return Op()(Field()(book), this->value); }
+};
+
+template <typename Left, typename Right>
+struct AndPredicate : BookPredicate {
+	Left left;
+	Right right;
+
+	AndPredicate(Left left, Right right) : left(std::move(left)), right(std::move(right)) {}
+	bool operator()(const Book& book) const { return this->left(book) && this->right(book); }
+};
+
+template <typename Left, typename Right>
+struct OrPredicate : BookPredicate {
+	Left left;
+	Right right;
+
+	OrPredicate(Left left, Right right) : left(std::move(left)), right(std::move(right)) {}
+	bool operator()(const Book& book) const { return this->left(book) || this->right(book); }
+};
+
+template <typename Operand>
+struct NotPredicate : BookPredicate {
+	Operand operand;
+
+	explicit NotPredicate(Operand operand) : operand(std::move(operand)) {}
+	bool operator()(const Book& book) const { return !this->operand(book); }
+};
+
+// A field, waiting for a comparison operator to turn it into a predicate.
+template <typename Field, typename Value>
+struct FieldRef {
+	ComparePredicate<Field, EqualOp, Value> operator==(Value value) const { return ComparePredicate<Field, EqualOp, Value>(std::move(value)); }
+	ComparePredicate<Field, NotEqualOp, Value> operator!=(Value value) const { return ComparePredicate<Field, NotEqualOp, Value>(std::move(value)); }
+	ComparePredicate<Field, LessOp, Value> operator<(Value value) const { return ComparePredicate<Field, LessOp, Value>(std::move(value)); }
+	ComparePredicate<Field, LessEqualOp, Value> operator<=(Value value) const { return ComparePredicate<Field, LessEqualOp, Value>(std::move(value)); }
+	ComparePredicate<Field, GreaterOp, Value> operator>(Value value) const { return ComparePredicate<Field, GreaterOp, Value>(std::move(value)); }
+	ComparePredicate<Field, GreaterEqualOp, Value> operator>=(Value value) const { return ComparePredicate<Field, GreaterEqualOp, Value>(std::move(value)); }
+};
+
+// The fields to start a predicate from, e.g. 'Pages() > 400'.
+inline FieldRef<PagesField, std::uint32_t> Pages() { return {}; }
+inline FieldRef<AuthorField, const Person*> Author() { return {}; }
+inline FieldRef<TitleField, std::string> Title() { return {}; }
+
+template <typename Left, typename Right, typename = std::enable_if_t<IS_BOOK_PREDICATE<Left> && IS_BOOK_PREDICATE<Right>>>
+inline AndPredicate<Left, Right> operator&&(Left left, Right right) {
+	return AndPredicate<Left, Right>(std::move(left), std::move(right));
+}
+
+template <typename Left, typename Right, typename = std::enable_if_t<IS_BOOK_PREDICATE<Left> && IS_BOOK_PREDICATE<Right>>>
+inline OrPredicate<Left, Right> operator||(Left left, Right right) {
+	return OrPredicate<Left, Right>(std::move(left), std::move(right));
+}
+
+template <typename Operand, typename = std::enable_if_t<IS_BOOK_PREDICATE<Operand>>>
+inline NotPredicate<Operand> operator!(Operand operand) {
+	return NotPredicate<Operand>(std::move(operand));
+}
+
+// Writes the entries of sel (indexes into batch) whose book passes the predicate to out, and returns how many there are.
+// Every index is written and only the ones that pass are kept, so there is no branch on the result. out may be sel.
+template <typename Pred>
+inline std::size_t FilterSelection(const Pred& pred, Book* const* batch, const std::uint16_t* sel, std::size_t count, std::uint16_t* out) {
+	std::size_t n = 0;
+	for (std::size_t i = 0; i < count; ++i) {
+		std::uint16_t idx = sel[i];		// Read before writing, in case out is sel.
+		out[n] = idx;
+		n += pred(*batch[idx]) ? 1 : 0;
+	}
+	return n;
+}
+
+// Same as FilterSelection, for a batch where every book is selected.
+template <typename Pred>
+inline std::size_t FilterBooks(const Pred& pred, Book* const* batch, std::size_t count, std::uint16_t* out) {
+	std::size_t n = 0;
+	for (std::size_t i = 0; i < count; ++i) {
+		out[n] = static_cast<std::uint16_t>(i);
+		n += pred(*batch[i]) ? 1 : 0;
+	}
+	return n;
+}
+
+// A conjunction of compiled predicates that is put together at run time.
+struct RuntimePredicate {
+	// Filters a selection with one compiled predicate. state points at the predicate.
+	using Kernel = std::size_t (*)(const void*, Book* const*, const std::uint16_t*, std::size_t, std::uint16_t*);
+
+	struct Stage {
+		Kernel kernel;							// FilterSelection instantiated for the predicate.
+		std::shared_ptr<const void> state;		// The predicate.
+	};
+
+	std::vector<Stage> stages;		// The predicates, checked in order. A book must pass all of them.
+
+	template <typename Pred>
+	RuntimePredicate& And(Pred);
+	std::size_t Filter(Book* const*, std::size_t, std::uint16_t*) const;
+};
+
+// The kernel that RuntimePredicate calls for a predicate of type Pred.
+template <typename Pred>
+inline std::size_t RuntimePredicateKernel(const void* state, Book* const* batch, const std::uint16_t* sel, std::size_t count, std::uint16_t* out) {
+	return FilterSelection(*static_cast<const Pred*>(state), batch, sel, count, out);
+}
+
+// Adds a predicate that books must also pass. Cheap and selective predicates should be added first.
+template <typename Pred>
+inline RuntimePredicate& RuntimePredicate::And(Pred pred) {
+	static_assert(IS_BOOK_PREDICATE<Pred>, "RuntimePredicate::And takes a predicate.");
+	this->stages.push_back(Stage{ &RuntimePredicateKernel<Pred>, std::make_shared<const Pred>(std::move(pred)) });
+	return *this;
+}
+
+// Writes the indexes of the books in the batch that pass every stage to out, and returns how many there are.
+// count must not be more than BOOK_BATCH_SIZE.
+inline std::size_t RuntimePredicate::Filter(Book* const* batch, std::size_t count, std::uint16_t* out) const {
+	for (std::size_t i = 0; i < count; ++i) {
+		out[i] = static_cast<std::uint16_t>(i);		// Start with every book selected.
+	}
+	// Each stage narrows the selection in place, and stops early once nothing is left.
+	for (std::size_t s = 0; s < this->stages.size() && count != 0; ++s) {
+		count = this->stages[s].kernel(this->stages[s].state.get(), batch, out, count, out);
+	}
+	return count;
+}
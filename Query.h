@@ -0,0 +1,727 @@
+/****************************************************************
+* Author: Leo Carroll
+* Description:
+*	A small query language over the books of a catalog, e.g.
+*
+*	books where pages > 500 and author = "Stephen King"
+*		order by pages desc limit 10
+*
+*	ParseQuery turns the text into a tree of QueryExpr nodes.
+*	PlanQuery picks the cheapest way to find candidate books,
+*	either a full scan or one of the indexes on QueryCatalog.
+*	RunQuery then filters the candidates BOOK_BATCH_SIZE at a
+*	time with selection vectors, and sorts and limits the rest.
+*
+*	Fields are pages, title and author. Comparisons are
+*	= != < <= > >=, combined with and, or, not and parentheses.
+* Date Created: 2026-10-18
+* Date Modified: 2026-10-18
+****************************************************************/
+
+#pragma once
+
+#include <algorithm>		// Included for std::sort, std::partial_sort and std::lower_bound.
+#include <cstddef>			// Included for std::size_t.
+#include <cstdint>			// Included for std::uint32_t.
+#include <memory>			// Included for std::unique_ptr.
+#include <string>			// Included for std::string.
+#include <string_view>		// Included for std::string_view.
+#include <unordered_map>	// Included for std::unordered_map.
+#include <utility>			// Included for std::pair.
+#include <vector>			// Included for std::vector.
+
+#include "Catalog.h"		// Included for Person, Book and BOOK_BATCH_SIZE.
+#include "Predicate.h"		// Included for Pages and FilterSelection.
+#include "ParallelSort.h"	// Included for ParallelSortCatalog.
+
+// Most nots and parentheses that may be nested inside each other in a where clause.
+constexpr std::size_t QUERY_MAX_DEPTH = 32;
+// Most comparisons in a where clause. Chains of and and or build a tree as deep as they are long,
+// so together with QUERY_MAX_DEPTH this bounds the recursion of the parser and of QueryFilterBatch,
+// and the scratch selection vectors that QueryFilterBatch takes from the heap.
+constexpr std::size_t QUERY_MAX_TERMS = 128;
+
+// The fields of a book that a query can refer to.
+enum class QueryField { Pages, Title, Author };
+
+// The comparison operators.
+enum class QueryOp { Equal, NotEqual, Less, LessEqual, Greater, GreaterEqual };
+
+// A node of a parsed where clause.
+struct QueryExpr {
+	enum class Kind { And, Or, Not, Compare };
+
+	Kind kind;							// What the node does.
+	QueryField field;					// For Compare, the field being compared.
+	QueryOp op;							// For Compare, the operator.
+	std::uint32_t number;				// For Compare on pages, the number compared against.
+	std::string text;					// For Compare on title or author, the string compared against.
+	std::unique_ptr<QueryExpr> left;	// For And, Or and Not, the first operand.
+	std::unique_ptr<QueryExpr> right;	// For And and Or, the second operand.
+};
+
+// A parsed query.
+struct Query {
+	std::unique_ptr<QueryExpr> where;		// The where clause, or nullptr to select every book.
+	bool hasOrder = false;					// Whether there is an order by clause.
+	QueryField orderField = QueryField::Pages;		// The field to order by.
+	bool descending = false;				// Whether the order is descending.
+	std::size_t limit = SIZE_MAX;			// The most books to return.
+};
+
+// The books that queries run over, and the indexes that the planner can pick from.
+// This is a snapshot: it does not listen to the Persons it was filled from. After SetPages, SetTitle on an author,
+// RemoveBook or anything else that changes a book, call InvalidateIndexes (or BuildIndexes again) so that the planner
+// stops trusting byPages and byAuthor, and rebuild books if a book was removed.
+struct QueryCatalog {
+	std::vector<Book*> books;											// Every book, in the order it was added. Full scans walk this.
+	std::vector<std::pair<std::uint32_t, Book*>> byPages;				// Every book sorted by page count, once BuildIndexes has run.
+	std::unordered_map<std::string, std::vector<Book*>> byAuthor;		// The books of each author name, once BuildIndexes has run.
+	bool indexed = false;												// Whether the indexes are up to date with books.
+
+	void AddPerson(const Person&);
+	void BuildIndexes();
+	void InvalidateIndexes();
+};
+
+// How a query finds its candidate books.
+struct QueryPlan {
+	enum class Access { Scan, PagesRange, AuthorLookup };
+
+	Access access = Access::Scan;			// The access path.
+	std::uint32_t minPages = 0;				// For PagesRange, the smallest page count in range.
+	std::uint32_t maxPages = UINT32_MAX;	// For PagesRange, the largest page count in range.
+	std::string author;						// For AuthorLookup, the author name.
+	std::size_t estimatedRows = 0;			// Number of candidate books the access path produces.
+	double cost = 0.0;						// Estimated cost, in units of one sequential book visit.
+
+	std::string Describe() const;
+};
+
+// Splits query text into tokens.
+struct QueryLexer {
+	enum class Token { End, Word, Number, String, Op, LeftParen, RightParen, Error };
+
+	std::string_view text;		// The query text.
+	std::size_t pos = 0;		// Position of the next unread character.
+	Token token = Token::End;	// The current token.
+	std::string value;			// The text of the current token, with quotes and escapes removed from strings.
+	std::uint64_t number = 0;	// The value of the current token if it is a number.
+
+	void Advance();
+	bool IsWord(const char*) const;
+};
+
+// Returns the lowercase form of an ASCII character.
+inline char QueryLower(char c) {
+	return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+// Returns true if the current token is the keyword, ignoring case.
+inline bool QueryLexer::IsWord(const char* keyword) const {
+	if (this->token != Token::Word) {
+		return false;
+	}
+	std::size_t i = 0;
+	for (; keyword[i] != '\0'; ++i) {
+		if (i >= this->value.size() || QueryLower(this->value[i]) != keyword[i]) {
+			return false;
+		}
+	}
+	return i == this->value.size();
+}
+
+// Reads the next token.
+inline void QueryLexer::Advance() {
+	// Skip whitespace.
+	while (this->pos < this->text.size() && (this->text[this->pos] == ' ' || this->text[this->pos] == '\t' || this->text[this->pos] == '\n' || this->text[this->pos] == '\r')) {
+		++this->pos;
+	}
+	this->value.clear();
+	if (this->pos >= this->text.size()) {
+		this->token = Token::End;
+		return;
+	}
+	char c = this->text[this->pos];
+	if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_') {
+		// A word runs until the first character that cannot be in one.
+		while (this->pos < this->text.size()) {
+			char w = this->text[this->pos];
+			if (!((w >= 'a' && w <= 'z') || (w >= 'A' && w <= 'Z') || (w >= '0' && w <= '9') || w == '_')) {
+				break;
+			}
+			this->value.push_back(w);
+			++this->pos;
+		}
+		this->token = Token::Word;
+	}
+	else if (c >= '0' && c <= '9') {
+		this->number = 0;
+		while (this->pos < this->text.size() && this->text[this->pos] >= '0' && this->text[this->pos] <= '9') {
+			this->number = this->number * 10 + static_cast<std::uint64_t>(this->text[this->pos] - '0');
+			if (this->number > UINT32_MAX) {
+				this->token = Token::Error;		// Page counts are 32 bit, so larger numbers are an error.
+				return;
+			}
+			++this->pos;
+		}
+		this->token = Token::Number;
+	}
+	else if (c == '"') {
+		// A string runs to the next unescaped quote. Backslash escapes the next character.
+		++this->pos;
+		while (this->pos < this->text.size() && this->text[this->pos] != '"') {
+			if (this->text[this->pos] == '\\' && this->pos + 1 < this->text.size()) {
+				++this->pos;
+			}
+			this->value.push_back(this->text[this->pos++]);
+		}
+		if (this->pos >= this->text.size()) {
+			this->token = Token::Error;		// The string was never closed.
+			return;
+		}
+		++this->pos;		// Skip the closing quote.
+		this->token = Token::String;
+	}
+	else if (c == '(' || c == ')') {
+		++this->pos;
+		this->token = c == '(' ? Token::LeftParen : Token::RightParen;
+	}
+	else if (c == '=' || c == '!' || c == '<' || c == '>') {
+		this->value.push_back(c);
+		++this->pos;
+		if (this->pos < this->text.size() && this->text[this->pos] == '=') {
+			this->value.push_back('=');
+			++this->pos;
+		}
+		this->token = this->value == "!" ? Token::Error : Token::Op;
+	}
+	else {
+		this->token = Token::Error;
+	}
+}
+
+// Recursive descent parser over a QueryLexer. Every function returns nullptr on error and leaves a message in error.
+struct QueryParser {
+	QueryLexer lexer;			// The tokens of the query.
+	std::string error;			// Message for the first error found.
+	std::size_t depth = 0;		// Number of nots and parentheses around the current position.
+	std::size_t numTerms = 0;	// Number of comparisons parsed so far.
+
+	std::unique_ptr<QueryExpr> ParseOr();
+	std::unique_ptr<QueryExpr> ParseAnd();
+	std::unique_ptr<QueryExpr> ParseNot();
+	std::unique_ptr<QueryExpr> ParseCompare();
+	bool ParseField(QueryField&);
+	std::unique_ptr<QueryExpr> Fail(const std::string&);
+};
+
+inline std::unique_ptr<QueryExpr> QueryParser::Fail(const std::string& message) {
+	if (this->error.empty()) {
+		this->error = message + " at position " + std::to_string(this->lexer.pos);
+	}
+	return nullptr;
+}
+
+// Joins two operands into an And or Or node.
+inline std::unique_ptr<QueryExpr> QueryJoin(QueryExpr::Kind kind, std::unique_ptr<QueryExpr> left, std::unique_ptr<QueryExpr> right) {
+	std::unique_ptr<QueryExpr> node(new QueryExpr());
+	node->kind = kind;
+	node->left = std::move(left);
+	node->right = std::move(right);
+	return node;
+}
+
+// or-expr := and-expr ('or' and-expr)*
+inline std::unique_ptr<QueryExpr> QueryParser::ParseOr() {
+	std::unique_ptr<QueryExpr> left = this->ParseAnd();
+	while (left && this->lexer.IsWord("or")) {
+		this->lexer.Advance();
+		std::unique_ptr<QueryExpr> right = this->ParseAnd();
+		if (!right) {
+			return nullptr;
+		}
+		left = QueryJoin(QueryExpr::Kind::Or, std::move(left), std::move(right));
+	}
+	return left;
+}
+
+// and-expr := not-expr ('and' not-expr)*
+inline std::unique_ptr<QueryExpr> QueryParser::ParseAnd() {
+	std::unique_ptr<QueryExpr> left = this->ParseNot();
+	while (left && this->lexer.IsWord("and")) {
+		this->lexer.Advance();
+		std::unique_ptr<QueryExpr> right = this->ParseNot();
+		if (!right) {
+			return nullptr;
+		}
+		left = QueryJoin(QueryExpr::Kind::And, std::move(left), std::move(right));
+	}
+	return left;
+}
+
+// not-expr := 'not' not-expr | '(' or-expr ')' | comparison
+inline std::unique_ptr<QueryExpr> QueryParser::ParseNot() {
+	bool nests = this->lexer.IsWord("not") || this->lexer.token == QueryLexer::Token::LeftParen;
+	if (nests && this->depth >= QUERY_MAX_DEPTH) {
+		return this->Fail("nested more than " + std::to_string(QUERY_MAX_DEPTH) + " deep");
+	}
+	if (this->lexer.IsWord("not")) {
+		this->lexer.Advance();
+		++this->depth;
+		std::unique_ptr<QueryExpr> operand = this->ParseNot();
+		--this->depth;
+		if (!operand) {
+			return nullptr;
+		}
+		std::unique_ptr<QueryExpr> node(new QueryExpr());
+		node->kind = QueryExpr::Kind::Not;
+		node->left = std::move(operand);
+		return node;
+	}
+	if (this->lexer.token == QueryLexer::Token::LeftParen) {
+		this->lexer.Advance();
+		++this->depth;
+		std::unique_ptr<QueryExpr> inner = this->ParseOr();
+		--this->depth;
+		if (!inner) {
+			return nullptr;
+		}
+		if (this->lexer.token != QueryLexer::Token::RightParen) {
+			return this->Fail("expected ')'");
+		}
+		this->lexer.Advance();
+		return inner;
+	}
+	return this->ParseCompare();
+}
+
+// field := 'pages' | 'title' | 'author'
+inline bool QueryParser::ParseField(QueryField& field) {
+	if (this->lexer.IsWord("pages")) {
+		field = QueryField::Pages;
+	}
+	else if (this->lexer.IsWord("title")) {
+		field = QueryField::Title;
+	}
+	else if (this->lexer.IsWord("author")) {
+		field = QueryField::Author;
+	}
+	else {
+		this->Fail("expected pages, title or author");
+		return false;
+	}
+	this->lexer.Advance();
+	return true;
+}
+
+// comparison := field op (number | string)
+inline std::unique_ptr<QueryExpr> QueryParser::ParseCompare() {
+	if (++this->numTerms > QUERY_MAX_TERMS) {
+		return this->Fail("more than " + std::to_string(QUERY_MAX_TERMS) + " comparisons");
+	}
+	std::unique_ptr<QueryExpr> node(new QueryExpr());
+	node->kind = QueryExpr::Kind::Compare;
+	if (!this->ParseField(node->field)) {
+		return nullptr;
+	}
+	if (this->lexer.token != QueryLexer::Token::Op) {
+		return this->Fail("expected a comparison operator");
+	}
+	const std::string& op = this->lexer.value;
+	node->op = op == "=" ? QueryOp::Equal : op == "!=" ? QueryOp::NotEqual : op == "<" ? QueryOp::Less :
+		op == "<=" ? QueryOp::LessEqual : op == ">" ? QueryOp::Greater : QueryOp::GreaterEqual;
+	this->lexer.Advance();
+	// Pages compare against numbers, title and author against strings.
+	if (node->field == QueryField::Pages) {
+		if (this->lexer.token != QueryLexer::Token::Number) {
+			return this->Fail("expected a number");
+		}
+		node->number = static_cast<std::uint32_t>(this->lexer.number);
+	}
+	else {
+		if (this->lexer.token != QueryLexer::Token::String) {
+			return this->Fail("expected a quoted string");
+		}
+		node->text = this->lexer.value;
+	}
+	this->lexer.Advance();
+	return node;
+}
+
+// Parses the query text into query. Returns false and sets error if the text is not a valid query.
+// query := 'books' ['where' or-expr] ['order' 'by' field ['asc' | 'desc']] ['limit' number]
+inline bool ParseQuery(std::string_view text, Query& query, std::string& error) {
+	QueryParser parser;
+	parser.lexer.text = text;
+	parser.lexer.Advance();
+	query = Query();
+	if (!parser.lexer.IsWord("books")) {
+		parser.Fail("expected 'books'");
+	}
+	else {
+		parser.lexer.Advance();
+		if (parser.lexer.IsWord("where")) {
+			parser.lexer.Advance();
+			query.where = parser.ParseOr();
+		}
+		if (parser.error.empty() && parser.lexer.IsWord("order")) {
+			parser.lexer.Advance();
+			if (!parser.lexer.IsWord("by")) {
+				parser.Fail("expected 'by'");
+			}
+			else {
+				parser.lexer.Advance();
+				query.hasOrder = parser.ParseField(query.orderField);
+				if (parser.lexer.IsWord("asc") || parser.lexer.IsWord("desc")) {
+					query.descending = parser.lexer.IsWord("desc");
+					parser.lexer.Advance();
+				}
+			}
+		}
+		if (parser.error.empty() && parser.lexer.IsWord("limit")) {
+			parser.lexer.Advance();
+			if (parser.lexer.token != QueryLexer::Token::Number) {
+				parser.Fail("expected a number");
+			}
+			else {
+				query.limit = static_cast<std::size_t>(parser.lexer.number);
+				parser.lexer.Advance();
+			}
+		}
+		if (parser.error.empty() && parser.lexer.token != QueryLexer::Token::End) {
+			parser.Fail("unexpected text");
+		}
+	}
+	error = parser.error;
+	return error.empty();
+}
+
+// Adds every book that the person has written.
+inline void QueryCatalog::AddPerson(const Person& person) {
+	for (std::size_t idx = 0; idx < MAX_BOOKS_WRITTEN && person.booksWritten[idx]; ++idx) {
+		this->books.push_back(person.booksWritten[idx]);
+	}
+	this->indexed = false;
+}
+
+// Rebuilds the page and author indexes from books.
+inline void QueryCatalog::BuildIndexes() {
+	this->byPages.clear();
+	this->byAuthor.clear();
+	this->byPages.reserve(this->books.size());
+	for (Book* book : this->books) {
+		this->byPages.emplace_back(book->numberOfPages, book);
+		this->byAuthor[book->author ? book->author->name : std::string()].push_back(book);
+	}
+	std::sort(this->byPages.begin(), this->byPages.end(), [](const std::pair<std::uint32_t, Book*>& a, const std::pair<std::uint32_t, Book*>& b) {
+		return a.first < b.first;
+	});
+	this->indexed = true;
+}
+
+// Marks the indexes as out of date, so that PlanQuery only scans until BuildIndexes runs again.
+inline void QueryCatalog::InvalidateIndexes() {
+	this->indexed = false;
+}
+
+// Returns a one line description of the plan, for showing to a user.
+inline std::string QueryPlan::Describe() const {
+	std::string text;
+	switch (this->access) {
+	case Access::Scan: text = "full scan"; break;
+	case Access::PagesRange: text = "pages index [" + std::to_string(this->minPages) + ", " + std::to_string(this->maxPages) + "]"; break;
+	case Access::AuthorLookup: text = "author index \"" + this->author + "\""; break;
+	}
+	return text + ", about " + std::to_string(this->estimatedRows) + " rows, cost " + std::to_string(static_cast<long long>(this->cost));
+}
+
+// Narrows [minPages, maxPages] by every pages comparison that is and'ed into the top of the where clause.
+// Writes the name from an author equality to author. Returns false if the range is empty.
+inline bool QueryCollectConjuncts(const QueryExpr* expr, std::uint32_t& minPages, std::uint32_t& maxPages, const std::string*& author) {
+	if (expr->kind == QueryExpr::Kind::And) {
+		return QueryCollectConjuncts(expr->left.get(), minPages, maxPages, author) &&
+			QueryCollectConjuncts(expr->right.get(), minPages, maxPages, author);
+	}
+	if (expr->kind != QueryExpr::Kind::Compare) {
+		return true;		// Or and not cannot narrow an index range.
+	}
+	if (expr->field == QueryField::Author && expr->op == QueryOp::Equal) {
+		author = &expr->text;
+	}
+	if (expr->field != QueryField::Pages) {
+		return true;
+	}
+	std::uint32_t value = expr->number;
+	switch (expr->op) {
+	case QueryOp::Equal: minPages = std::max(minPages, value); maxPages = std::min(maxPages, value); break;
+	case QueryOp::Less: if (value == 0) return false; maxPages = std::min(maxPages, value - 1); break;
+	case QueryOp::LessEqual: maxPages = std::min(maxPages, value); break;
+	case QueryOp::Greater: if (value == UINT32_MAX) return false; minPages = std::max(minPages, value + 1); break;
+	case QueryOp::GreaterEqual: minPages = std::max(minPages, value); break;
+	case QueryOp::NotEqual: break;
+	}
+	return minPages <= maxPages;
+}
+
+// Picks the cheapest access path for the query. Indexes are only considered once BuildIndexes has run.
+// A visit through an index costs more than a sequential one, as it jumps around memory.
+inline QueryPlan PlanQuery(const Query& query, const QueryCatalog& catalog) {
+	constexpr double INDEX_VISIT_COST = 2.0;		// Cost of visiting one book through an index, relative to a scan.
+	QueryPlan plan;
+	plan.estimatedRows = catalog.books.size();
+	plan.cost = static_cast<double>(catalog.books.size());
+	if (!query.where || !catalog.indexed) {
+		return plan;
+	}
+	std::uint32_t minPages = 0;
+	std::uint32_t maxPages = UINT32_MAX;
+	const std::string* author = nullptr;
+	if (!QueryCollectConjuncts(query.where.get(), minPages, maxPages, author)) {
+		// The pages conditions contradict each other, so an empty range of the index answers the query.
+		plan.access = QueryPlan::Access::PagesRange;
+		plan.minPages = 1;
+		plan.maxPages = 0;
+		plan.estimatedRows = 0;
+		plan.cost = 0.0;
+		return plan;
+	}
+	if (minPages != 0 || maxPages != UINT32_MAX) {
+		// The index is sorted, so two binary searches give the exact number of rows in range.
+		std::vector<std::pair<std::uint32_t, Book*>>::const_iterator first = std::lower_bound(catalog.byPages.begin(), catalog.byPages.end(), minPages,
+			[](const std::pair<std::uint32_t, Book*>& entry, std::uint32_t value) { return entry.first < value; });
+		std::vector<std::pair<std::uint32_t, Book*>>::const_iterator last = std::upper_bound(first, catalog.byPages.end(), maxPages,
+			[](std::uint32_t value, const std::pair<std::uint32_t, Book*>& entry) { return value < entry.first; });
+		std::size_t rows = static_cast<std::size_t>(last - first);
+		double cost = static_cast<double>(rows) * INDEX_VISIT_COST;
+		if (cost < plan.cost) {
+			plan.access = QueryPlan::Access::PagesRange;
+			plan.minPages = minPages;
+			plan.maxPages = maxPages;
+			plan.estimatedRows = rows;
+			plan.cost = cost;
+		}
+	}
+	if (author) {
+		std::unordered_map<std::string, std::vector<Book*>>::const_iterator it = catalog.byAuthor.find(*author);
+		std::size_t rows = it == catalog.byAuthor.end() ? 0 : it->second.size();
+		double cost = static_cast<double>(rows) * INDEX_VISIT_COST;
+		if (cost < plan.cost) {
+			plan.access = QueryPlan::Access::AuthorLookup;
+			plan.author = *author;
+			plan.estimatedRows = rows;
+			plan.cost = cost;
+		}
+	}
+	return plan;
+}
+
+// Returns the name of the book's author, or an empty string if it has none.
+inline const std::string& QueryAuthorName(const Book* book) {
+	static const std::string NO_AUTHOR;
+	return book->author ? book->author->name : NO_AUTHOR;
+}
+
+// Compares a to b with op.
+template <typename T>
+inline bool QueryCompare(QueryOp op, const T& a, const T& b) {
+	switch (op) {
+	case QueryOp::Equal: return a == b;
+	case QueryOp::NotEqual: return !(a == b);
+	case QueryOp::Less: return a < b;
+	case QueryOp::LessEqual: return !(b < a);
+	case QueryOp::Greater: return b < a;
+	case QueryOp::GreaterEqual: return !(a < b);
+	}
+	return false;
+}
+
+// Writes the entries of sel (ascending indexes into batch) that pass the comparison to out, and returns how many there are.
+// The operator is picked once for the batch, and each case is a fused loop compiled from a Predicate.h predicate.
+inline std::size_t QueryFilterPages(const QueryExpr* expr, Book* const* batch, const std::uint16_t* sel, std::size_t count, std::uint16_t* out) {
+	const std::uint32_t value = expr->number;
+	switch (expr->op) {
+	case QueryOp::Equal: return FilterSelection(Pages() == value, batch, sel, count, out);
+	case QueryOp::NotEqual: return FilterSelection(Pages() != value, batch, sel, count, out);
+	case QueryOp::Less: return FilterSelection(Pages() < value, batch, sel, count, out);
+	case QueryOp::LessEqual: return FilterSelection(Pages() <= value, batch, sel, count, out);
+	case QueryOp::Greater: return FilterSelection(Pages() > value, batch, sel, count, out);
+	case QueryOp::GreaterEqual: return FilterSelection(Pages() >= value, batch, sel, count, out);
+	}
+	return 0;
+}
+
+// Returns how many selection vectors of BOOK_BATCH_SIZE entries QueryFilterBatch needs as scratch for the expression.
+inline std::size_t QueryScratchBatches(const QueryExpr* expr) {
+	switch (expr->kind) {
+	case QueryExpr::Kind::Compare:
+		return 0;
+	case QueryExpr::Kind::And:
+		return 1 + std::max(QueryScratchBatches(expr->left.get()), QueryScratchBatches(expr->right.get()));
+	case QueryExpr::Kind::Or:
+		return 3 + std::max(QueryScratchBatches(expr->left.get()), QueryScratchBatches(expr->right.get()));
+	case QueryExpr::Kind::Not:
+		return 1 + QueryScratchBatches(expr->left.get());
+	}
+	return 0;
+}
+
+// Filters sel by the expression into out, and returns the number of entries written. sel and out may not overlap.
+// Each node takes the selection vectors it needs from the front of scratch and hands the rest to its operands, so the
+// stack stays small however deep the expression is. scratch must hold QueryScratchBatches(expr) vectors.
+inline std::size_t QueryFilterBatch(const QueryExpr* expr, Book* const* batch, const std::uint16_t* sel, std::size_t count, std::uint16_t* out, std::uint16_t* scratch) {
+	switch (expr->kind) {
+	case QueryExpr::Kind::Compare: {
+		if (expr->field == QueryField::Pages) {
+			return QueryFilterPages(expr, batch, sel, count, out);
+		}
+		std::size_t n = 0;
+		for (std::size_t i = 0; i < count; ++i) {
+			const std::string& value = expr->field == QueryField::Title ? batch[sel[i]]->title : QueryAuthorName(batch[sel[i]]);
+			out[n] = sel[i];
+			n += QueryCompare(expr->op, value, expr->text) ? 1 : 0;
+		}
+		return n;
+	}
+	case QueryExpr::Kind::And: {
+		// The right side only sees what passed the left side.
+		std::uint16_t* left = scratch;
+		std::size_t n = QueryFilterBatch(expr->left.get(), batch, sel, count, left, scratch + BOOK_BATCH_SIZE);
+		return QueryFilterBatch(expr->right.get(), batch, left, n, out, scratch + BOOK_BATCH_SIZE);
+	}
+	case QueryExpr::Kind::Or: {
+		// The right side only sees what failed the left side, and the two sorted selections are merged.
+		std::uint16_t* left = scratch;
+		std::uint16_t* rest = scratch + BOOK_BATCH_SIZE;
+		std::uint16_t* right = scratch + 2 * BOOK_BATCH_SIZE;
+		std::size_t numLeft = QueryFilterBatch(expr->left.get(), batch, sel, count, left, scratch + 3 * BOOK_BATCH_SIZE);
+		std::size_t numRest = 0;
+		for (std::size_t i = 0, j = 0; i < count; ++i) {
+			if (j < numLeft && left[j] == sel[i]) {
+				++j;
+			}
+			else {
+				rest[numRest++] = sel[i];
+			}
+		}
+		std::size_t numRight = QueryFilterBatch(expr->right.get(), batch, rest, numRest, right, scratch + 3 * BOOK_BATCH_SIZE);
+		return static_cast<std::size_t>(std::merge(left, left + numLeft, right, right + numRight, out) - out);
+	}
+	case QueryExpr::Kind::Not: {
+		// Keep what the operand rejects.
+		std::uint16_t* inner = scratch;
+		std::size_t numInner = QueryFilterBatch(expr->left.get(), batch, sel, count, inner, scratch + BOOK_BATCH_SIZE);
+		std::size_t n = 0;
+		for (std::size_t i = 0, j = 0; i < count; ++i) {
+			if (j < numInner && inner[j] == sel[i]) {
+				++j;
+			}
+			else {
+				out[n++] = sel[i];
+			}
+		}
+		return n;
+	}
+	}
+	return 0;
+}
+
+// Runs the query over the catalog and returns the matching books.
+// The whole where clause is checked against every candidate, so the access path only has to return a superset of the answer.
+inline std::vector<Book*> RunQuery(const Query& query, const QueryCatalog& catalog, const QueryPlan& plan) {
+	std::vector<Book*> results;
+	// Without an order by, the scan can stop as soon as the limit is reached.
+	std::size_t stopAt = query.hasOrder ? SIZE_MAX : query.limit;
+	Book* batch[BOOK_BATCH_SIZE];				// The candidate books of the current batch.
+	std::uint16_t all[BOOK_BATCH_SIZE];			// Selection vector with every index of a full batch.
+	std::uint16_t selected[BOOK_BATCH_SIZE];	// The indexes that pass the where clause.
+	// Selection vectors for the nodes of the where clause, allocated once for the whole query.
+	std::vector<std::uint16_t> scratch(query.where ? QueryScratchBatches(query.where.get()) * BOOK_BATCH_SIZE : 0);
+	for (std::size_t i = 0; i < BOOK_BATCH_SIZE; ++i) {
+		all[i] = static_cast<std::uint16_t>(i);
+	}
+	// Filters one batch and appends the books that pass to the results.
+	auto flush = [&](std::size_t count) {
+		std::size_t n = query.where ? QueryFilterBatch(query.where.get(), batch, all, count, selected, scratch.data()) : count;
+		for (std::size_t i = 0; i < n && results.size() < stopAt; ++i) {
+			results.push_back(batch[query.where ? selected[i] : i]);
+		}
+	};
+	// Cuts the candidates into batches. getBook(i) returns candidate i.
+	auto runBatches = [&](std::size_t numCandidates, auto getBook) {
+		for (std::size_t start = 0; start < numCandidates && results.size() < stopAt; start += BOOK_BATCH_SIZE) {
+			std::size_t count = std::min(BOOK_BATCH_SIZE, numCandidates - start);
+			for (std::size_t i = 0; i < count; ++i) {
+				batch[i] = getBook(start + i);
+			}
+			flush(count);
+		}
+	};
+	switch (plan.access) {
+	case QueryPlan::Access::Scan:
+		runBatches(catalog.books.size(), [&](std::size_t i) { return catalog.books[i]; });
+		break;
+	case QueryPlan::Access::PagesRange: {
+		if (plan.minPages > plan.maxPages) {
+			break;		// The range is empty.
+		}
+		std::vector<std::pair<std::uint32_t, Book*>>::const_iterator first = std::lower_bound(catalog.byPages.begin(), catalog.byPages.end(), plan.minPages,
+			[](const std::pair<std::uint32_t, Book*>& entry, std::uint32_t value) { return entry.first < value; });
+		std::vector<std::pair<std::uint32_t, Book*>>::const_iterator last = std::upper_bound(first, catalog.byPages.end(), plan.maxPages,
+			[](std::uint32_t value, const std::pair<std::uint32_t, Book*>& entry) { return value < entry.first; });
+		runBatches(static_cast<std::size_t>(last - first), [&](std::size_t i) { return first[static_cast<std::ptrdiff_t>(i)].second; });
+		break;
+	}
+	case QueryPlan::Access::AuthorLookup: {
+		std::unordered_map<std::string, std::vector<Book*>>::const_iterator it = catalog.byAuthor.find(plan.author);
+		if (it != catalog.byAuthor.end()) {
+			const std::vector<Book*>& books = it->second;
+			runBatches(books.size(), [&](std::size_t i) { return books[i]; });
+		}
+		break;
+	}
+	}
+	if (query.hasOrder) {
+		// Orders two books by the order by field, breaking ties by title so that the output does not depend on the access path.
+		auto less = [&query](const Book* a, const Book* b) {
+			if (query.descending) {
+				std::swap(a, b);
+			}
+			switch (query.orderField) {
+			case QueryField::Pages: if (a->numberOfPages != b->numberOfPages) return a->numberOfPages < b->numberOfPages; break;
+			case QueryField::Title: break;
+			case QueryField::Author: {
+				int cmp = QueryAuthorName(a).compare(QueryAuthorName(b));
+				if (cmp != 0) return cmp < 0;
+				break;
+			}
+			}
+			return a->title < b->title;
+		};
+		// Only the first limit books need to be in order.
+		if (query.limit < results.size()) {
+			std::partial_sort(results.begin(), results.begin() + static_cast<std::ptrdiff_t>(query.limit), results.end(), less);
+			results.resize(query.limit);
+		}
+		else if (results.size() >= 2 * PARALLEL_SORT_MIN_PER_THREAD) {
+			// Large full sorts go to the parallel sort, whose orders refine the tie breaking above.
+			CatalogSortKey key = query.orderField == QueryField::Pages ? CatalogSortKey::Pages :
+				query.orderField == QueryField::Title ? CatalogSortKey::Title : CatalogSortKey::Author;
+			ParallelSortCatalog(results, key, query.descending);
+		}
+		else {
+			std::sort(results.begin(), results.end(), less);
+		}
+	}
+	return results;
+}
+
+// Parses, plans and runs the query text. Returns false and sets error if the text is not a valid query.
+inline bool RunQuery(std::string_view text, const QueryCatalog& catalog, std::vector<Book*>& results, std::string& error) {
+	Query query;
+	if (!ParseQuery(text, query, error)) {
+		return false;
+	}
+	results = RunQuery(query, catalog, PlanQuery(query, catalog));
+	return true;
+}
@@ -0,0 +1,173 @@
+/****************************************************************
+* Author: Leo Carroll
+* Description:
+*	A Book whose title and page count can be changed by editors
+*	while many threads read and print it. The fields are guarded
+*	by a seqlock: a sequence number that is odd while a write is
+*	in progress and moves on by two with every write. A reader
+*	notes the sequence, copies the fields and checks that the
+*	sequence is unchanged, retrying if not. Readers never take a
+*	lock or write to shared memory, so they do not slow each
+*	other or the writer down.
+*
+*	Every field is stored in atomic words, read and written with
+*	relaxed operations, so a copy torn by a concurrent write is
+*	a detected retry rather than a data race. The title is held
+*	inline in up to SEQLOCK_TITLE_BYTES bytes for that reason.
+*
+*	Only SeqlockBook is protected. A plain Book still has no
+*	synchronization: the Book and Person output operators read
+*	title and numberOfPages directly, so printing a Book while
+*	another thread calls Book::SetPages or SetTitle is a data
+*	race. Share a SeqlockBook, not a Book, between threads.
+*	SeqlockTorture.cpp checks the seqlock under contention.
+* Date Created: 2026-10-18
+* Date Modified: 2026-10-18
+****************************************************************/
+
+#pragma once
+
+#include <atomic>			// Included for std::atomic and std::atomic_thread_fence.
+#include <cstddef>			// Included for std::size_t.
+#include <cstdint>			// Included for std::uint32_t and std::uint64_t.
+#include <cstring>			// Included for std::memcpy.
+#include <ostream>			// Included for std::ostream.
+#include <string>			// Included for std::string.
+#include <string_view>		// Included for std::string_view.
+#include <thread>			// Included for std::this_thread::yield.
+
+#include "Catalog.h"		// Included for Person and Book.
+
+// Longest title a SeqlockBook can hold.
+constexpr std::size_t SEQLOCK_TITLE_BYTES = 256;
+
+// A consistent copy of a SeqlockBook's fields.
+struct SeqlockSnapshot {
+	std::string title;					// Title of the book.
+	std::uint32_t numberOfPages = 0;	// Number of pages in the book.
+};
+
+// A Book with seqlock-guarded title and page count.
+struct SeqlockBook {
+	Person* author;															// The author. Not guarded, as it does not change.
+	std::atomic<std::uint32_t> sequence{ 0 };								// Odd while a write is in progress.
+	std::atomic<std::uint32_t> titleLength{ 0 };							// Bytes of the title in use.
+	std::atomic<std::uint32_t> numberOfPages{ 0 };							// Number of pages in the book.
+	std::atomic<std::uint64_t> titleWords[SEQLOCK_TITLE_BYTES / 8];			// The bytes of the title.
+
+	// Custom constructor
+	SeqlockBook(Person*, std::string_view, std::uint32_t);
+	// Copies a Book. The title is cut at SEQLOCK_TITLE_BYTES.
+	explicit SeqlockBook(const Book&);
+
+	bool Set(std::string_view, std::uint32_t);
+	bool SetTitle(std::string_view);
+	void SetPages(std::uint32_t);
+	void Read(SeqlockSnapshot&) const;
+	std::uint32_t BeginWrite();
+	void EndWrite(std::uint32_t);
+	void StoreTitle(std::string_view);
+};
+
+// SeqlockBook custom constructor
+inline SeqlockBook::SeqlockBook(Person* author, std::string_view title, std::uint32_t numberOfPages) {
+	this->author = author;
+	this->StoreTitle(title.substr(0, SEQLOCK_TITLE_BYTES));
+	this->numberOfPages.store(numberOfPages, std::memory_order_relaxed);
+}
+
+inline SeqlockBook::SeqlockBook(const Book& book) : SeqlockBook(book.author, book.title, book.numberOfPages) {}
+
+// Waits for other writers and makes the sequence odd. Returns the odd sequence.
+inline std::uint32_t SeqlockBook::BeginWrite() {
+	std::uint32_t current = this->sequence.load(std::memory_order_relaxed);
+	while (true) {
+		if ((current & 1) == 0 && this->sequence.compare_exchange_weak(current, current + 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+			// Keep the field stores below from moving above the odd sequence, where a reader could take them for a finished write.
+			std::atomic_thread_fence(std::memory_order_release);
+			return current + 1;
+		}
+		if (current & 1) {
+			std::this_thread::yield();		// Writes are rare, so another writer is worth yielding to.
+			current = this->sequence.load(std::memory_order_relaxed);
+		}
+	}
+}
+
+// Publishes the fields written since BeginWrite.
+inline void SeqlockBook::EndWrite(std::uint32_t odd) {
+	this->sequence.store(odd + 1, std::memory_order_release);
+}
+
+// Stores the title's bytes and length. The caller holds the write side.
+inline void SeqlockBook::StoreTitle(std::string_view title) {
+	std::size_t numWords = (title.size() + 7) / 8;
+	for (std::size_t i = 0; i < numWords; ++i) {
+		std::uint64_t word = 0;
+		std::memcpy(&word, title.data() + 8 * i, title.size() - 8 * i < 8 ? title.size() - 8 * i : 8);
+		this->titleWords[i].store(word, std::memory_order_relaxed);
+	}
+	this->titleLength.store(static_cast<std::uint32_t>(title.size()), std::memory_order_relaxed);
+}
+
+// Changes the title and page count together. Returns false, changing nothing, if the title is too long.
+inline bool SeqlockBook::Set(std::string_view title, std::uint32_t numberOfPages) {
+	if (title.size() > SEQLOCK_TITLE_BYTES) {
+		return false;
+	}
+	std::uint32_t odd = this->BeginWrite();
+	this->StoreTitle(title);
+	this->numberOfPages.store(numberOfPages, std::memory_order_relaxed);
+	this->EndWrite(odd);
+	return true;
+}
+
+// Changes the title. Returns false, changing nothing, if it is too long.
+inline bool SeqlockBook::SetTitle(std::string_view title) {
+	if (title.size() > SEQLOCK_TITLE_BYTES) {
+		return false;
+	}
+	std::uint32_t odd = this->BeginWrite();
+	this->StoreTitle(title);
+	this->EndWrite(odd);
+	return true;
+}
+
+inline void SeqlockBook::SetPages(std::uint32_t numberOfPages) {
+	std::uint32_t odd = this->BeginWrite();
+	this->numberOfPages.store(numberOfPages, std::memory_order_relaxed);
+	this->EndWrite(odd);
+}
+
+// Copies the title and page count as they were between two writes, retrying while a write overlaps the copy.
+inline void SeqlockBook::Read(SeqlockSnapshot& snapshot) const {
+	char bytes[SEQLOCK_TITLE_BYTES];
+	while (true) {
+		std::uint32_t before = this->sequence.load(std::memory_order_acquire);
+		if (before & 1) {
+			continue;		// A write is in progress.
+		}
+		std::uint32_t length = this->titleLength.load(std::memory_order_relaxed);
+		length = length > SEQLOCK_TITLE_BYTES ? static_cast<std::uint32_t>(SEQLOCK_TITLE_BYTES) : length;		// May be torn, so bound it.
+		for (std::size_t i = 0; i < (length + 7) / 8; ++i) {
+			std::uint64_t word = this->titleWords[i].load(std::memory_order_relaxed);
+			std::memcpy(bytes + 8 * i, &word, 8);
+		}
+		std::uint32_t pages = this->numberOfPages.load(std::memory_order_relaxed);
+		// Keep the loads above from moving below the second read of the sequence.
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (this->sequence.load(std::memory_order_relaxed) == before) {
+			snapshot.title.assign(bytes, length);
+			snapshot.numberOfPages = pages;
+			return;
+		}
+	}
+}
+
+// SeqlockBook output operator overload, in the same format as the Book output operator.
+inline std::ostream& operator<<(std::ostream& os, const SeqlockBook& book) {
+	SeqlockSnapshot snapshot;
+	book.Read(snapshot);
+	os << snapshot.title << ", " << (book.author ? book.author->name : "Unknown") << ", " << snapshot.numberOfPages << " pages";
+	return os;
+}
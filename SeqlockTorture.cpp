@@ -0,0 +1,100 @@
+/****************************************************************
+* Author: Leo Carroll
+* Description:
+*	A torture test of SeqlockBook. Writer threads keep setting
+*	the title and page count of one book to matching pairs, and
+*	reader threads keep reading it and printing it, checking
+*	that every snapshot is a pair that some writer set and never
+*	a mix of two writes. Titles change length from write to
+*	write, so a torn copy shows up in the length as well as in
+*	the bytes. The program returns 1 if any read is torn.
+*
+*	Build on its own, apart from Main.cpp:
+*	g++ -std=c++17 -O2 -pthread SeqlockTorture.cpp
+*	or, to have the race detector check it as well:
+*	g++ -std=c++17 -O1 -g -fsanitize=thread -pthread
+*		SeqlockTorture.cpp
+* Date Created: 2026-10-18
+* Date Modified: 2026-10-18
+****************************************************************/
+
+#include <atomic>			// Included for std::atomic.
+#include <cstdint>			// Included for std::uint32_t.
+#include <cstdlib>			// Included for std::strtoul.
+#include <iostream>			// Included for std::cout.
+#include <sstream>			// Included for std::ostringstream.
+#include <string>			// Included for std::string.
+#include <thread>			// Included for std::thread.
+#include <vector>			// Included for std::vector.
+
+#include "SeqlockBook.h"	// Included for SeqlockBook and SeqlockSnapshot.
+
+constexpr unsigned NUM_WRITERS = 2;					// Number of threads calling Set.
+constexpr unsigned NUM_READERS = 4;					// Number of threads calling Read and printing.
+constexpr std::uint32_t WRITES_PER_WRITER = 200000;	// Number of Set calls per writer.
+
+// Returns the title that goes with a page count: a run of one letter, between 1 and 200 bytes long, then the count.
+std::string TortureTitle(std::uint32_t pages) {
+	return std::string(pages % 200 + 1, static_cast<char>('a' + pages % 26)) + ":" + std::to_string(pages);
+}
+
+// Returns whether the title and page count were set together.
+bool TortureConsistent(const std::string& title, std::uint32_t pages) {
+	return title == TortureTitle(pages);
+}
+
+int main() {
+	Person author(nullptr, 0, "Torture");
+	SeqlockBook book(&author, TortureTitle(0), 0);
+	std::atomic<unsigned> writersLeft(NUM_WRITERS);
+	std::atomic<std::uint64_t> numReads(0);
+	std::atomic<std::uint64_t> numTorn(0);
+
+	std::vector<std::thread> threads;
+	for (unsigned w = 0; w < NUM_WRITERS; ++w) {
+		threads.emplace_back([&, w]() {
+			// Each writer uses its own page counts, so the pairs of different writers never coincide.
+			for (std::uint32_t i = 0; i < WRITES_PER_WRITER; ++i) {
+				std::uint32_t pages = i * NUM_WRITERS + w;
+				book.Set(TortureTitle(pages), pages);
+			}
+			writersLeft.fetch_sub(1);
+		});
+	}
+	for (unsigned r = 0; r < NUM_READERS; ++r) {
+		threads.emplace_back([&, r]() {
+			SeqlockSnapshot snapshot;
+			std::uint64_t reads = 0;
+			std::uint64_t torn = 0;
+			// Half the readers go through the output operator, which must print one consistent pair too.
+			bool print = r % 2 == 1;
+			while (writersLeft.load() != 0) {
+				if (print) {
+					std::ostringstream os;
+					os << book;
+					// The text must be exactly what the Book output operator prints for one of the pairs.
+					std::string text = os.str();
+					std::size_t pagesAt = text.rfind(", ");
+					std::uint32_t pages = pagesAt == std::string::npos ? 0 : static_cast<std::uint32_t>(std::strtoul(text.c_str() + pagesAt + 2, nullptr, 10));
+					torn += text == TortureTitle(pages) + ", " + author.name + ", " + std::to_string(pages) + " pages" ? 0 : 1;
+				}
+				else {
+					book.Read(snapshot);
+					torn += TortureConsistent(snapshot.title, snapshot.numberOfPages) ? 0 : 1;
+				}
+				++reads;
+			}
+			numReads.fetch_add(reads);
+			numTorn.fetch_add(torn);
+		});
+	}
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+
+	SeqlockSnapshot last;
+	book.Read(last);
+	bool finalConsistent = TortureConsistent(last.title, last.numberOfPages);
+	std::cout << NUM_WRITERS * WRITES_PER_WRITER << " writes, " << numReads.load() << " reads, " << numTorn.load() << " torn\n";
+	return numTorn.load() == 0 && finalConsistent ? 0 : 1;
+}
@@ -0,0 +1,219 @@
+/****************************************************************
+* Author: Leo Carroll
+* Description:
+*	A generational slot map. Objects are looked up by a handle
+*	that holds a slot index and the generation of that slot.
+*	Removing an object bumps the generation of its slot, so an
+*	old handle no longer matches and the lookup returns nullptr
+*	instead of a dangling pointer. Freed slots are reused.
+*
+*	CatalogTables keeps the Persons and Books of a catalog in
+*	two slot maps, and unlinks Persons and Books from each other
+*	when one of them is removed.
+* Date Created: 2026-10-18
+* Date Modified: 2026-10-18
+****************************************************************/
+
+#pragma once
+
+#include <cstddef>			// Included for std::size_t.
+#include <cstdint>			// Included for std::uint32_t.
+#include <new>				// Included for placement new.
+#include <string>			// Included for std::string.
+#include <utility>			// Included for std::forward.
+
+#include "Catalog.h"		// Included for Person and Book.
+#include "StableStorage.h"	// Included for StableStorage.
+
+// Refers to an object in a SlotMap<T>. The default handle never refers to anything.
+template <typename T>
+struct SlotHandle {
+	std::uint32_t index = 0;			// Index of the slot.
+	std::uint32_t generation = 0;		// Generation of the slot when the object was inserted. Always odd for a real handle.
+
+	bool operator==(const SlotHandle& other) const { return this->index == other.index && this->generation == other.generation; }
+	bool operator!=(const SlotHandle& other) const { return !(*this == other); }
+};
+
+using PersonHandle = SlotHandle<Person>;
+using BookHandle = SlotHandle<Book>;
+
+// Marks the end of the free list.
+constexpr std::uint32_t SLOT_NONE = UINT32_MAX;
+
+template <typename T>
+struct SlotMap {
+	// A slot holds an object while its generation is odd, and is on the free list while it is even.
+	struct Slot {
+		std::uint32_t generation = 0;			// Bumped on every insert and every remove.
+		std::uint32_t nextFree = SLOT_NONE;		// The next free slot, while this one is free.
+		alignas(T) unsigned char storage[sizeof(T)];		// Storage for the object.
+	};
+
+	StableStorage<Slot> slots;		// Every slot ever used. Slots never move, so a pointer from Get stays valid until Remove.
+	std::uint32_t freeHead;			// The most recently freed slot, or SLOT_NONE.
+	std::size_t size;				// Number of live objects.
+
+	// Default constructor
+	SlotMap();
+	// Destructor, destroys every live object.
+	~SlotMap();
+
+	template <typename... Args>
+	SlotHandle<T> Insert(Args&&...);
+	T* Get(SlotHandle<T>) const;
+	bool Remove(SlotHandle<T>);
+	std::size_t Size() const;
+
+	// Calls func with the handle and a reference to every live object.
+	template <typename Func>
+	void ForEach(Func&&);
+};
+
+// Keeps the Persons and Books of a catalog in slot maps.
+// Removing either side clears the raw pointer that the other side holds, so Person and Book never point at freed memory.
+struct CatalogTables {
+	CatalogStats stats;				// Catalog-wide totals that every Person is attached to. Declared first so it outlives the Persons.
+	SlotMap<Person> persons;		// Every Person in the catalog.
+	SlotMap<Book> books;			// Every Book in the catalog.
+
+	PersonHandle AddPerson(const std::string&);
+	BookHandle AddBook(PersonHandle, const std::string&, std::uint32_t);
+	bool RemovePerson(PersonHandle);
+	bool RemoveBook(BookHandle);
+};
+
+// Default constructor
+template <typename T>
+inline SlotMap<T>::SlotMap() {
+	this->freeHead = SLOT_NONE;
+	this->size = 0;
+}
+
+// Destructor
+template <typename T>
+inline SlotMap<T>::~SlotMap() {
+	for (Slot& slot : this->slots) {
+		if (slot.generation & 1) {
+			reinterpret_cast<T*>(slot.storage)->~T();
+		}
+	}
+}
+
+// Constructs an object in a free slot, or a new one if none is free, and returns its handle.
+template <typename T>
+template <typename... Args>
+inline SlotHandle<T> SlotMap<T>::Insert(Args&&... args) {
+	std::uint32_t index = this->freeHead;		// The slot that the object goes in.
+	Slot* slot = nullptr;
+	if (index != SLOT_NONE) {
+		slot = &this->slots[index];
+		new (slot->storage) T(std::forward<Args>(args)...);
+		this->freeHead = slot->nextFree;		// Only unlink the slot once the constructor has returned.
+	}
+	else {
+		index = static_cast<std::uint32_t>(this->slots.Size());
+		slot = &this->slots.Emplace();
+		new (slot->storage) T(std::forward<Args>(args)...);
+	}
+	++slot->generation;		// Even to odd, the slot is now live.
+	++this->size;
+	return SlotHandle<T>{ index, slot->generation };
+}
+
+// Returns the object that the handle refers to, or nullptr if it has been removed or the handle is not from this map.
+template <typename T>
+inline T* SlotMap<T>::Get(SlotHandle<T> handle) const {
+	if (handle.index >= this->slots.Size()) {
+		return nullptr;
+	}
+	const Slot& slot = this->slots[handle.index];
+	// Free slots have an even generation and real handles never do, so one compare covers both cases.
+	return slot.generation == handle.generation ? reinterpret_cast<T*>(const_cast<unsigned char*>(slot.storage)) : nullptr;
+}
+
+// Destroys the object that the handle refers to and frees its slot. Returns false if the handle is stale.
+template <typename T>
+inline bool SlotMap<T>::Remove(SlotHandle<T> handle) {
+	T* object = this->Get(handle);
+	if (object == nullptr) {
+		return false;
+	}
+	object->~T();
+	Slot& slot = this->slots[handle.index];
+	++slot.generation;		// Odd to even, every handle to the slot is now stale.
+	--this->size;
+	// A slot whose generation is about to wrap is retired, so that a very old handle can never match again.
+	if (slot.generation != UINT32_MAX - 1) {
+		slot.nextFree = this->freeHead;
+		this->freeHead = handle.index;
+	}
+	return true;
+}
+
+template <typename T>
+inline std::size_t SlotMap<T>::Size() const {
+	return this->size;
+}
+
+template <typename T>
+template <typename Func>
+inline void SlotMap<T>::ForEach(Func&& func) {
+	std::uint32_t index = 0;		// Index of the slot being visited.
+	for (Slot& slot : this->slots) {
+		if (slot.generation & 1) {
+			func(SlotHandle<T>{ index, slot.generation }, *reinterpret_cast<T*>(slot.storage));
+		}
+		++index;
+	}
+}
+
+// Adds a Person with no books, counted in the catalog-wide totals.
+inline PersonHandle CatalogTables::AddPerson(const std::string& name) {
+	PersonHandle handle = this->persons.Insert(nullptr, 0, name);
+	this->persons.Get(handle)->SetRollup(&this->stats);
+	return handle;
+}
+
+// Adds a Book and adds it to its author's booksWritten. A stale author handle gives a book with no author.
+// Returns the default handle, and adds nothing, if the author already has MAX_BOOKS_WRITTEN books,
+// as the book could not be listed and RemovePerson would leave its author pointer dangling.
+inline BookHandle CatalogTables::AddBook(PersonHandle author, const std::string& title, std::uint32_t pages) {
+	Person* person = this->persons.Get(author);
+	if (person && person->booksWritten[MAX_BOOKS_WRITTEN - 1] != nullptr) {
+		return BookHandle();
+	}
+	BookHandle handle = this->books.Insert(person, title, pages);
+	if (person) {
+		person->AddBook(this->books.Get(handle));
+	}
+	return handle;
+}
+
+// Removes a Person. Its books stay in the catalog with no author.
+inline bool CatalogTables::RemovePerson(PersonHandle handle) {
+	Person* person = this->persons.Get(handle);
+	if (person == nullptr) {
+		return false;
+	}
+	// Clear the author of every book that points back at this person.
+	for (std::size_t idx = 0; idx < MAX_BOOKS_WRITTEN && person->booksWritten[idx]; ++idx) {
+		if (person->booksWritten[idx]->author == person) {
+			person->booksWritten[idx]->author = nullptr;
+		}
+	}
+	person->SetRollup(nullptr);		// Its books are no longer counted in the catalog-wide totals.
+	return this->persons.Remove(handle);
+}
+
+// Removes a Book, and removes it from its author's booksWritten first.
+inline bool CatalogTables::RemoveBook(BookHandle handle) {
+	Book* book = this->books.Get(handle);
+	if (book == nullptr) {
+		return false;
+	}
+	if (book->author) {
+		book->author->RemoveBook(book);
+	}
+	return this->books.Remove(handle);
+}
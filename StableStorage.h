@@ -0,0 +1,229 @@
+/****************************************************************
+* Author: Leo Carroll
+* Description:
+*	A growable container that never moves its elements. It is
+*	made of segments that double in size, and a full segment
+*	is never copied, so a pointer to an element stays valid
+*	until the container is cleared. This is what lets Persons
+*	keep raw Book pointers in booksWritten, and Books keep a
+*	raw Person pointer, while the catalog keeps growing.
+* Date Created: 2026-10-18
+* Date Modified: 2026-10-18
+****************************************************************/
+
+#pragma once
+
+#include <cstddef>			// Included for std::size_t.
+#include <cstdint>			// Included for std::uint32_t.
+#include <new>				// Included for placement new and std::align_val_t.
+#include <string>			// Included for std::string.
+#include <utility>			// Included for std::forward.
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>			// Included for _BitScanReverse.
+#endif
+
+#include "Catalog.h"		// Included for Person and Book.
+
+// Returns the index of the highest set bit. bits must not be zero.
+inline std::size_t StorageHighestBit(std::uint64_t bits) {
+#if defined(__GNUC__) || defined(__clang__)
+	return static_cast<std::size_t>(63 - __builtin_clzll(bits));
+#elif defined(_MSC_VER)
+	unsigned long index = 0;		// Set by _BitScanReverse to the index of the highest set bit.
+	// _BitScanReverse64 only exists on 64 bit targets, so scan the two halves with the 32 bit form.
+	if (_BitScanReverse(&index, static_cast<unsigned long>(bits >> 32))) {
+		return static_cast<std::size_t>(index) + 32;
+	}
+	_BitScanReverse(&index, static_cast<unsigned long>(bits));
+	return static_cast<std::size_t>(index);
+#else
+	std::size_t index = 0;
+	while (bits >>= 1) {
+		++index;
+	}
+	return index;
+#endif
+}
+
+// Returns the base 2 logarithm of a power of two, at compile time.
+constexpr std::size_t StorageLog2(std::size_t value) {
+	return value <= 1 ? 0 : 1 + StorageLog2(value >> 1);
+}
+
+// Segment k holds FirstSegmentSize << k elements, so the container holds FirstSegmentSize * (2^k - 1) elements after k segments.
+// FirstSegmentSize must be a power of two.
+template <typename T, std::size_t FirstSegmentSize = 64>
+struct StableStorage {
+	static_assert((FirstSegmentSize & (FirstSegmentSize - 1)) == 0, "FirstSegmentSize must be a power of two.");
+
+	// More segments than can ever be allocated, so the segment table itself never has to grow.
+	static constexpr std::size_t MAX_SEGMENTS = 48;
+
+	// Forward iterator that walks one segment at a time.
+	struct Iterator {
+		T* const* segments;			// The segment table of the container.
+		std::size_t segment;		// The segment that current is in.
+		T* current;					// The element that the iterator points at.
+		T* segmentEnd;				// One past the last element of the segment that is in use.
+		std::size_t remaining;		// Elements left in the container after the current segment.
+
+		T& operator*() const { return *this->current; }
+		T* operator->() const { return this->current; }
+		Iterator& operator++();
+		bool operator==(const Iterator& other) const { return this->current == other.current; }
+		bool operator!=(const Iterator& other) const { return this->current != other.current; }
+	};
+
+	T* segments[MAX_SEGMENTS];		// The segments, nullptr past the last one allocated.
+	std::size_t size;				// Number of elements constructed.
+
+	// Default constructor
+	StableStorage();
+	// Destructor, destroys every element and frees every segment.
+	~StableStorage();
+	// Elements are referred to by address, so the container itself can be neither copied nor moved.
+	StableStorage(const StableStorage&) = delete;
+	StableStorage& operator=(const StableStorage&) = delete;
+
+	template <typename... Args>
+	T& Emplace(Args&&...);
+	T& operator[](std::size_t);
+	const T& operator[](std::size_t) const;
+	std::size_t Size() const;
+	void Clear();
+
+	Iterator begin() const;
+	Iterator end() const;
+
+	// Returns the segment that holds index, and writes the index inside that segment to offset.
+	static std::size_t Locate(std::size_t, std::size_t&);
+	// Returns the number of elements in segment.
+	static std::size_t SegmentSize(std::size_t);
+};
+
+// Stable storage for the two halves of the catalog.
+using BookStorage = StableStorage<Book>;
+using PersonStorage = StableStorage<Person, 16>;
+
+template <typename T, std::size_t FirstSegmentSize>
+inline std::size_t StableStorage<T, FirstSegmentSize>::SegmentSize(std::size_t segment) {
+	return FirstSegmentSize << segment;
+}
+
+template <typename T, std::size_t FirstSegmentSize>
+inline std::size_t StableStorage<T, FirstSegmentSize>::Locate(std::size_t index, std::size_t& offset) {
+	// Shifting the index by the first segment size makes segment k start at the power of two FirstSegmentSize << k.
+	std::size_t shifted = index + FirstSegmentSize;
+	std::size_t highBit = StorageHighestBit(shifted);
+	offset = shifted - (std::size_t(1) << highBit);
+	return highBit - StorageLog2(FirstSegmentSize);
+}
+
+// Default constructor
+template <typename T, std::size_t FirstSegmentSize>
+inline StableStorage<T, FirstSegmentSize>::StableStorage() {
+	for (std::size_t i = 0; i < MAX_SEGMENTS; ++i) {
+		this->segments[i] = nullptr;		// No segment is allocated until the first element is added.
+	}
+	this->size = 0;
+}
+
+// Destructor
+template <typename T, std::size_t FirstSegmentSize>
+inline StableStorage<T, FirstSegmentSize>::~StableStorage() {
+	this->Clear();
+}
+
+// Destroys every element and frees every segment.
+template <typename T, std::size_t FirstSegmentSize>
+inline void StableStorage<T, FirstSegmentSize>::Clear() {
+	for (T& element : *this) {
+		element.~T();
+	}
+	for (std::size_t i = 0; i < MAX_SEGMENTS && this->segments[i] != nullptr; ++i) {
+		::operator delete(this->segments[i], std::align_val_t(alignof(T)));
+		this->segments[i] = nullptr;
+	}
+	this->size = 0;
+}
+
+// Constructs a new element at the end and returns it. Amortized O(1), and no existing element moves.
+template <typename T, std::size_t FirstSegmentSize>
+template <typename... Args>
+inline T& StableStorage<T, FirstSegmentSize>::Emplace(Args&&... args) {
+	std::size_t offset = 0;
+	std::size_t segment = Locate(this->size, offset);
+	// Allocate the next segment when the index is the first one in it.
+	if (this->segments[segment] == nullptr) {
+		this->segments[segment] = static_cast<T*>(::operator new(SegmentSize(segment) * sizeof(T), std::align_val_t(alignof(T))));
+	}
+	T* element = new (this->segments[segment] + offset) T(std::forward<Args>(args)...);
+	++this->size;		// Only count the element once its constructor has returned.
+	return *element;
+}
+
+template <typename T, std::size_t FirstSegmentSize>
+inline T& StableStorage<T, FirstSegmentSize>::operator[](std::size_t index) {
+	std::size_t offset = 0;
+	std::size_t segment = Locate(index, offset);
+	return this->segments[segment][offset];
+}
+
+template <typename T, std::size_t FirstSegmentSize>
+inline const T& StableStorage<T, FirstSegmentSize>::operator[](std::size_t index) const {
+	std::size_t offset = 0;
+	std::size_t segment = Locate(index, offset);
+	return this->segments[segment][offset];
+}
+
+template <typename T, std::size_t FirstSegmentSize>
+inline std::size_t StableStorage<T, FirstSegmentSize>::Size() const {
+	return this->size;
+}
+
+template <typename T, std::size_t FirstSegmentSize>
+inline typename StableStorage<T, FirstSegmentSize>::Iterator StableStorage<T, FirstSegmentSize>::begin() const {
+	if (this->size == 0) {
+		return this->end();
+	}
+	std::size_t inFirst = this->size < FirstSegmentSize ? this->size : FirstSegmentSize;		// Elements in use in the first segment.
+	return Iterator{ this->segments, 0, this->segments[0], this->segments[0] + inFirst, this->size - inFirst };
+}
+
+template <typename T, std::size_t FirstSegmentSize>
+inline typename StableStorage<T, FirstSegmentSize>::Iterator StableStorage<T, FirstSegmentSize>::end() const {
+	return Iterator{ this->segments, 0, nullptr, nullptr, 0 };
+}
+
+// Moves to the next element, stepping into the next segment at the end of this one.
+template <typename T, std::size_t FirstSegmentSize>
+inline typename StableStorage<T, FirstSegmentSize>::Iterator& StableStorage<T, FirstSegmentSize>::Iterator::operator++() {
+	if (++this->current == this->segmentEnd) {
+		if (this->remaining == 0) {
+			this->current = nullptr;		// Match end().
+			this->segmentEnd = nullptr;
+		}
+		else {
+			++this->segment;
+			std::size_t inSegment = SegmentSize(this->segment);
+			if (inSegment > this->remaining) {
+				inSegment = this->remaining;
+			}
+			this->current = this->segments[this->segment];
+			this->segmentEnd = this->current + inSegment;
+			this->remaining -= inSegment;
+		}
+	}
+	return *this;
+}
+
+// Creates a book in the storage and adds it to its author's booksWritten with Person::AddBook.
+// The returned pointer, and the one stored in the author, stay valid while more books are added.
+inline Book* AddNewBook(BookStorage& books, Person* author, const std::string& title, std::uint32_t pages) {
+	Book* book = &books.Emplace(author, title, pages);
+	if (author) {
+		author->AddBook(book);
+	}
+	return book;
+}
@@ -0,0 +1,353 @@
+/****************************************************************
+* Author: Leo Carroll
+* Description:
+*	Optimistic transactions over several Persons at once, such as
+*	moving a book from one author to another, which changes the
+*	book's author, one Person's booksWritten and another's. A
+*	Transaction reads Persons into snapshots and queues changes,
+*	without holding any lock. Commit then locks the Persons it
+*	changes, checks that nothing it read has changed since, and
+*	applies every change, or none of them.
+*
+*	Persons are not changed for this. Their locks live in a side
+*	table of versioned locks, one word each, that Persons are
+*	hashed to by address. The low bit of a word is the lock, and
+*	the rest is a version that moves on with every commit that
+*	changes a Person of that stripe. Commit locks its stripes in
+*	index order, so two commits never wait on each other in a
+*	cycle, and commits on different stripes run in parallel.
+*	Two Persons can share a stripe, which only costs a needless
+*	retry now and then.
+*
+*	A Person's rollup and listener are shared between Persons,
+*	so Commit locks their stripes as well. Commits on Persons of
+*	one rollup therefore take turns on its stripe. Rollups and
+*	listeners must be set before Persons are shared between
+*	threads.
+*
+*	Every thread that touches a Person in the table, to read it
+*	too, must go through a Transaction.
+* Date Created: 2026-10-18
+* Date Modified: 2026-10-18
+****************************************************************/
+
+#pragma once
+
+#include <algorithm>		// Included for std::find, std::sort and std::unique.
+#include <atomic>			// Included for std::atomic.
+#include <cstddef>			// Included for std::size_t.
+#include <cstdint>			// Included for std::uint32_t, std::uint64_t and std::uintptr_t.
+#include <thread>			// Included for std::this_thread::yield.
+#include <utility>			// Included for std::pair.
+#include <vector>			// Included for std::vector.
+
+#include "Catalog.h"		// Included for Person and Book.
+
+// Number of versioned locks in a table, a power of two.
+constexpr std::size_t TRANSACTION_STRIPES = 4096;
+
+// Versioned locks for every Person, rollup and listener used in transactions.
+struct TransactionTable {
+	std::atomic<std::uint64_t> locks[TRANSACTION_STRIPES];		// Low bit set while locked, version in the rest.
+	std::atomic<std::size_t> commits{ 0 };						// Number of commits that succeeded.
+	std::atomic<std::size_t> aborts{ 0 };						// Number of commits that failed on a read that was out of date.
+	std::atomic<std::size_t> rejects{ 0 };						// Number of commits that failed on a change that could not be made.
+
+	// Default constructor
+	TransactionTable();
+	TransactionTable(const TransactionTable&) = delete;
+	TransactionTable& operator=(const TransactionTable&) = delete;
+
+	std::size_t Stripe(const void*) const;
+	std::uint64_t Lock(std::size_t);
+};
+
+// A Person's books and their page counts, as they were at one moment.
+struct TransactionSnapshot {
+	std::vector<Book*> books;				// The books, in order.
+	std::vector<std::uint32_t> pages;		// The page count of each book.
+};
+
+// The kinds of change a Transaction can queue.
+enum TransactionOpKind : std::uint8_t {
+	TRANSACTION_ADD_BOOK,
+	TRANSACTION_REMOVE_BOOK,
+	TRANSACTION_MOVE_BOOK,
+	TRANSACTION_SET_PAGES
+};
+
+// The outcome of a commit.
+enum TransactionResult : std::uint8_t {
+	TRANSACTION_COMMITTED,		// Every change was made.
+	TRANSACTION_CONFLICT,		// A read was out of date. Worth starting over.
+	TRANSACTION_INVALID			// A change could not be made, such as removing a book that is not listed. Starting over will not help.
+};
+
+// A queued change.
+struct TransactionOp {
+	TransactionOpKind kind;			// What to do.
+	Book* book;						// The book.
+	Person* from;					// The Person the book is on, or nullptr for TRANSACTION_ADD_BOOK.
+	Person* to;						// The Person the book goes to, or nullptr for TRANSACTION_REMOVE_BOOK and TRANSACTION_SET_PAGES.
+	std::uint32_t pages;			// The new page count, for TRANSACTION_SET_PAGES.
+};
+
+// A set of reads and changes that commit together. Use from one thread.
+struct Transaction {
+	TransactionTable& table;								// The locks.
+	std::vector<std::pair<std::size_t, std::uint64_t>> reads;		// Each stripe read, and its version then.
+	std::vector<TransactionOp> ops;							// The changes, in order.
+
+	// Custom constructor
+	explicit Transaction(TransactionTable&);
+
+	bool Read(const Person&, TransactionSnapshot&);
+	void AddBook(Person&, Book*);
+	void RemoveBook(Person&, Book*);
+	void MoveBook(Book*, Person&, Person&);
+	void SetPages(Person&, Book*, std::uint32_t);
+	TransactionResult Commit();
+	void Reset();
+
+	bool Simulate() const;
+	void Apply();
+};
+
+// TransactionTable default constructor
+inline TransactionTable::TransactionTable() {
+	for (std::atomic<std::uint64_t>& lock : this->locks) {
+		lock.store(0, std::memory_order_relaxed);
+	}
+}
+
+// Returns the stripe of an object.
+inline std::size_t TransactionTable::Stripe(const void* object) const {
+	// Multiplying by an odd constant and keeping the high bits mixes the address bits that differ between objects.
+	std::uint64_t hash = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(object)) * 0x9E3779B97F4A7C15ull;
+	return static_cast<std::size_t>(hash >> 40) & (TRANSACTION_STRIPES - 1);
+}
+
+// Waits for and takes the lock of a stripe. Returns the version it had.
+inline std::uint64_t TransactionTable::Lock(std::size_t stripe) {
+	std::uint64_t version = this->locks[stripe].load(std::memory_order_relaxed);
+	while (true) {
+		if ((version & 1) == 0 && this->locks[stripe].compare_exchange_weak(version, version | 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+			return version;
+		}
+		if (version & 1) {
+			std::this_thread::yield();		// Locks are only held for the few pointer writes of a commit.
+			version = this->locks[stripe].load(std::memory_order_relaxed);
+		}
+	}
+}
+
+// Transaction custom constructor
+inline Transaction::Transaction(TransactionTable& table) : table(table) {}
+
+// Copies the Person's books, and remembers the version copied, so that Commit fails if the Person has changed since.
+// The stripe is locked for the copy only, which is at most MAX_BOOKS_WRITTEN pointers. Returns false, and the transaction
+// should start over, if the Person has already changed since an earlier read in this transaction.
+inline bool Transaction::Read(const Person& person, TransactionSnapshot& snapshot) {
+	std::size_t stripe = this->table.Stripe(&person);
+	std::uint64_t version = this->table.Lock(stripe);
+	snapshot.books.clear();
+	snapshot.pages.clear();
+	for (std::size_t idx = 0; idx < MAX_BOOKS_WRITTEN && person.booksWritten[idx]; ++idx) {
+		snapshot.books.push_back(person.booksWritten[idx]);
+		snapshot.pages.push_back(person.booksWritten[idx]->numberOfPages);
+	}
+	this->table.locks[stripe].store(version, std::memory_order_release);		// Unchanged, so the version stays.
+	for (const std::pair<std::size_t, std::uint64_t>& read : this->reads) {
+		if (read.first == stripe && read.second != version) {
+			return false;
+		}
+	}
+	this->reads.push_back({ stripe, version });
+	return true;
+}
+
+// Queues a book to be added to the Person. The book must not be on any Person's list.
+inline void Transaction::AddBook(Person& person, Book* book) {
+	this->ops.push_back({ TRANSACTION_ADD_BOOK, book, nullptr, &person, 0 });
+}
+
+// Queues a book to be removed from the Person. The book's author is left as it is, as with Person::RemoveBook.
+inline void Transaction::RemoveBook(Person& person, Book* book) {
+	this->ops.push_back({ TRANSACTION_REMOVE_BOOK, book, &person, nullptr, 0 });
+}
+
+// Queues a book to be moved from one Person to the end of another's books, changing its author.
+inline void Transaction::MoveBook(Book* book, Person& from, Person& to) {
+	this->ops.push_back({ TRANSACTION_MOVE_BOOK, book, &from, &to, 0 });
+}
+
+// Queues a new page count for a book of the Person.
+inline void Transaction::SetPages(Person& person, Book* book, std::uint32_t pages) {
+	this->ops.push_back({ TRANSACTION_SET_PAGES, book, &person, nullptr, pages });
+}
+
+// Runs the queued changes on copies of the Persons' books and of the books' authors, and returns whether every one of
+// them would succeed: a book to remove or move is on its Person's list, a Person to add to has room, and a book whose
+// pages change is listed by its author as the earlier changes leave it. The stripes are locked.
+inline bool Transaction::Simulate() const {
+	std::vector<std::pair<const Person*, std::vector<Book*>>> copies;
+	std::vector<std::pair<const Book*, const Person*>> authors;		// The author of each book that a move changed.
+	auto copyOf = [&copies](const Person* person) -> std::vector<Book*>& {
+		for (std::pair<const Person*, std::vector<Book*>>& copy : copies) {
+			if (copy.first == person) {
+				return copy.second;
+			}
+		}
+		copies.push_back({ person, std::vector<Book*>() });
+		for (std::size_t idx = 0; idx < MAX_BOOKS_WRITTEN && person->booksWritten[idx]; ++idx) {
+			copies.back().second.push_back(person->booksWritten[idx]);
+		}
+		return copies.back().second;
+	};
+	auto authorOf = [&authors](const Book* book) -> const Person* {
+		// The last move of the book decides, so search from the back.
+		for (std::size_t i = authors.size(); i-- > 0;) {
+			if (authors[i].first == book) {
+				return authors[i].second;
+			}
+		}
+		return book->author;
+	};
+	for (const TransactionOp& op : this->ops) {
+		if (op.book == nullptr) {
+			return false;
+		}
+		if (op.from) {
+			std::vector<Book*>& books = copyOf(op.from);
+			std::vector<Book*>::iterator it = std::find(books.begin(), books.end(), op.book);
+			if (it == books.end()) {
+				return false;
+			}
+			if (op.kind == TRANSACTION_SET_PAGES && authorOf(op.book) != op.from) {
+				return false;		// Book::SetPages updates the totals of book->author, which may not be locked.
+			}
+			if (op.kind != TRANSACTION_SET_PAGES) {
+				books.erase(it);
+			}
+		}
+		if (op.to) {
+			std::vector<Book*>& books = copyOf(op.to);
+			if (books.size() >= MAX_BOOKS_WRITTEN) {
+				return false;
+			}
+			books.push_back(op.book);
+		}
+		if (op.kind == TRANSACTION_MOVE_BOOK) {
+			authors.push_back({ op.book, op.to });
+		}
+	}
+	return true;
+}
+
+// Makes the queued changes. Every one of them succeeds, as Simulate has checked. The stripes are locked.
+inline void Transaction::Apply() {
+	for (const TransactionOp& op : this->ops) {
+		switch (op.kind) {
+		case TRANSACTION_ADD_BOOK:
+			op.to->AddBook(op.book);
+			break;
+		case TRANSACTION_REMOVE_BOOK:
+			op.from->RemoveBook(op.book);
+			break;
+		case TRANSACTION_MOVE_BOOK:
+			op.from->RemoveBook(op.book);
+			op.book->author = op.to;
+			op.to->AddBook(op.book);
+			break;
+		case TRANSACTION_SET_PAGES:
+			op.book->SetPages(op.pages);
+			break;
+		}
+	}
+}
+
+// Locks the stripes of every Person changed, checks that every stripe read is unchanged, and applies the changes. Changes
+// nothing, and returns TRANSACTION_CONFLICT if a read is out of date or TRANSACTION_INVALID if a change would fail. Only
+// conflicts count as aborts. The transaction is reset either way.
+inline TransactionResult Transaction::Commit() {
+	std::vector<std::size_t> stripes;
+	for (const TransactionOp& op : this->ops) {
+		for (const Person* person : { op.from, op.to }) {
+			if (person) {
+				stripes.push_back(this->table.Stripe(person));
+				if (person->rollup) {
+					stripes.push_back(this->table.Stripe(person->rollup));
+				}
+				if (person->listener) {
+					stripes.push_back(this->table.Stripe(person->listener));
+				}
+			}
+		}
+	}
+	std::sort(stripes.begin(), stripes.end());
+	stripes.erase(std::unique(stripes.begin(), stripes.end()), stripes.end());
+	std::vector<std::uint64_t> versions(stripes.size());
+	for (std::size_t i = 0; i < stripes.size(); ++i) {
+		versions[i] = this->table.Lock(stripes[i]);
+	}
+	TransactionResult result = TRANSACTION_COMMITTED;
+	for (const std::pair<std::size_t, std::uint64_t>& read : this->reads) {
+		std::vector<std::size_t>::iterator it = std::lower_bound(stripes.begin(), stripes.end(), read.first);
+		// A stripe this commit holds was already read into versions. Any other stripe must not be locked, or changed.
+		std::uint64_t current = it != stripes.end() && *it == read.first ? versions[it - stripes.begin()] : this->table.locks[read.first].load(std::memory_order_acquire);
+		if (current != read.second) {
+			result = TRANSACTION_CONFLICT;
+			break;
+		}
+	}
+	// An out of date read may be why a change fails, so a change is only judged invalid against reads that are current.
+	if (result == TRANSACTION_COMMITTED && !this->Simulate()) {
+		result = TRANSACTION_INVALID;
+	}
+	if (result == TRANSACTION_COMMITTED) {
+		this->Apply();
+	}
+	for (std::size_t i = 0; i < stripes.size(); ++i) {
+		this->table.locks[stripes[i]].store(result == TRANSACTION_COMMITTED ? versions[i] + 2 : versions[i], std::memory_order_release);
+	}
+	switch (result) {
+	case TRANSACTION_COMMITTED:
+		this->table.commits.fetch_add(1, std::memory_order_relaxed);
+		break;
+	case TRANSACTION_CONFLICT:
+		this->table.aborts.fetch_add(1, std::memory_order_relaxed);
+		break;
+	case TRANSACTION_INVALID:
+		this->table.rejects.fetch_add(1, std::memory_order_relaxed);
+		break;
+	}
+	this->Reset();
+	return result;
+}
+
+// Forgets every read and queued change.
+inline void Transaction::Reset() {
+	this->reads.clear();
+	this->ops.clear();
+}
+
+// Runs body(transaction) and commits it, starting over while the commit conflicts, up to attempts times. body returns
+// false to give up without committing. An invalid commit is not retried. Returns whether a commit succeeded.
+template <typename Func>
+inline bool TransactionRun(TransactionTable& table, Func&& body, std::size_t attempts = 64) {
+	Transaction transaction(table);
+	for (std::size_t attempt = 0; attempt < attempts; ++attempt) {
+		if (!body(transaction)) {
+			transaction.Reset();
+			return false;
+		}
+		TransactionResult result = transaction.Commit();
+		if (result != TRANSACTION_CONFLICT) {
+			return result == TRANSACTION_COMMITTED;
+		}
+		if (attempt >= 4) {
+			std::this_thread::yield();		// Back off once retries keep failing, to let the other commit finish.
+		}
+	}
+	return false;
+}